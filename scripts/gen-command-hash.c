@@ -0,0 +1,60 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "command_spec.h"
+
+#define MAX_SEED_ATTEMPTS (1u << 24)
+
+static const char *command_names[] = {
+#define X(name, type, handler, prompt, completion, usage, help, summary) name,
+    ARCHIUM_COMMAND_SPEC(X)
+#undef X
+};
+
+#define COMMAND_COUNT (sizeof(command_names) / sizeof(command_names[0]))
+
+static int try_seed(unsigned int seed, signed char *slots) {
+  memset(slots, -1, ARCHIUM_COMMAND_HASH_SIZE);
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    unsigned int slot = archium_command_hash(
+        command_names[i], strlen(command_names[i]), seed);
+    if (slots[slot] != -1) {
+      return 0;
+    }
+    slots[slot] = (signed char)i;
+  }
+  return 1;
+}
+
+int main(void) {
+  signed char slots[ARCHIUM_COMMAND_HASH_SIZE];
+
+  if (COMMAND_COUNT > 127 || COMMAND_COUNT > ARCHIUM_COMMAND_HASH_SIZE) {
+    fprintf(stderr, "gen-command-hash: too many commands for table\n");
+    return 1;
+  }
+
+  unsigned int seed = 0;
+  while (!try_seed(seed, slots)) {
+    if (++seed == MAX_SEED_ATTEMPTS) {
+      fprintf(stderr,
+              "gen-command-hash: no perfect hash found, increase "
+              "ARCHIUM_COMMAND_HASH_SIZE\n");
+      return 1;
+    }
+  }
+
+  printf("#ifndef COMMAND_HASH_H\n");
+  printf("#define COMMAND_HASH_H\n\n");
+  printf("#define ARCHIUM_COMMAND_HASH_SEED %uu\n", seed);
+  printf("#define ARCHIUM_COMMAND_HASH_COUNT %zu\n\n", COMMAND_COUNT);
+  printf(
+      "static const signed char "
+      "archium_command_hash_slots[ARCHIUM_COMMAND_HASH_SIZE] = {");
+  for (size_t i = 0; i < ARCHIUM_COMMAND_HASH_SIZE; i++) {
+    printf("%s%d%s", i % 16 == 0 ? "\n    " : " ", slots[i],
+           i + 1 < ARCHIUM_COMMAND_HASH_SIZE ? "," : "");
+  }
+  printf("\n};\n\n#endif\n");
+  return 0;
+}
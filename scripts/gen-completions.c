@@ -0,0 +1,207 @@
+#include <stdio.h>
+#include <string.h>
+
+#include "command_spec.h"
+
+typedef struct {
+  const char *name;
+  const char *summary;
+} CommandRow;
+
+typedef struct {
+  const char *long_name;
+  const char *short_name;
+  const char *summary;
+} FlagRow;
+
+static const CommandRow commands[] = {
+#define X(name, type, handler, prompt, completion, usage, help, summary) \
+  {name, summary},
+    ARCHIUM_COMMAND_SPEC(X)
+#undef X
+};
+
+#define COMMAND_COUNT (sizeof(commands) / sizeof(commands[0]))
+
+static const FlagRow flags[] = {
+    {"help", "h", "Show help message"},
+    {"version", "v", "Show version information"},
+    {"verbose", "V", "Enable verbose logging"},
+    {"exec", NULL, "Execute command directly"},
+    {"script", NULL, "Run commands from a file"},
+    {"self-update", NULL, "Update Archium to latest version"},
+    {"no-completion-cache", NULL, "Skip building the completion cache"},
+    {"json", NULL, "Emit machine-readable output"},
+    {"batch", NULL, "Disable interactive prompts"},
+    {"custom-output", "c", "Use Archium custom output mode"},
+};
+
+#define FLAG_COUNT (sizeof(flags) / sizeof(flags[0]))
+
+static void print_single_quoted(const char *text) {
+  putchar('\'');
+  for (; *text; text++) {
+    if (*text == '\'') {
+      fputs("'\\''", stdout);
+    } else {
+      putchar(*text);
+    }
+  }
+  putchar('\'');
+}
+
+static void emit_bash(void) {
+  puts("#!/bin/bash");
+  puts("# Generated by scripts/gen-completions.c from ARCHIUM_COMMAND_SPEC.");
+  puts("");
+  puts("_archium() {");
+  puts("    local cur prev words cword");
+  puts("    _init_completion || return");
+  puts("");
+  fputs("    local flags=\"", stdout);
+  for (size_t i = 0; i < FLAG_COUNT; i++) {
+    printf("%s--%s", i > 0 ? " " : "", flags[i].long_name);
+    if (flags[i].short_name) {
+      printf(" -%s", flags[i].short_name);
+    }
+  }
+  puts("\"");
+  fputs("    local exec_commands=\"", stdout);
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    printf("%s%s", i > 0 ? " " : "", commands[i].name);
+  }
+  puts("\"");
+  puts("");
+  puts("    case $COMP_CWORD in");
+  puts("        1)");
+  puts("            COMPREPLY=($(compgen -W \"$flags\" -- \"$cur\"))");
+  puts("            ;;");
+  puts("        2)");
+  puts("            case \"$prev\" in");
+  puts("                --exec)");
+  puts("                    COMPREPLY=($(compgen -W \"$exec_commands -\" -- "
+       "\"$cur\"))");
+  puts("                    ;;");
+  puts("                --script)");
+  puts("                    _filedir");
+  puts("                    ;;");
+  puts("            esac");
+  puts("            ;;");
+  puts("    esac");
+  puts("");
+  puts("    return 0");
+  puts("}");
+  puts("");
+  puts("complete -F _archium archium");
+}
+
+static void emit_zsh(void) {
+  puts("#compdef archium");
+  puts("# Generated by scripts/gen-completions.c from ARCHIUM_COMMAND_SPEC.");
+  puts("");
+  puts("_archium() {");
+  puts("    local -a flags");
+  puts("    flags=(");
+  for (size_t i = 0; i < FLAG_COUNT; i++) {
+    char entry[256];
+    snprintf(entry, sizeof(entry), "--%s:%s", flags[i].long_name,
+             flags[i].summary);
+    fputs("        ", stdout);
+    print_single_quoted(entry);
+    putchar('\n');
+    if (flags[i].short_name) {
+      snprintf(entry, sizeof(entry), "-%s:%s", flags[i].short_name,
+               flags[i].summary);
+      fputs("        ", stdout);
+      print_single_quoted(entry);
+      putchar('\n');
+    }
+  }
+  puts("    )");
+  puts("");
+  puts("    local -a exec_commands");
+  puts("    exec_commands=(");
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    fputs("        '", stdout);
+    for (const char *c = commands[i].name; *c; c++) {
+      if (*c == ':') {
+        putchar('\\');
+      }
+      putchar(*c);
+    }
+    putchar(':');
+    for (const char *c = commands[i].summary; *c; c++) {
+      if (*c == '\'') {
+        fputs("'\\''", stdout);
+      } else {
+        putchar(*c);
+      }
+    }
+    puts("'");
+  }
+  puts("    )");
+  puts("");
+  puts("    if (( CURRENT == 2 )); then");
+  puts("        _describe 'flags' flags");
+  puts("    elif (( CURRENT == 3 )); then");
+  puts("        case \"$words[2]\" in");
+  puts("            --exec)");
+  puts("                _describe 'commands' exec_commands");
+  puts("                ;;");
+  puts("            --script)");
+  puts("                _files");
+  puts("                ;;");
+  puts("        esac");
+  puts("    fi");
+  puts("}");
+  puts("");
+  puts("compdef _archium archium");
+  puts("");
+  puts("# vim: ft=zsh");
+}
+
+static void emit_fish(void) {
+  puts("# Generated by scripts/gen-completions.c from ARCHIUM_COMMAND_SPEC.");
+  puts("complete -c archium -f");
+  for (size_t i = 0; i < FLAG_COUNT; i++) {
+    printf("complete -c archium -l %s", flags[i].long_name);
+    if (flags[i].short_name) {
+      printf(" -s %s", flags[i].short_name);
+    }
+    fputs(" -d ", stdout);
+    print_single_quoted(flags[i].summary);
+    if (strcmp(flags[i].long_name, "exec") == 0) {
+      fputs(" -x", stdout);
+    } else if (strcmp(flags[i].long_name, "script") == 0) {
+      fputs(" -r -F", stdout);
+    }
+    putchar('\n');
+  }
+  for (size_t i = 0; i < COMMAND_COUNT; i++) {
+    fputs("complete -c archium -n '__fish_seen_subcommand_from --exec' -a ",
+          stdout);
+    print_single_quoted(commands[i].name);
+    fputs(" -d ", stdout);
+    print_single_quoted(commands[i].summary);
+    putchar('\n');
+  }
+}
+
+int main(int argc, char *argv[]) {
+  if (argc != 2) {
+    fprintf(stderr, "usage: gen-completions bash|zsh|fish\n");
+    return 1;
+  }
+
+  if (strcmp(argv[1], "bash") == 0) {
+    emit_bash();
+  } else if (strcmp(argv[1], "zsh") == 0) {
+    emit_zsh();
+  } else if (strcmp(argv[1], "fish") == 0) {
+    emit_fish();
+  } else {
+    fprintf(stderr, "gen-completions: unknown shell '%s'\n", argv[1]);
+    return 1;
+  }
+  return 0;
+}
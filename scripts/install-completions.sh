@@ -206,6 +206,7 @@ list_completions() {
 main() {
     if [[ ! -d "$COMPLETIONS_DIR" ]]; then
         print_error "Completions directory not found: $COMPLETIONS_DIR"
+        print_status "Run 'make completions' to generate the completion scripts"
         exit 1
     fi
 
@@ -0,0 +1,104 @@
+#include <stdalign.h>
+
+#include "include/archium.h"
+
+#define ARENA_ALIGNMENT alignof(max_align_t)
+#define ARENA_ALIGN(n) (((n) + ARENA_ALIGNMENT - 1) & ~(ARENA_ALIGNMENT - 1))
+
+struct ArchiumArenaChunk {
+  struct ArchiumArenaChunk *next;
+  size_t size;
+  size_t used;
+};
+
+#define ARENA_HEADER_SIZE ARENA_ALIGN(sizeof(ArchiumArenaChunk))
+
+static unsigned char *chunk_data(ArchiumArenaChunk *chunk) {
+  return (unsigned char *)chunk + ARENA_HEADER_SIZE;
+}
+
+void archium_arena_init(ArchiumArena *arena, size_t initial_size) {
+  arena->head = NULL;
+  arena->next_size = initial_size ? initial_size : ARCHIUM_ARENA_DEFAULT_CHUNK;
+}
+
+void *archium_arena_alloc(ArchiumArena *arena, size_t size) {
+  if (!arena) {
+    return NULL;
+  }
+
+  size = ARENA_ALIGN(size ? size : 1);
+  ArchiumArenaChunk *chunk = arena->head;
+  if (!chunk || chunk->size - chunk->used < size) {
+    size_t chunk_size =
+        arena->next_size ? arena->next_size : ARCHIUM_ARENA_DEFAULT_CHUNK;
+    while (chunk_size < size) {
+      chunk_size *= 2;
+    }
+
+    chunk = malloc(ARENA_HEADER_SIZE + chunk_size);
+    if (!chunk) {
+      return NULL;
+    }
+    chunk->next = arena->head;
+    chunk->size = chunk_size;
+    chunk->used = 0;
+    arena->head = chunk;
+    arena->next_size = chunk_size * 2;
+  }
+
+  void *result = chunk_data(chunk) + chunk->used;
+  chunk->used += size;
+  return result;
+}
+
+void *archium_arena_grow(ArchiumArena *arena, void *old, size_t old_size,
+                         size_t new_size) {
+  if (!old) {
+    return archium_arena_alloc(arena, new_size);
+  }
+  if (new_size <= old_size) {
+    return old;
+  }
+
+  ArchiumArenaChunk *chunk = arena->head;
+  size_t old_aligned = ARENA_ALIGN(old_size ? old_size : 1);
+  size_t new_aligned = ARENA_ALIGN(new_size);
+  if (chunk && (unsigned char *)old + old_aligned ==
+                   chunk_data(chunk) + chunk->used &&
+      chunk->size - chunk->used >= new_aligned - old_aligned) {
+    chunk->used += new_aligned - old_aligned;
+    return old;
+  }
+
+  void *result = archium_arena_alloc(arena, new_size);
+  if (result) {
+    memcpy(result, old, old_size);
+  }
+  return result;
+}
+
+char *archium_arena_strndup(ArchiumArena *arena, const char *s,
+                            size_t length) {
+  char *copy = archium_arena_alloc(arena, length + 1);
+  if (!copy) {
+    return NULL;
+  }
+  memcpy(copy, s, length);
+  copy[length] = '\0';
+  return copy;
+}
+
+void archium_arena_free(ArchiumArena *arena) {
+  if (!arena) {
+    return;
+  }
+
+  ArchiumArenaChunk *chunk = arena->head;
+  while (chunk) {
+    ArchiumArenaChunk *next = chunk->next;
+    free(chunk);
+    chunk = next;
+  }
+  arena->head = NULL;
+}
@@ -1,16 +1,50 @@
-#include "include/archium.h"
+#include <dirent.h>
+#include <pthread.h>
 
-#define PACKAGE_CACHE_FILE "packages.cache"
+#include "include/archium.h"
 
-static void free_command_cache(char **commands, int count) {
-  if (!commands) {
-    return;
+#define PACKAGE_INDEX_FILE "packages.idx"
+#define LEGACY_PACKAGE_CACHE_FILE "packages.cache"
+
+#define COMPLETION_WAIT_MS 1500
+
+typedef enum {
+  WARMUP_IDLE,
+  WARMUP_RUNNING,
+  WARMUP_DONE,
+} WarmupState;
+
+static ArchiumPackageIndex package_index;
+static int package_index_loaded = 0;
+static int index_shutdown = 0;
+static WarmupState warmup_state = WARMUP_IDLE;
+static pthread_mutex_t index_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t index_ready = PTHREAD_COND_INITIALIZER;
+
+typedef struct {
+  ArchiumArena strings;
+  char **names;
+  size_t count;
+  size_t capacity;
+  struct timespec source_mtime;
+  int loaded;
+} CompletionSet;
+
+static CompletionSet command_set;
+static CompletionSet installed_set;
+static CompletionSet cached_set;
+static CompletionSource prompt_source = COMPLETION_AUTO;
+static CompletionSource active_source = COMPLETION_AUTO;
+static ArchiumFuzzyResults fuzzy_results;
+static int fuzzy_active = 0;
+
+static int build_cache_path(char *out, size_t out_size, const char *file) {
+  const char *cache_dir = archium_config_get_cache_dir();
+  if (!cache_dir) {
+    return 0;
   }
 
-  for (int i = 0; i < count; i++) {
-    free(commands[i]);
-  }
-  free(commands);
+  return snprintf(out, out_size, "%s/%s", cache_dir, file) < (int)out_size;
 }
 
 static int is_cache_valid(const char *cache_path) {
@@ -23,209 +57,635 @@ static int is_cache_valid(const char *cache_path) {
   return (now - cache_stat.st_mtime) < config.cache_ttl_seconds;
 }
 
-static void load_cache_from_file(const char *cache_path) {
-  FILE *fp = fopen(cache_path, "r");
+static void add_line_to_builder(ArchiumIndexBuilder *builder, char *line,
+                                size_t size) {
+  size_t len = strcspn(line, "\n");
+  if (len >= size) {
+    len = size - 1;
+  }
+  line[len] = '\0';
+  if (len > 0) {
+    archium_index_builder_add(builder, line, len);
+  }
+}
+
+static int migrate_legacy_cache(const char *legacy_path,
+                                const char *index_path) {
+  if (!is_cache_valid(legacy_path)) {
+    unlink(legacy_path);
+    return 0;
+  }
+
+  FILE *fp = fopen(legacy_path, "r");
   if (!fp) {
-    return;
+    return 0;
   }
 
+  ArchiumIndexBuilder builder;
+  archium_index_builder_init(&builder);
+
   char line[SMALL_BUFFER_SIZE];
-  int command_count = 0;
+  while (fgets(line, sizeof(line), fp) != NULL) {
+    add_line_to_builder(&builder, line, sizeof(line));
+  }
+  fclose(fp);
+
+  int written = builder.count > 0 &&
+                archium_index_builder_write(&builder, index_path);
+  archium_index_builder_free(&builder);
+
+  unlink(legacy_path);
+  if (written) {
+    log_debug("Migrated text package cache to binary index");
+  }
+  return written;
+}
+
+static int add_name_to_builder(const char *name, size_t length,
+                               void *user_data) {
+  archium_index_builder_add(user_data, name, length);
+  return 1;
+}
+
+static int read_names_from_pacman(ArchiumIndexBuilder *builder) {
+  FILE *fp = popen("pacman -Ssq", "r");
+  if (fp == NULL) {
+    fputs("\033[1;31mFailed to run command\033[0m\n", stderr);
+    return 0;
+  }
 
+  char line[1035];
   while (fgets(line, sizeof(line), fp) != NULL) {
-    size_t len = strcspn(line, "\n");
-    if (len < sizeof(line)) {
-      line[len] = 0;
-    } else {
-      line[sizeof(line) - 1] = 0;
+    add_line_to_builder(builder, line, sizeof(line));
+  }
+  pclose(fp);
+  return 1;
+}
+
+static int copy_repo_names(ArchiumIndexBuilder *builder,
+                           const ArchiumPackageIndex *previous,
+                           const ArchiumIndexRepo *repo) {
+  for (uint32_t i = 0; i < repo->count; i++) {
+    const char *name = archium_index_repo_name(previous, repo, i);
+    if (name && !archium_index_builder_add(builder, name, strlen(name))) {
+      return 0;
     }
-    if (strlen(line) == 0) continue;
-
-    command_count++;
-    char **new_commands =
-        realloc(cached_commands, sizeof(char *) * (command_count + 1));
-    if (!new_commands) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      fclose(fp);
-      return;
+  }
+  return 1;
+}
+
+static int read_names_from_sync_dbs(ArchiumIndexBuilder *builder,
+                                    const ArchiumPackageIndex *previous) {
+  struct stat dir_stat;
+  if (stat(ARCHIUM_SYNC_DB_DIR, &dir_stat) != 0) {
+    return 0;
+  }
+
+  DIR *dir = opendir(ARCHIUM_SYNC_DB_DIR);
+  if (!dir) {
+    return 0;
+  }
+
+  archium_index_builder_set_source(builder, &dir_stat);
+
+  int databases = 0;
+  int reused = 0;
+  int failed = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (!archium_syncdb_is_db_file(entry->d_name)) {
+      continue;
     }
-    cached_commands = new_commands;
-    cached_commands[command_count - 1] = strdup(line);
-    if (!cached_commands[command_count - 1]) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      fclose(fp);
-      return;
+
+    char db_path[MEDIUM_BUFFER_SIZE];
+    struct stat db_stat;
+    if (snprintf(db_path, sizeof(db_path), "%s/%s", ARCHIUM_SYNC_DB_DIR,
+                 entry->d_name) >= (int)sizeof(db_path) ||
+        stat(db_path, &db_stat) != 0 ||
+        !archium_index_builder_begin_repo(builder, entry->d_name, &db_stat)) {
+      continue;
+    }
+
+    databases++;
+    const ArchiumIndexRepo *repo =
+        archium_index_find_repo(previous, entry->d_name);
+    if (archium_index_repo_matches(repo, &db_stat) &&
+        copy_repo_names(builder, previous, repo)) {
+      reused++;
+      continue;
+    }
+
+    if (!archium_syncdb_read_names(db_path, add_name_to_builder, builder)) {
+      failed = 1;
+      break;
     }
   }
+  closedir(dir);
 
-  fclose(fp);
+  if (failed) {
+    log_debug("Sync database unreadable, falling back to pacman -Ssq");
+    return 0;
+  }
 
-  const char *custom_cmds[] = {"check", "info", "s"};
-  for (int i = 0; i < 3; i++) {
-    command_count++;
-    char **new_commands =
-        realloc(cached_commands, sizeof(char *) * (command_count + 1));
-    if (!new_commands) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      return;
+  if (databases > 0 && config.verbose) {
+    char message[SMALL_BUFFER_SIZE];
+    snprintf(message, sizeof(message),
+             "Indexed %d sync databases (%d reused from cache)", databases,
+             reused);
+    log_debug(message);
+  }
+  return databases;
+}
+
+static int generate_package_index(const char *index_path,
+                                  const ArchiumPackageIndex *previous) {
+  ArchiumIndexBuilder builder;
+  archium_index_builder_init(&builder);
+
+  if (read_names_from_sync_dbs(&builder, previous) == 0) {
+    archium_index_builder_free(&builder);
+    if (!read_names_from_pacman(&builder)) {
+      archium_index_builder_free(&builder);
+      return 0;
     }
-    cached_commands = new_commands;
-    cached_commands[command_count - 1] = strdup(custom_cmds[i]);
-    if (!cached_commands[command_count - 1]) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      return;
+  }
+
+  int written = archium_index_builder_write(&builder, index_path);
+  archium_index_builder_free(&builder);
+  return written;
+}
+
+static int is_index_fresh(const ArchiumPackageIndex *index,
+                          const char *index_path) {
+  if (index->repo_count == 0) {
+    return is_cache_valid(index_path);
+  }
+
+  struct stat dir_stat;
+  if (stat(ARCHIUM_SYNC_DB_DIR, &dir_stat) != 0 ||
+      !archium_index_source_matches(index, &dir_stat)) {
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < index->repo_count; i++) {
+    char db_path[MEDIUM_BUFFER_SIZE];
+    struct stat db_stat;
+    if (snprintf(db_path, sizeof(db_path), "%s/%.*s", ARCHIUM_SYNC_DB_DIR,
+                 ARCHIUM_INDEX_REPO_NAME_MAX, index->repos[i].name) >=
+            (int)sizeof(db_path) ||
+        stat(db_path, &db_stat) != 0 ||
+        !archium_index_repo_matches(&index->repos[i], &db_stat)) {
+      return 0;
     }
   }
 
-  if (cached_commands) {
-    cached_commands[command_count] = NULL;
+  return 1;
+}
+
+static int load_package_index(ArchiumPackageIndex *index) {
+  char index_path[MEDIUM_BUFFER_SIZE];
+  char legacy_path[MEDIUM_BUFFER_SIZE];
+  if (!build_cache_path(index_path, sizeof(index_path), PACKAGE_INDEX_FILE) ||
+      !build_cache_path(legacy_path, sizeof(legacy_path),
+                        LEGACY_PACKAGE_CACHE_FILE)) {
+    fputs("\033[1;31mError: Failed to get cache directory.\033[0m\n", stderr);
+    return 0;
+  }
+
+  ArchiumPackageIndex previous;
+  int have_previous = archium_index_open(&previous, index_path);
+  if (have_previous && is_index_fresh(&previous, index_path)) {
+    *index = previous;
+    log_debug("Loaded package list from cache");
+    return 1;
+  }
+
+  if (!have_previous && access(legacy_path, F_OK) == 0 &&
+      migrate_legacy_cache(legacy_path, index_path) &&
+      archium_index_open(index, index_path)) {
+    return 1;
+  }
+
+  int generated =
+      generate_package_index(index_path, have_previous ? &previous : NULL);
+  if (have_previous) {
+    archium_index_close(&previous);
   }
+
+  if (!generated || !archium_index_open(index, index_path)) {
+    log_debug("Failed to generate package index");
+    return 0;
+  }
+
+  log_debug("Generated and cached package list");
+  return 1;
 }
 
-static void save_cache_to_file(const char *cache_path) {
-  FILE *fp = fopen(cache_path, "w");
-  if (!fp) {
-    return;
+static void publish_package_index(ArchiumPackageIndex *index, int loaded) {
+  pthread_mutex_lock(&index_mutex);
+  if (loaded && !package_index_loaded && !index_shutdown) {
+    package_index = *index;
+    package_index_loaded = 1;
+    loaded = 0;
   }
+  warmup_state = WARMUP_DONE;
+  pthread_cond_broadcast(&index_ready);
+  pthread_mutex_unlock(&index_mutex);
 
-  for (int i = 0; cached_commands && cached_commands[i] != NULL; i++) {
-    if (strcmp(cached_commands[i], "check") != 0 &&
-        strcmp(cached_commands[i], "info") != 0 &&
-        strcmp(cached_commands[i], "s") != 0) {
-      fputs(cached_commands[i], fp);
-      fputc('\n', fp);
-    }
+  if (loaded) {
+    archium_index_close(index);
   }
+}
 
-  fclose(fp);
+static void *completion_warmup_thread(void *arg) {
+  (void)arg;
+
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  ArchiumPackageIndex index;
+  int loaded = load_package_index(&index);
+  publish_package_index(&index, loaded);
+  return NULL;
 }
 
-void cache_pacman_commands(void) {
-  if (cached_commands) {
+static int wait_for_package_index(int timeout_ms) {
+  struct timespec deadline;
+  clock_gettime(CLOCK_REALTIME, &deadline);
+  deadline.tv_sec += timeout_ms / 1000;
+  deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+  if (deadline.tv_nsec >= 1000000000L) {
+    deadline.tv_sec++;
+    deadline.tv_nsec -= 1000000000L;
+  }
+
+  pthread_mutex_lock(&index_mutex);
+  while (warmup_state == WARMUP_RUNNING && !package_index_loaded) {
+    if (timeout_ms < 0) {
+      pthread_cond_wait(&index_ready, &index_mutex);
+    } else if (pthread_cond_timedwait(&index_ready, &index_mutex,
+                                      &deadline) != 0) {
+      break;
+    }
+  }
+  int loaded = package_index_loaded;
+  pthread_mutex_unlock(&index_mutex);
+  return loaded;
+}
+
+void start_completion_warmup(void) {
+  if (config.no_completion_cache) {
     return;
   }
 
-  const char *cache_dir = archium_config_get_cache_dir();
-  if (!cache_dir) {
-    fputs("\033[1;31mError: Failed to get cache directory.\033[0m\n", stderr);
+  pthread_mutex_lock(&index_mutex);
+  if (warmup_state == WARMUP_RUNNING || package_index_loaded) {
+    pthread_mutex_unlock(&index_mutex);
+    return;
+  }
+  warmup_state = WARMUP_RUNNING;
+  pthread_mutex_unlock(&index_mutex);
+
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, completion_warmup_thread, NULL) != 0) {
+    pthread_mutex_lock(&index_mutex);
+    warmup_state = WARMUP_IDLE;
+    pthread_mutex_unlock(&index_mutex);
+    log_debug("Failed to start completion warm-up thread");
     return;
   }
+  pthread_detach(thread);
+}
 
-  char cache_path[MEDIUM_BUFFER_SIZE];
-  size_t cache_dir_len = strlen(cache_dir);
-  size_t file_len = strlen(PACKAGE_CACHE_FILE);
-  if (cache_dir_len + file_len + 2 > sizeof(cache_path)) {
-    fputs("\033[1;31mError: Cache path too long.\033[0m\n", stderr);
+void cache_pacman_commands(void) {
+  if (config.no_completion_cache) {
     return;
   }
 
-  char *dst = cache_path;
-  const char *src = cache_dir;
-  for (size_t i = 0; i < cache_dir_len; i++) {
-    *dst++ = *src++;
+  pthread_mutex_lock(&index_mutex);
+  if (package_index_loaded) {
+    pthread_mutex_unlock(&index_mutex);
+    return;
   }
-  *dst++ = '/';
-  src = PACKAGE_CACHE_FILE;
-  for (size_t i = 0; i <= file_len; i++) {
-    *dst++ = *src++;
+  if (warmup_state == WARMUP_RUNNING) {
+    pthread_mutex_unlock(&index_mutex);
+    wait_for_package_index(-1);
+    return;
   }
+  warmup_state = WARMUP_RUNNING;
+  pthread_mutex_unlock(&index_mutex);
 
-  if (is_cache_valid(cache_path)) {
-    load_cache_from_file(cache_path);
-    if (cached_commands) {
-      log_debug("Loaded package list from cache");
-      return;
+  ArchiumPackageIndex index;
+  int loaded = load_package_index(&index);
+  publish_package_index(&index, loaded);
+}
+
+static void completion_set_free(CompletionSet *set) {
+  archium_arena_free(&set->strings);
+  free(set->names);
+  memset(set, 0, sizeof(*set));
+}
+
+static int completion_set_add(CompletionSet *set, const char *name,
+                              size_t length) {
+  if (length == 0) {
+    return 1;
+  }
+
+  if (set->count == set->capacity) {
+    size_t capacity = set->capacity ? set->capacity * 2 : 256;
+    char **names = realloc(set->names, capacity * sizeof(char *));
+    if (!names) {
+      return 0;
     }
+    set->names = names;
+    set->capacity = capacity;
   }
 
-  FILE *fp;
-  char path[1035];
-  int command_count = 0;
+  char *copy = archium_arena_strndup(&set->strings, name, length);
+  if (!copy) {
+    return 0;
+  }
+  set->names[set->count++] = copy;
+  return 1;
+}
 
-  fp = popen("pacman -Ssq", "r");
-  if (fp == NULL) {
-    fputs("\033[1;31mFailed to run command\033[0m\n", stderr);
-    return;
+static int compare_names(const void *a, const void *b) {
+  return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+static void completion_set_finish(CompletionSet *set) {
+  if (set->count > 1) {
+    qsort(set->names, set->count, sizeof(char *), compare_names);
   }
 
-  while (fgets(path, sizeof(path), fp) != NULL) {
-    size_t len = strcspn(path, "\n");
-    if (len < sizeof(path)) {
-      path[len] = 0;
+  size_t unique = 0;
+  for (size_t i = 0; i < set->count; i++) {
+    if (unique > 0 && strcmp(set->names[unique - 1], set->names[i]) == 0) {
+      continue;
+    }
+    set->names[unique++] = set->names[i];
+  }
+  set->count = unique;
+  set->loaded = 1;
+}
+
+static size_t completion_set_prefix_range(const CompletionSet *set,
+                                          const char *prefix, size_t length,
+                                          size_t *first) {
+  size_t low = 0;
+  size_t high = set->count;
+  while (low < high) {
+    size_t mid = low + (high - low) / 2;
+    if (strncmp(set->names[mid], prefix, length) < 0) {
+      low = mid + 1;
     } else {
-      path[sizeof(path) - 1] = 0;
+      high = mid;
     }
-    command_count++;
-    char **new_commands =
-        realloc(cached_commands, sizeof(char *) * (command_count + 1));
-    if (!new_commands) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      pclose(fp);
-      return;
+  }
+
+  size_t end = low;
+  while (end < set->count && strncmp(set->names[end], prefix, length) == 0) {
+    end++;
+  }
+
+  *first = low;
+  return end - low;
+}
+
+static size_t strip_version_fields(const char *name, size_t length,
+                                   int fields) {
+  while (fields-- > 0) {
+    while (length > 0 && name[length - 1] != '-') {
+      length--;
     }
-    cached_commands = new_commands;
-    cached_commands[command_count - 1] = strdup(path);
-    if (!cached_commands[command_count - 1]) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      pclose(fp);
-      return;
+    if (length == 0) {
+      return 0;
     }
+    length--;
   }
+  return length;
+}
 
-  pclose(fp);
+static size_t cached_package_name_length(const char *filename) {
+  const char *suffix = strstr(filename, ".pkg.tar");
+  if (!suffix || strstr(suffix, ".sig")) {
+    return 0;
+  }
+  return strip_version_fields(filename, (size_t)(suffix - filename), 3);
+}
 
-  const char *custom_cmds[] = {"check", "info", "s"};
-  for (int i = 0; i < 3; i++) {
-    command_count++;
-    char **new_commands =
-        realloc(cached_commands, sizeof(char *) * (command_count + 1));
-    if (!new_commands) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      return;
+static size_t installed_package_name_length(const char *dirname) {
+  return strip_version_fields(dirname, strlen(dirname), 2);
+}
+
+static int directory_unchanged(const CompletionSet *set,
+                               const struct stat *dir_stat) {
+  return set->loaded &&
+         set->source_mtime.tv_sec == dir_stat->st_mtim.tv_sec &&
+         set->source_mtime.tv_nsec == dir_stat->st_mtim.tv_nsec;
+}
+
+static const CompletionSet *load_directory_set(CompletionSet *set,
+                                               const char *path,
+                                               size_t (*name_length)(
+                                                   const char *)) {
+  struct stat dir_stat;
+  if (stat(path, &dir_stat) != 0) {
+    return NULL;
+  }
+  if (directory_unchanged(set, &dir_stat)) {
+    return set;
+  }
+
+  DIR *dir = opendir(path);
+  if (!dir) {
+    return NULL;
+  }
+
+  completion_set_free(set);
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.') {
+      continue;
     }
-    cached_commands = new_commands;
-    cached_commands[command_count - 1] = strdup(custom_cmds[i]);
-    if (!cached_commands[command_count - 1]) {
-      free_command_cache(cached_commands, command_count - 1);
-      cached_commands = NULL;
-      return;
+    size_t length = name_length(entry->d_name);
+    if (!completion_set_add(set, entry->d_name, length)) {
+      break;
     }
   }
+  closedir(dir);
 
-  if (cached_commands) {
-    cached_commands[command_count] = NULL;
+  completion_set_finish(set);
+  set->source_mtime = dir_stat.st_mtim;
+  return set;
+}
+
+static const CompletionSet *load_command_set(void) {
+  if (command_set.loaded) {
+    return &command_set;
   }
 
-  save_cache_to_file(cache_path);
-  log_debug("Generated and cached package list");
+  const char *name;
+  for (size_t i = 0; (name = get_valid_command(i)) != NULL; i++) {
+    completion_set_add(&command_set, name, strlen(name));
+  }
+  for (int i = 0; (name = archium_plugin_command_at(i)) != NULL; i++) {
+    completion_set_add(&command_set, name, strlen(name));
+  }
+  completion_set_finish(&command_set);
+  return &command_set;
 }
 
-char *command_generator(const char *text, int state) {
-  static int list_index, len;
-
-  if (!cached_commands) {
-    cache_pacman_commands();
-    if (!cached_commands) {
+static const CompletionSet *load_completion_set(CompletionSource source) {
+  switch (source) {
+    case COMPLETION_COMMANDS:
+      return load_command_set();
+    case COMPLETION_INSTALLED:
+      return load_directory_set(&installed_set, ARCHIUM_LOCAL_DB_DIR,
+                                installed_package_name_length);
+    case COMPLETION_CACHED:
+      return load_directory_set(&cached_set, ARCHIUM_PKG_CACHE_DIR,
+                                cached_package_name_length);
+    default:
       return NULL;
+  }
+}
+
+static int ensure_sync_index(void) {
+  if (config.no_completion_cache) {
+    return 0;
+  }
+
+  if (wait_for_package_index(COMPLETION_WAIT_MS)) {
+    return 1;
+  }
+
+  pthread_mutex_lock(&index_mutex);
+  int running = warmup_state == WARMUP_RUNNING;
+  pthread_mutex_unlock(&index_mutex);
+  if (running) {
+    return 0;
+  }
+
+  cache_pacman_commands();
+  return wait_for_package_index(0);
+}
+
+CompletionSource completion_source_for_command(const char *command) {
+  if (!command || *command == '\0') {
+    return COMPLETION_COMMANDS;
+  }
+
+  int index = builtin_command_index(command);
+  if (index >= 0) {
+    return builtin_command_completion(index);
+  }
+  if (archium_plugin_is_plugin_command(command)) {
+    return COMPLETION_SYNC;
+  }
+  return COMPLETION_NONE;
+}
+
+void set_completion_source(CompletionSource source) {
+  prompt_source = source;
+}
+
+/*
+ * The command being completed starts after the last ';' or '&&' before the
+ * cursor, so "i foo; r <TAB>" completes from r's source rather than i's.
+ */
+static CompletionSource completion_source_for_line(int start) {
+  const char *line = rl_line_buffer ? rl_line_buffer : "";
+  int token_start = start;
+  while (token_start > 0 && line[token_start - 1] != ';' &&
+         !(token_start > 1 && line[token_start - 1] == '&' &&
+           line[token_start - 2] == '&')) {
+    token_start--;
+  }
+  while (line[token_start] == ' ') {
+    token_start++;
+  }
+  if (start <= token_start) {
+    return COMPLETION_COMMANDS;
+  }
+
+  char command[MAX_INPUT_LENGTH];
+  size_t length = strcspn(line + token_start, " ");
+  if (length >= sizeof(command)) {
+    return COMPLETION_NONE;
+  }
+  memcpy(command, line + token_start, length);
+  command[length] = '\0';
+  return completion_source_for_command(command);
+}
+
+static void collect_fuzzy_matches(const CompletionSet *set, const char *text,
+                                  size_t len) {
+  memset(&fuzzy_results, 0, sizeof(fuzzy_results));
+  if (set) {
+    for (size_t i = 0; i < set->count; i++) {
+      archium_fuzzy_add(&fuzzy_results, set->names[i], strlen(set->names[i]),
+                        text, len);
     }
+  } else {
+    archium_fuzzy_search_blob(&fuzzy_results, package_index.blob,
+                              package_index.blob_size, text, len);
   }
+}
+
+char *command_generator(const char *text, int state) {
+  static const CompletionSet *set;
+  static size_t list_index;
+  static size_t list_end;
 
   if (!state) {
+    set = NULL;
     list_index = 0;
-    len = strlen(text);
+    list_end = 0;
+    fuzzy_active = 0;
+    size_t len = strlen(text);
+
+    if (active_source == COMPLETION_SYNC) {
+      if (!ensure_sync_index()) {
+        return NULL;
+      }
+      uint32_t first = 0;
+      uint32_t matches =
+          archium_index_prefix_range(&package_index, text, len, &first);
+      list_index = first;
+      list_end = (size_t)first + matches;
+    } else {
+      set = load_completion_set(active_source);
+      if (!set) {
+        return NULL;
+      }
+      list_end = list_index +
+                 completion_set_prefix_range(set, text, len, &list_index);
+    }
+
+    if (list_index == list_end && len > 0 && config.fuzzy_completion) {
+      collect_fuzzy_matches(set, text, len);
+      fuzzy_active = 1;
+      list_index = 0;
+      list_end = fuzzy_results.count;
+    }
   }
 
-  for (int i = list_index; cached_commands[i] != NULL; i++) {
-    const char *name = cached_commands[i];
-    if (strncmp(name, text, len) == 0) {
-      list_index = i + 1;
+  if (fuzzy_active) {
+    if (list_index < list_end) {
+      const ArchiumFuzzyMatch *match = &fuzzy_results.matches[list_index++];
+      return strndup(match->name, match->length);
+    }
+    return NULL;
+  }
+
+  while (list_index < list_end) {
+    const char *name =
+        set ? set->names[list_index++]
+            : archium_index_name(&package_index, (uint32_t)list_index++);
+    if (name) {
       return strdup(name);
     }
   }
@@ -234,46 +694,73 @@ char *command_generator(const char *text, int state) {
 }
 
 char **command_completion(const char *text, int start, int end) {
-  (void)start;
   (void)end;
   rl_attempted_completion_over = 1;
-  return rl_completion_matches(text, command_generator);
+  rl_sort_completion_matches = 1;
+
+  CompletionSource source = prompt_source != COMPLETION_AUTO
+                                ? prompt_source
+                                : completion_source_for_line(start);
+  if (source == COMPLETION_NONE) {
+    return NULL;
+  }
+  if (source == COMPLETION_FILES) {
+    return rl_completion_matches(text, rl_filename_completion_function);
+  }
+
+  active_source = source;
+  char **matches = rl_completion_matches(text, command_generator);
+  if (fuzzy_active && matches) {
+    rl_sort_completion_matches = 0;
+    if (matches[1]) {
+      char *original = strdup(text);
+      if (original) {
+        free(matches[0]);
+        matches[0] = original;
+      }
+    }
+  }
+  return matches;
 }
 
 void invalidate_package_cache(void) {
-  const char *cache_dir = archium_config_get_cache_dir();
-  if (!cache_dir) {
-    return;
+  char index_path[MEDIUM_BUFFER_SIZE];
+  char snapshot_path[MEDIUM_BUFFER_SIZE];
+  if (build_cache_path(snapshot_path, sizeof(snapshot_path),
+                       ARCHIUM_LOCALDB_SNAPSHOT_FILE)) {
+    unlink(snapshot_path);
   }
 
-  size_t cache_dir_len = strlen(cache_dir);
-  size_t file_len = strlen(PACKAGE_CACHE_FILE);
-  char cache_path[MEDIUM_BUFFER_SIZE];
-  if (cache_dir_len + file_len + 2 > sizeof(cache_path)) {
+  if (!build_cache_path(index_path, sizeof(index_path), PACKAGE_INDEX_FILE)) {
     return;
   }
 
-  char *dst = cache_path;
-  const char *src = cache_dir;
-  for (size_t i = 0; i < cache_dir_len; i++) {
-    *dst++ = *src++;
-  }
-  *dst++ = '/';
-  src = PACKAGE_CACHE_FILE;
-  for (size_t i = 0; i <= file_len; i++) {
-    *dst++ = *src++;
+  ArchiumPackageIndex index;
+  if (archium_index_open(&index, index_path)) {
+    uint32_t repo_count = index.repo_count;
+    archium_index_close(&index);
+    if (repo_count > 0) {
+      return;
+    }
   }
 
-  unlink(cache_path);
+  unlink(index_path);
   log_debug("Invalidated package cache");
 }
 
 void cleanup_cached_commands(void) {
-  if (cached_commands) {
-    for (int i = 0; cached_commands[i] != NULL; i++) {
-      free(cached_commands[i]);
-    }
-    free(cached_commands);
-    cached_commands = NULL;
+  if (pthread_mutex_trylock(&index_mutex) != 0) {
+    return;
   }
+
+  index_shutdown = 1;
+  if (package_index_loaded) {
+    archium_index_close(&package_index);
+    package_index_loaded = 0;
+  }
+  pthread_mutex_unlock(&index_mutex);
+
+  completion_set_free(&command_set);
+  completion_set_free(&installed_set);
+  completion_set_free(&cached_set);
 }
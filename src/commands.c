@@ -1,22 +1,27 @@
+#include <dirent.h>
+#include <limits.h>
+
 #include "include/archium.h"
 
-typedef enum {
-  CMD_FLAG_NONE = 0,
-  CMD_FLAG_HAS_ARGS = 1,
-  CMD_FLAG_INTERACTIVE = 2,
-} CommandFlags;
+#ifdef __has_include
+#if __has_include("command_hash.h")
+#include "command_hash.h"
+#endif
+#endif
 
 typedef enum {
   CMD_TYPE_SIMPLE,
   CMD_TYPE_WITH_PM,
   CMD_TYPE_WITH_PM_ARGS,
   CMD_TYPE_ARGS_ONLY,
+  CMD_TYPE_QUIT,
 } CommandType;
 
 typedef struct {
   const char *name;
   CommandType type;
-  CommandFlags flags;
+  const char *prompt;
+  CompletionSource completion;
   union {
     void (*simple)(void);
     void (*with_pm)(const char *pm);
@@ -25,81 +30,125 @@ typedef struct {
   } handler;
 } CommandEntry;
 
+static void show_help(const char *topic) {
+  if (*topic == '\0') {
+    display_help();
+  } else if (strcmp(topic, "quick") == 0) {
+    display_help_quick();
+  } else if (strcmp(topic, "packages") == 0 ||
+             strcmp(topic, "system") == 0 || strcmp(topic, "info") == 0 ||
+             strcmp(topic, "config") == 0 || strcmp(topic, "plugin") == 0) {
+    display_help_category(topic);
+  } else {
+    display_help_command(topic);
+  }
+}
+
+static void show_plugin_directory(void) {
+  const char *plugin_dir = archium_config_get_plugin_dir();
+  if (plugin_dir) {
+    printf("\033[1;32mPlugin directory: %s\033[0m\n", plugin_dir);
+    printf(
+        "\033[1;33mPlace .so files in this directory to load them as "
+        "plugins.\033[0m\n");
+  } else {
+    printf("\033[1;31mFailed to get plugin directory.\033[0m\n");
+  }
+}
+
+static void create_example_plugin(void) {
+  if (archium_plugin_create_example()) {
+    const char *plugin_dir = archium_config_get_plugin_dir();
+    printf("\033[1;32mExample plugin created successfully!\033[0m\n");
+    printf("\033[1;33mLocation: %s/example.c\033[0m\n",
+           plugin_dir ? plugin_dir : "unknown");
+    printf("\033[1;33mTo build: cd %s && make\033[0m\n",
+           plugin_dir ? plugin_dir : "unknown");
+    printf("\033[1;33mRestart Archium to load the plugin.\033[0m\n");
+    log_action("Example plugin created");
+  } else {
+    printf("\033[1;31mFailed to create example plugin.\033[0m\n");
+  }
+}
+
+#define COMMAND_HANDLER_SIMPLE(fn) {.simple = fn}
+#define COMMAND_HANDLER_WITH_PM(fn) {.with_pm = fn}
+#define COMMAND_HANDLER_WITH_PM_ARGS(fn) {.with_pm_args = fn}
+#define COMMAND_HANDLER_ARGS_ONLY(fn) {.args_only = fn}
+#define COMMAND_HANDLER_QUIT(fn) {.simple = fn}
+
 static const CommandEntry command_table[] = {
-    {"c", CMD_TYPE_WITH_PM, CMD_FLAG_NONE, {.with_pm = clean_cache}},
-    {"cc", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = clear_build_cache}},
-    {"l", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = list_installed_packages}},
-    {"cu", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = check_package_updates}},
-    {"si", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = list_packages_by_size}},
-    {"re", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = list_recent_installs}},
-    {"ex", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = list_explicit_installs}},
-    {"ba", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = backup_pacman_config}},
-    {"health", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = system_health_check}},
-    {"config",
-     CMD_TYPE_SIMPLE,
-     CMD_FLAG_NONE,
-     {.simple = configure_preferences}},
-    {"pl",
-     CMD_TYPE_SIMPLE,
-     CMD_FLAG_NONE,
-     {.simple = archium_plugin_list_loaded}},
-    {"o", CMD_TYPE_WITH_PM, CMD_FLAG_NONE, {.with_pm = clean_orphans}},
-    {"lo", CMD_TYPE_SIMPLE, CMD_FLAG_NONE, {.simple = list_orphans}},
-    {"u",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = update_system}},
-    {"i",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = install_package}},
-    {"r",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = remove_package}},
-    {"d",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = downgrade_package}},
-    {"p",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = purge_package}},
-    {"s",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = search_package}},
-    {"?",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = show_package_info}},
-    {"dt",
-     CMD_TYPE_WITH_PM_ARGS,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.with_pm_args = display_dependency_tree}},
-    {"ow",
-     CMD_TYPE_ARGS_ONLY,
-     CMD_FLAG_HAS_ARGS | CMD_FLAG_INTERACTIVE,
-     {.args_only = find_package_owner}},
+#define X(name, type, handler, prompt, completion, usage, help, summary) \
+  {name, CMD_TYPE_##type, prompt, completion, COMMAND_HANDLER_##type(handler)},
+    ARCHIUM_COMMAND_SPEC(X)
+#undef X
 };
 
 static const size_t command_table_size =
     sizeof(command_table) / sizeof(command_table[0]);
 
-static const CommandEntry *find_command(const char *cmd) {
+#ifdef ARCHIUM_COMMAND_HASH_SEED
+_Static_assert(sizeof(command_table) / sizeof(command_table[0]) ==
+                   ARCHIUM_COMMAND_HASH_COUNT,
+               "command_hash.h is out of date, run make command-hash");
+#endif
+
+int builtin_command_index(const char *name) {
+  if (!name) {
+    return -1;
+  }
+
+#ifdef ARCHIUM_COMMAND_HASH_SEED
+  int index = archium_command_hash_slots[archium_command_hash(
+      name, strlen(name), ARCHIUM_COMMAND_HASH_SEED)];
+  if (index >= 0 && strcmp(command_table[index].name, name) == 0) {
+    return index;
+  }
+#else
   for (size_t i = 0; i < command_table_size; i++) {
-    if (strcmp(cmd, command_table[i].name) == 0) {
-      return &command_table[i];
+    if (strcmp(command_table[i].name, name) == 0) {
+      return (int)i;
     }
   }
-  return NULL;
+#endif
+  return -1;
 }
 
-static void execute_command(const char *command, const char *log_message) {
-  int ret = system(command);
+const char *get_valid_command(size_t index) {
+  return index < command_table_size ? command_table[index].name : NULL;
+}
+
+CompletionSource builtin_command_completion(int index) {
+  if (index < 0 || (size_t)index >= command_table_size) {
+    return COMPLETION_NONE;
+  }
+  return command_table[index].completion;
+}
+
+static int build_package_argv(ArchiumArgv *args, const char *package_manager,
+                              const char *flags, const char *packages) {
+  argv_init(args);
+  if (!argv_push(args, package_manager) || !argv_push_words(args, flags) ||
+      (packages && !argv_push_words(args, packages))) {
+    argv_free(args);
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    return 0;
+  }
+  return 1;
+}
+
+static void execute_command(const char *const argv[],
+                            const char *log_message) {
+  int ret = run_process(argv, 0);
+  record_command_exit_code(ret);
   if (ret != 0) {
     fputs("\033[1;31mError: Command failed: \033[0m", stderr);
-    fputs(command, stderr);
+    for (size_t i = 0; argv[i]; i++) {
+      if (i > 0) {
+        fputc(' ', stderr);
+      }
+      fputs(argv[i], stderr);
+    }
     fputc('\n', stderr);
     if (config.verbose) {
       printf("\033[1;31m[Status]\033[0m Command failed (exit code: %d)\n", ret);
@@ -114,9 +163,15 @@ static void execute_command(const char *command, const char *log_message) {
   }
 }
 
-static void get_user_input(char *buffer, const char *prompt) {
+/* Set while handle_script runs: there is nobody to answer a prompt. */
+static int running_script;
+
+static void get_user_input(char *buffer, const char *prompt,
+                           CompletionSource source) {
   rl_attempted_completion_function = command_completion;
+  set_completion_source(source);
   get_input(buffer, MAX_INPUT_LENGTH, prompt);
+  set_completion_source(COMPLETION_AUTO);
   rl_attempted_completion_function = NULL;
 }
 
@@ -152,127 +207,137 @@ ArchiumError handle_command(const char *input, const char *package_manager) {
     return hook_result;
   }
 
-  if (!is_valid_command(input)) {
+  int index = builtin_command_index(command_token);
+  if (index < 0) {
+    if (!archium_plugin_is_plugin_command(command_token)) {
+      archium_plugin_after_command(command_token, args, package_manager,
+                                   ARCHIUM_ERROR_INVALID_INPUT);
+      return ARCHIUM_ERROR_INVALID_INPUT;
+    }
+    ArchiumError result =
+        archium_plugin_execute(command_token, args, package_manager);
     archium_plugin_after_command(command_token, args, package_manager,
-                                 ARCHIUM_ERROR_INVALID_INPUT);
-    return ARCHIUM_ERROR_INVALID_INPUT;
+                                 result);
+    return result;
   }
 
-  if (strcmp(input, "h") == 0 || strcmp(input, "help") == 0) {
-    display_help();
-    archium_plugin_after_command(command_token, args, package_manager,
-                                 ARCHIUM_SUCCESS);
-    return ARCHIUM_SUCCESS;
-  }
-
-  if (strncmp(input, "h ", 2) == 0) {
-    const char *help_arg = input + 2;
-    if (strcmp(help_arg, "quick") == 0) {
-      display_help_quick();
-    } else if (strcmp(help_arg, "packages") == 0 ||
-               strcmp(help_arg, "system") == 0 ||
-               strcmp(help_arg, "info") == 0 ||
-               strcmp(help_arg, "config") == 0 ||
-               strcmp(help_arg, "plugin") == 0) {
-      display_help_category(help_arg);
-    } else {
-      display_help_command(help_arg);
+  const CommandEntry *cmd = &command_table[index];
+  char user_input[MAX_INPUT_LENGTH];
+  if (*args == '\0' && cmd->prompt) {
+    if (!running_script) {
+      get_user_input(user_input, cmd->prompt, cmd->completion);
+      args = user_input;
+    } else if (strcmp(cmd->name, "u") != 0) {
+      fprintf(stderr,
+              "\033[1;31mError: '%s' needs an argument in a script\033[0m\n",
+              command_token);
+      record_command_exit_code(1);
+      archium_plugin_after_command(command_token, args, package_manager,
+                                   ARCHIUM_ERROR_INVALID_INPUT);
+      return ARCHIUM_ERROR_INVALID_INPUT;
     }
-    archium_plugin_after_command(command_token, args, package_manager,
-                                 ARCHIUM_SUCCESS);
-    return ARCHIUM_SUCCESS;
   }
 
-  if (strcmp(input, "q") == 0 || strcmp(input, "quit") == 0 ||
-      strcmp(input, "exit") == 0) {
-    printf("Exiting Archium.\n");
-    cleanup_cached_commands();
-    archium_plugin_notify_exit(command_token, args, package_manager);
-    archium_plugin_cleanup();
-    exit(0);
+  switch (cmd->type) {
+    case CMD_TYPE_SIMPLE:
+      cmd->handler.simple();
+      break;
+    case CMD_TYPE_WITH_PM:
+      cmd->handler.with_pm(package_manager);
+      break;
+    case CMD_TYPE_WITH_PM_ARGS:
+      cmd->handler.with_pm_args(package_manager, args);
+      break;
+    case CMD_TYPE_ARGS_ONLY:
+      cmd->handler.args_only(args);
+      break;
+    case CMD_TYPE_QUIT:
+      if (archium_transaction_is_open()) {
+        fprintf(stderr,
+                "\033[1;33mWarning: Exiting with an open transaction, "
+                "%zu queued packages discarded.\033[0m\n",
+                archium_transaction_pending());
+        archium_transaction_abort();
+      }
+      printf("Exiting Archium.\n");
+      cleanup_cached_commands();
+      archium_plugin_notify_exit(command_token, args, package_manager);
+      archium_plugin_cleanup();
+      exit(0);
   }
 
-  if (strcmp(input, "pd") == 0) {
-    const char *plugin_dir = archium_config_get_plugin_dir();
-    if (plugin_dir) {
-      printf("\033[1;32mPlugin directory: %s\033[0m\n", plugin_dir);
-      printf(
-          "\033[1;33mPlace .so files in this directory to load them as "
-          "plugins.\033[0m\n");
-    } else {
-      printf("\033[1;31mFailed to get plugin directory.\033[0m\n");
-    }
-  } else if (strcmp(input, "pe") == 0) {
-    if (archium_plugin_create_example()) {
-      const char *plugin_dir = archium_config_get_plugin_dir();
-      printf("\033[1;32mExample plugin created successfully!\033[0m\n");
-      printf("\033[1;33mLocation: %s/example.c\033[0m\n",
-             plugin_dir ? plugin_dir : "unknown");
-      printf("\033[1;33mTo build: cd %s && make\033[0m\n",
-             plugin_dir ? plugin_dir : "unknown");
-      printf("\033[1;33mRestart Archium to load the plugin.\033[0m\n");
-      log_action("Example plugin created");
-    } else {
-      printf("\033[1;31mFailed to create example plugin.\033[0m\n");
+  archium_plugin_after_command(command_token, args, package_manager,
+                               ARCHIUM_SUCCESS);
+  return ARCHIUM_SUCCESS;
+}
+
+static char *trim_command(char *text) {
+  while (isspace((unsigned char)*text)) {
+    text++;
+  }
+  char *end = text + strlen(text);
+  while (end > text && isspace((unsigned char)end[-1])) {
+    end--;
+  }
+  *end = '\0';
+  return text;
+}
+
+ArchiumError handle_command_line(const char *line,
+                                 const char *package_manager) {
+  char *copy = strdup(line);
+  if (!copy) {
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    return ARCHIUM_ERROR_MEMORY_ALLOCATION;
+  }
+
+  ArchiumError status = ARCHIUM_SUCCESS;
+  int failed = 0;
+  int require_success = 0;
+  char *cursor = copy;
+  while (cursor) {
+    char *next = NULL;
+    int next_requires_success = 0;
+    for (char *p = cursor; *p; p++) {
+      if (*p == ';') {
+        *p = '\0';
+        next = p + 1;
+        break;
+      }
+      if (p[0] == '&' && p[1] == '&') {
+        *p = '\0';
+        next = p + 2;
+        next_requires_success = 1;
+        break;
+      }
     }
-  } else {
-    const CommandEntry *cmd = find_command(command_token);
-    if (cmd) {
-      if (cmd->type == CMD_TYPE_SIMPLE) {
-        cmd->handler.simple();
-      } else if (cmd->type == CMD_TYPE_WITH_PM) {
-        cmd->handler.with_pm(package_manager);
-      } else if (cmd->type == CMD_TYPE_WITH_PM_ARGS) {
-        if ((cmd->flags & CMD_FLAG_HAS_ARGS) && args && *args != '\0') {
-          cmd->handler.with_pm_args(package_manager, args);
-        } else if (cmd->flags & CMD_FLAG_INTERACTIVE) {
-          char user_input[MAX_INPUT_LENGTH];
-          const char *prompt = NULL;
-          if (strcmp(cmd->name, "u") == 0) {
-            prompt = "Enter package names to update: ";
-          } else if (strcmp(cmd->name, "i") == 0) {
-            prompt = "Enter package names to install: ";
-          } else if (strcmp(cmd->name, "r") == 0) {
-            prompt = "Enter package names to remove: ";
-          } else if (strcmp(cmd->name, "d") == 0) {
-            prompt = "Enter package names to downgrade: ";
-          } else if (strcmp(cmd->name, "p") == 0) {
-            prompt = "Enter package names to purge: ";
-          } else if (strcmp(cmd->name, "s") == 0) {
-            prompt = "Enter package name to search: ";
-          } else if (strcmp(cmd->name, "?") == 0) {
-            prompt = "Enter package name to show info: ";
-          } else if (strcmp(cmd->name, "dt") == 0) {
-            prompt = "Enter package name to view dependencies: ";
-          }
-          if (prompt) {
-            get_user_input(user_input, prompt);
-            cmd->handler.with_pm_args(package_manager, user_input);
-          }
-        } else {
-          cmd->handler.with_pm_args(package_manager, args);
+
+    char *command = trim_command(cursor);
+    if (*command != '\0') {
+      if (require_success && failed) {
+        print_command_status(command, ARCHIUM_SUCCESS, 0, 0);
+      } else {
+        reset_command_exit_code();
+        status = handle_command(command, package_manager);
+        int exit_code = get_command_exit_code();
+        /* A recorded exit code means the command already said why. */
+        if (status != ARCHIUM_SUCCESS && exit_code == 0) {
+          archium_report_error(status, "Command execution failed", command);
         }
-      } else if (cmd->type == CMD_TYPE_ARGS_ONLY) {
-        if ((cmd->flags & CMD_FLAG_HAS_ARGS) && args && *args != '\0') {
-          cmd->handler.args_only(args);
-        } else if (cmd->flags & CMD_FLAG_INTERACTIVE) {
-          char user_input[MAX_INPUT_LENGTH];
-          get_user_input(user_input, "Enter file path: ");
-          cmd->handler.args_only(user_input);
+        print_command_status(command, status, exit_code, 1);
+        if (status == ARCHIUM_SUCCESS && exit_code != 0) {
+          status = ARCHIUM_ERROR_PROCESS_FAILED;
         }
+        failed = status != ARCHIUM_SUCCESS;
       }
-    } else if (archium_plugin_is_plugin_command(command_token)) {
-      ArchiumError result =
-          archium_plugin_execute(command_token, args, package_manager);
-      archium_plugin_after_command(command_token, args, package_manager,
-                                   result);
-      return result;
     }
+
+    require_success = next_requires_success;
+    cursor = next;
   }
 
-  archium_plugin_after_command(command_token, args, package_manager,
-                               ARCHIUM_SUCCESS);
-  return ARCHIUM_SUCCESS;
+  free(copy);
+  return status;
 }
 
 ArchiumError handle_exec_command(const char *command,
@@ -283,15 +348,60 @@ ArchiumError handle_exec_command(const char *command,
 
   log_action(command);
 
-  return handle_command(command, package_manager);
+  return handle_command_line(command, package_manager);
+}
+
+ArchiumError handle_script(const char *path, const char *package_manager) {
+  if (!path || !package_manager) {
+    return ARCHIUM_ERROR_INVALID_INPUT;
+  }
+
+  int from_stdin = strcmp(path, "-") == 0;
+  FILE *fp = from_stdin ? stdin : fopen(path, "r");
+  if (!fp) {
+    archium_report_error(ARCHIUM_ERROR_FILE_NOT_FOUND,
+                         "Failed to open script", path);
+    return ARCHIUM_ERROR_FILE_NOT_FOUND;
+  }
+
+  ArchiumError result = ARCHIUM_SUCCESS;
+  char *line = NULL;
+  size_t capacity = 0;
+  running_script = 1;
+  while (getline(&line, &capacity, fp) != -1) {
+    char *command = trim_command(line);
+    if (*command == '\0' || *command == '#') {
+      continue;
+    }
+
+    ArchiumError status = handle_command_line(command, package_manager);
+    if (status != ARCHIUM_SUCCESS) {
+      result = status;
+    }
+  }
+
+  running_script = 0;
+  free(line);
+  if (!from_stdin) {
+    fclose(fp);
+  }
+
+  if (archium_transaction_is_open()) {
+    fprintf(stderr,
+            "\033[1;33mWarning: Script ended with an open transaction, "
+            "%zu queued packages discarded.\033[0m\n",
+            archium_transaction_pending());
+    archium_transaction_abort();
+  }
+  return result;
 }
 
 void update_system(const char *package_manager, const char *package) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
+  ArchiumArgv args;
+  ArchiumOutput output;
 
   if (config.use_native_output) {
-    if (package) {
+    if (package && *package) {
       if (!validate_package_name(package)) {
         fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
                 package);
@@ -307,17 +417,23 @@ void update_system(const char *package_manager, const char *package) {
         return;
       }
 
-      snprintf(command, sizeof(command), "%s -S %s", package_manager,
-               sanitized_package);
-      int result = execute_command_native(command);
+      if (!build_package_argv(&args, package_manager, "-S",
+                              sanitized_package)) {
+        return;
+      }
+      int result = execute_argv_native(args.items);
+      argv_free(&args);
 
       if (result == 0) {
         invalidate_package_cache();
       }
     } else {
-      snprintf(command, sizeof(command), "%s -Syu --noconfirm",
-               package_manager);
-      int result = execute_command_native(command);
+      if (!build_package_argv(&args, package_manager, "-Syu --noconfirm",
+                              NULL)) {
+        return;
+      }
+      int result = execute_argv_native(args.items);
+      argv_free(&args);
 
       if (result == 0) {
         invalidate_package_cache();
@@ -326,7 +442,7 @@ void update_system(const char *package_manager, const char *package) {
     return;
   }
 
-  if (package) {
+  if (package && *package) {
     if (!validate_package_name(package)) {
       fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
               package);
@@ -339,23 +455,35 @@ void update_system(const char *package_manager, const char *package) {
       fprintf(
           stderr,
           "\033[1;31mError: Package name contains invalid characters\033[0m\n");
+      record_command_exit_code(1);
       return;
     }
 
-    snprintf(command, sizeof(command), "%s -S --noconfirm %s", package_manager,
-             sanitized_package);
-    int result = execute_command_with_output_capture(
-        command, "Upgrading package", output_buffer, sizeof(output_buffer));
-    parse_and_show_install_result(output_buffer, result, package);
+    if (!build_package_argv(&args, package_manager, "-S --noconfirm",
+                            sanitized_package)) {
+      return;
+    }
+    output_init(&output);
+    int result = execute_argv_with_output_capture(
+        args.items, "Upgrading package", &output);
+    argv_free(&args);
+    parse_and_show_install_result(&output, result, package);
+    output_free(&output);
 
     if (result == 0) {
       invalidate_package_cache();
     }
   } else {
-    snprintf(command, sizeof(command), "%s -Syu --noconfirm", package_manager);
-    int result = execute_command_with_output_capture(
-        command, "Upgrading system", output_buffer, sizeof(output_buffer));
-    parse_and_show_upgrade_result(output_buffer, result);
+    if (!build_package_argv(&args, package_manager, "-Syu --noconfirm",
+                            NULL)) {
+      return;
+    }
+    output_init(&output);
+    int result = execute_argv_with_output_capture(
+        args.items, "Upgrading system", &output);
+    argv_free(&args);
+    parse_and_show_upgrade_result(&output, result);
+    output_free(&output);
 
     if (result == 0) {
       invalidate_package_cache();
@@ -365,7 +493,6 @@ void update_system(const char *package_manager, const char *package) {
 
 void clear_build_cache() {
   const char *cache_dir = archium_config_get_cache_dir();
-  char output_buffer[1024];
 
   if (cache_dir) {
     if (!validate_file_path(cache_dir)) {
@@ -383,34 +510,135 @@ void clear_build_cache() {
       return;
     }
 
-    char command[COMMAND_BUFFER_SIZE];
-    snprintf(command, sizeof(command), "rm -rf %s/*", sanitized_cache_dir);
-    int result = execute_command_with_output_capture(
-        command, "Clearing Archium cache", output_buffer,
-        sizeof(output_buffer));
-    parse_and_show_generic_result(output_buffer, result,
-                                  "Clearing Archium cache");
+    ArchiumArgv args;
+    argv_init(&args);
+    argv_push(&args, "rm");
+    argv_push(&args, "-rf");
+    DIR *dir = opendir(sanitized_cache_dir);
+    if (dir) {
+      struct dirent *entry;
+      while ((entry = readdir(dir)) != NULL) {
+        if (strcmp(entry->d_name, ".") == 0 ||
+            strcmp(entry->d_name, "..") == 0) {
+          continue;
+        }
+        char entry_path[COMMAND_BUFFER_SIZE];
+        if (snprintf(entry_path, sizeof(entry_path), "%s/%s",
+                     sanitized_cache_dir,
+                     entry->d_name) < (int)sizeof(entry_path)) {
+          argv_push(&args, entry_path);
+        }
+      }
+      closedir(dir);
+    }
+
+    int result = execute_argv_with_output_capture(
+        args.items, "Clearing Archium cache", NULL);
+    argv_free(&args);
+    parse_and_show_generic_result(result, "Clearing Archium cache");
   }
 
-  int result1 = execute_command_with_output_capture(
-      "rm -rf $HOME/.cache/yay", "Clearing yay cache", output_buffer,
-      sizeof(output_buffer));
-  parse_and_show_generic_result(output_buffer, result1, "Clearing yay cache");
+  const char *home = getenv("HOME");
+  if (!home) {
+    return;
+  }
 
-  int result2 = execute_command_with_output_capture(
-      "rm -rf $HOME/.cache/paru", "Clearing paru cache", output_buffer,
-      sizeof(output_buffer));
-  parse_and_show_generic_result(output_buffer, result2, "Clearing paru cache");
+  char helper_cache[COMMAND_BUFFER_SIZE];
+  snprintf(helper_cache, sizeof(helper_cache), "%s/.cache/yay", home);
+  const char *const yay_argv[] = {"rm", "-rf", helper_cache, NULL};
+  int result1 =
+      execute_argv_with_output_capture(yay_argv, "Clearing yay cache", NULL);
+  parse_and_show_generic_result(result1, "Clearing yay cache");
+
+  snprintf(helper_cache, sizeof(helper_cache), "%s/.cache/paru", home);
+  const char *const paru_argv[] = {"rm", "-rf", helper_cache, NULL};
+  int result2 =
+      execute_argv_with_output_capture(paru_argv, "Clearing paru cache", NULL);
+  parse_and_show_generic_result(result2, "Clearing paru cache");
+}
+
+static int load_local_db(ArchiumLocalDb *db) {
+  char snapshot_path[COMMAND_BUFFER_SIZE];
+  const char *cache_dir = archium_config_get_cache_dir();
+  int have_snapshot =
+      cache_dir && snprintf(snapshot_path, sizeof(snapshot_path), "%s/%s",
+                            cache_dir, ARCHIUM_LOCALDB_SNAPSHOT_FILE) <
+                       (int)sizeof(snapshot_path);
+
+  if (!archium_localdb_open_cached(db, ARCHIUM_LOCAL_DB_DIR,
+                                   have_snapshot ? snapshot_path : NULL,
+                                   (size_t)config.scan_threads)) {
+    fprintf(stderr,
+            "\033[1;31mError: Failed to read local package database "
+            "%s\033[0m\n",
+            ARCHIUM_LOCAL_DB_DIR);
+    record_command_exit_code(1);
+    return 0;
+  }
+  return 1;
+}
+
+static int collect_orphans(ArchiumDepGraph *graph, uint32_t **orphans,
+                           uint32_t *count) {
+  ArchiumLocalDb local;
+  if (!load_local_db(&local)) {
+    return 0;
+  }
+
+  unsigned int keep = 0;
+  if (config.orphans_keep_optional) {
+    keep |= ARCHIUM_ORPHAN_KEEP_OPTIONAL;
+  }
+
+  ArchiumLocalDb sync;
+  archium_localdb_init(&sync);
+  if (config.orphans_keep_make) {
+    keep |= ARCHIUM_ORPHAN_KEEP_MAKE;
+    if (!archium_localdb_load_sync(&sync, ARCHIUM_SYNC_DB_DIR)) {
+      fprintf(stderr,
+              "\033[1;33mWarning: Sync databases unavailable, make "
+              "dependencies are not kept.\033[0m\n");
+    }
+  }
+
+  int ok = archium_depgraph_build(graph, &local, sync.count ? &sync : NULL);
+  archium_localdb_free(&sync);
+  archium_localdb_free(&local);
+
+  if (ok && !archium_depgraph_find_orphans(graph, keep, orphans, count)) {
+    archium_depgraph_free(graph);
+    ok = 0;
+  }
+  if (!ok) {
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    record_command_exit_code(1);
+  }
+  return ok;
 }
 
 void list_orphans() {
   printf("\033[1;34mListing orphaned packages...\033[0m\n");
-  execute_command("pacman -Qdt", NULL);
+
+  ArchiumDepGraph graph;
+  uint32_t *orphans;
+  uint32_t count;
+  if (!collect_orphans(&graph, &orphans, &count)) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    printf("%s %s\n",
+           archium_depgraph_string(&graph, graph.node_name[orphans[i]]),
+           archium_depgraph_string(&graph, graph.node_version[orphans[i]]));
+  }
+
+  free(orphans);
+  archium_depgraph_free(&graph);
 }
 
 void install_package(const char *package_manager, const char *packages) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
+  ArchiumArgv args;
+  ArchiumOutput output;
 
   char sanitized_packages[MEDIUM_BUFFER_SIZE];
   if (!sanitize_shell_input(packages, sanitized_packages,
@@ -418,6 +646,16 @@ void install_package(const char *package_manager, const char *packages) {
     fprintf(
         stderr,
         "\033[1;31mError: Package names contain invalid characters\033[0m\n");
+    record_command_exit_code(1);
+    return;
+  }
+
+  if (archium_transaction_is_open()) {
+    archium_transaction_queue(ARCHIUM_TX_INSTALL, sanitized_packages);
+    return;
+  }
+
+  if (!build_package_argv(&args, package_manager, "-S --noconfirm", NULL)) {
     return;
   }
 
@@ -426,25 +664,28 @@ void install_package(const char *package_manager, const char *packages) {
     if (!validate_package_name(token)) {
       fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
               token);
+      argv_free(&args);
       return;
     }
+    argv_push(&args, token);
     token = strtok(NULL, " ");
   }
 
-  snprintf(command, sizeof(command), "%s -S --noconfirm %s", package_manager,
-           sanitized_packages);
-
   if (config.use_native_output) {
-    int result = execute_command_native(command);
+    int result = execute_argv_native(args.items);
+    argv_free(&args);
     if (result == 0) {
       invalidate_package_cache();
     }
     return;
   }
 
-  int result = execute_command_with_output_capture(
-      command, "Installing packages", output_buffer, sizeof(output_buffer));
-  parse_and_show_install_result(output_buffer, result, packages);
+  output_init(&output);
+  int result = execute_argv_with_output_capture(
+      args.items, "Installing packages", &output);
+  argv_free(&args);
+  parse_and_show_install_result(&output, result, packages);
+  output_free(&output);
 
   if (result == 0) {
     invalidate_package_cache();
@@ -452,8 +693,8 @@ void install_package(const char *package_manager, const char *packages) {
 }
 
 void remove_package(const char *package_manager, const char *packages) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
+  ArchiumArgv args;
+  ArchiumOutput output;
 
   char sanitized_packages[MEDIUM_BUFFER_SIZE];
   if (!sanitize_shell_input(packages, sanitized_packages,
@@ -461,6 +702,16 @@ void remove_package(const char *package_manager, const char *packages) {
     fprintf(
         stderr,
         "\033[1;31mError: Package names contain invalid characters\033[0m\n");
+    record_command_exit_code(1);
+    return;
+  }
+
+  if (archium_transaction_is_open()) {
+    archium_transaction_queue(ARCHIUM_TX_REMOVE, sanitized_packages);
+    return;
+  }
+
+  if (!build_package_argv(&args, package_manager, "-R --noconfirm", NULL)) {
     return;
   }
 
@@ -469,25 +720,28 @@ void remove_package(const char *package_manager, const char *packages) {
     if (!validate_package_name(token)) {
       fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
               token);
+      argv_free(&args);
       return;
     }
+    argv_push(&args, token);
     token = strtok(NULL, " ");
   }
 
-  snprintf(command, sizeof(command), "%s -R --noconfirm %s", package_manager,
-           sanitized_packages);
-
   if (config.use_native_output) {
-    int result = execute_command_native(command);
+    int result = execute_argv_native(args.items);
+    argv_free(&args);
     if (result == 0) {
       invalidate_package_cache();
     }
     return;
   }
 
-  int result = execute_command_with_output_capture(
-      command, "Removing packages", output_buffer, sizeof(output_buffer));
-  parse_and_show_remove_result(output_buffer, result, packages);
+  output_init(&output);
+  int result = execute_argv_with_output_capture(
+      args.items, "Removing packages", &output);
+  argv_free(&args);
+  parse_and_show_remove_result(&output, result, packages);
+  output_free(&output);
 
   if (result == 0) {
     invalidate_package_cache();
@@ -495,8 +749,8 @@ void remove_package(const char *package_manager, const char *packages) {
 }
 
 void purge_package(const char *package_manager, const char *packages) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
+  ArchiumArgv args;
+  ArchiumOutput output;
 
   char sanitized_packages[MEDIUM_BUFFER_SIZE];
   if (!sanitize_shell_input(packages, sanitized_packages,
@@ -504,6 +758,16 @@ void purge_package(const char *package_manager, const char *packages) {
     fprintf(
         stderr,
         "\033[1;31mError: Package names contain invalid characters\033[0m\n");
+    record_command_exit_code(1);
+    return;
+  }
+
+  if (archium_transaction_is_open()) {
+    archium_transaction_queue(ARCHIUM_TX_PURGE, sanitized_packages);
+    return;
+  }
+
+  if (!build_package_argv(&args, package_manager, "-Rns --noconfirm", NULL)) {
     return;
   }
 
@@ -512,80 +776,88 @@ void purge_package(const char *package_manager, const char *packages) {
     if (!validate_package_name(token)) {
       fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
               token);
+      argv_free(&args);
       return;
     }
+    argv_push(&args, token);
     token = strtok(NULL, " ");
   }
 
-  snprintf(command, sizeof(command), "%s -Rns --noconfirm %s", package_manager,
-           sanitized_packages);
-
   if (config.use_native_output) {
-    execute_command_native(command);
+    execute_argv_native(args.items);
+    argv_free(&args);
     return;
   }
 
-  int result = execute_command_with_output_capture(
-      command, "Purging packages", output_buffer, sizeof(output_buffer));
-  parse_and_show_remove_result(output_buffer, result, packages);
+  output_init(&output);
+  int result =
+      execute_argv_with_output_capture(args.items, "Purging packages", &output);
+  argv_free(&args);
+  parse_and_show_remove_result(&output, result, packages);
+  output_free(&output);
 }
 
 void clean_cache(const char *package_manager) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[2048];
-  snprintf(command, sizeof(command), "%s -Sc --noconfirm", package_manager);
+  const char *const argv[] = {package_manager, "-Sc", "--noconfirm", NULL};
 
   if (config.use_native_output) {
-    execute_command_native(command);
+    execute_argv_native(argv);
     return;
   }
 
-  int result = execute_command_with_output_capture(
-      command, "Cleaning package cache", output_buffer, sizeof(output_buffer));
-  parse_and_show_generic_result(output_buffer, result,
-                                "Cleaning package cache");
+  int result =
+      execute_argv_with_output_capture(argv, "Cleaning package cache", NULL);
+  parse_and_show_generic_result(result, "Cleaning package cache");
 }
 
 void clean_orphans(const char *package_manager) {
-  char orphan_check_command[COMMAND_BUFFER_SIZE];
-  snprintf(orphan_check_command, sizeof(orphan_check_command), "pacman -Qdtq");
-
-  FILE *fp = popen(orphan_check_command, "r");
-  if (!fp) {
-    fprintf(stderr,
-            "\033[1;31mError: Failed to check for orphaned packages.\033[0m\n");
+  ArchiumDepGraph graph;
+  uint32_t *orphans;
+  uint32_t count;
+  if (!collect_orphans(&graph, &orphans, &count)) {
     return;
   }
 
-  char orphaned_packages[COMMAND_BUFFER_SIZE] = {0};
-  if (!fgets(orphaned_packages, sizeof(orphaned_packages), fp)) {
-    pclose(fp);
+  if (count == 0) {
+    archium_depgraph_free(&graph);
     printf("\033[1;32mNo orphaned packages found.\033[0m\n");
     return;
   }
-  pclose(fp);
 
-  orphaned_packages[strcspn(orphaned_packages, "\n")] = '\0';
-
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[2048];
-  snprintf(command, sizeof(command), "%s -Rns --noconfirm %s", package_manager,
-           orphaned_packages);
+  ArchiumArgv args;
+  int ok = build_package_argv(&args, package_manager, "-Rns --noconfirm",
+                              NULL);
+  for (uint32_t i = 0; ok && i < count; i++) {
+    if (!argv_push(&args, archium_depgraph_string(
+                              &graph, graph.node_name[orphans[i]]))) {
+      argv_free(&args);
+      fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+      ok = 0;
+    }
+  }
+  free(orphans);
+  archium_depgraph_free(&graph);
+  if (!ok) {
+    return;
+  }
 
+  int result;
   if (config.use_native_output) {
-    execute_command_native(command);
-    return;
+    result = execute_argv_native(args.items);
+  } else {
+    result = execute_argv_with_output_capture(
+        args.items, "Cleaning orphaned packages", NULL);
+    parse_and_show_generic_result(result, "Cleaning orphaned packages");
   }
+  argv_free(&args);
 
-  int result =
-      execute_command_with_output_capture(command, "Cleaning orphaned packages",
-                                          output_buffer, sizeof(output_buffer));
-  parse_and_show_generic_result(output_buffer, result,
-                                "Cleaning orphaned packages");
+  if (result == 0) {
+    invalidate_package_cache();
+  }
 }
 
 void search_package(const char *package_manager, const char *package) {
-  char command[COMMAND_BUFFER_SIZE];
+  ArchiumArgv args;
 
   char sanitized_package[256];
   if (!sanitize_shell_input(package, sanitized_package,
@@ -593,22 +865,36 @@ void search_package(const char *package_manager, const char *package) {
     fprintf(
         stderr,
         "\033[1;31mError: Package name contains invalid characters\033[0m\n");
+    record_command_exit_code(1);
     return;
   }
 
-  snprintf(command, sizeof(command), "%s -Ss %s", package_manager,
-           sanitized_package);
+  if (!build_package_argv(&args, package_manager, "-Ss", sanitized_package)) {
+    return;
+  }
   printf("\033[1;34mSearching for package: %s\033[0m\n", package);
-  execute_command(command, NULL);
+  execute_command(args.items, NULL);
+  argv_free(&args);
 }
 
 void list_installed_packages(void) {
   printf("\033[1;34mListing installed packages...\033[0m\n");
-  execute_command("pacman -Qe", NULL);
+
+  ArchiumLocalDb db;
+  if (!load_local_db(&db)) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < db.count; i++) {
+    if (db.reason[i] == ARCHIUM_LOCALDB_REASON_EXPLICIT) {
+      printf("%s %s\n", archium_localdb_name(&db, i),
+             archium_localdb_version(&db, i));
+    }
+  }
+  archium_localdb_free(&db);
 }
 
 void show_package_info(const char *package_manager, const char *package) {
-  char command[COMMAND_BUFFER_SIZE];
 
   if (!validate_package_name(package)) {
     fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
@@ -622,56 +908,152 @@ void show_package_info(const char *package_manager, const char *package) {
     fprintf(
         stderr,
         "\033[1;31mError: Package name contains invalid characters\033[0m\n");
+    record_command_exit_code(1);
     return;
   }
 
-  snprintf(command, sizeof(command), "%s -Si %s", package_manager,
-           sanitized_package);
+  const char *const argv[] = {package_manager, "-Si", sanitized_package, NULL};
   printf("\033[1;34mShowing information for package: %s\033[0m\n", package);
-  execute_command(command, NULL);
+  execute_command(argv, NULL);
 }
 
 void check_package_updates(void) {
   printf("\033[1;34mChecking for package updates...\033[0m\n");
-  execute_command("pacman -Qu", "Checked for updates");
+  const char *const argv[] = {"pacman", "-Qu", NULL};
+  execute_command(argv, "Checked for updates");
+}
+
+static int parse_tree_arguments(const char *arguments, char *package,
+                                size_t package_size, int *reverse,
+                                int *max_depth) {
+  char buffer[MEDIUM_BUFFER_SIZE];
+  if (snprintf(buffer, sizeof(buffer), "%s", arguments) >=
+      (int)sizeof(buffer)) {
+    return 0;
+  }
+
+  package[0] = '\0';
+  *reverse = 0;
+  *max_depth = -1;
+
+  char *save = NULL;
+  for (char *token = strtok_r(buffer, " ", &save); token;
+       token = strtok_r(NULL, " ", &save)) {
+    if (strcmp(token, "-r") == 0 || strcmp(token, "--reverse") == 0) {
+      *reverse = 1;
+    } else if (strcmp(token, "-d") == 0 || strcmp(token, "--depth") == 0) {
+      char *value = strtok_r(NULL, " ", &save);
+      char *end = NULL;
+      long depth = value ? strtol(value, &end, 10) : -1;
+      if (!value || *end != '\0' || depth < 0 || depth > INT_MAX) {
+        fprintf(stderr,
+                "\033[1;31mError: %s expects a non-negative depth\033[0m\n",
+                token);
+        return 0;
+      }
+      *max_depth = (int)depth;
+    } else if (package[0] == '\0' && validate_package_name(token)) {
+      snprintf(package, package_size, "%s", token);
+    } else {
+      fprintf(stderr, "\033[1;31mError: Invalid argument: %s\033[0m\n",
+              token);
+      return 0;
+    }
+  }
+
+  if (package[0] == '\0') {
+    fprintf(stderr,
+            "\033[1;31mError: Usage: dt [-r] [-d depth] <package>\033[0m\n");
+    return 0;
+  }
+  return 1;
 }
 
-void display_dependency_tree(const char *package_manager, const char *package) {
+void display_dependency_tree(const char *package_manager,
+                             const char *arguments) {
   (void)package_manager;
-  char command[COMMAND_BUFFER_SIZE];
 
-  if (!validate_package_name(package)) {
-    fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
-            package);
+  char package[SMALL_BUFFER_SIZE];
+  int reverse;
+  int max_depth;
+  if (!parse_tree_arguments(arguments, package, sizeof(package), &reverse,
+                            &max_depth)) {
+    record_command_exit_code(1);
     return;
   }
 
-  char sanitized_package[256];
-  if (!sanitize_shell_input(package, sanitized_package,
-                            sizeof(sanitized_package))) {
-    fprintf(
-        stderr,
-        "\033[1;31mError: Package name contains invalid characters\033[0m\n");
+  ArchiumLocalDb local;
+  if (!load_local_db(&local)) {
     return;
   }
 
-  snprintf(command, sizeof(command), "pactree %s", sanitized_package);
-  printf("\033[1;34mDisplaying dependency tree for package: %s\033[0m\n",
-         package);
-  execute_command(command, NULL);
+  ArchiumLocalDb sync;
+  archium_localdb_init(&sync);
+  ArchiumDepGraph graph;
+  int built = archium_depgraph_build(&graph, &local, NULL);
+  uint32_t root =
+      built ? archium_depgraph_find(&graph, package) : ARCHIUM_DEPGRAPH_NONE;
+
+  if (built && root == ARCHIUM_DEPGRAPH_NONE && !reverse &&
+      archium_localdb_load_sync(&sync, ARCHIUM_SYNC_DB_DIR)) {
+    archium_depgraph_free(&graph);
+    built = archium_depgraph_build(&graph, &local, &sync);
+    root = built ? archium_depgraph_find(&graph, package)
+                 : ARCHIUM_DEPGRAPH_NONE;
+  }
+
+  if (!built) {
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    record_command_exit_code(1);
+  } else if (root == ARCHIUM_DEPGRAPH_NONE) {
+    fprintf(stderr, "\033[1;31mError: Package '%s' was not found\033[0m\n",
+            package);
+    record_command_exit_code(1);
+  } else {
+    printf("\033[1;34mDisplaying %s tree for package: %s\033[0m\n",
+           reverse ? "reverse dependency" : "dependency", package);
+    archium_depgraph_print_tree(&graph, root, reverse, max_depth);
+  }
+
+  if (built) {
+    archium_depgraph_free(&graph);
+  }
+  archium_localdb_free(&sync);
+  archium_localdb_free(&local);
+}
+
+static int is_installed_from_aur(void) {
+  const char *const argv[] = {"pacman", "-Qm", NULL};
+  ArchiumProcess process;
+  if (!spawn_process(&process, argv,
+                     PROCESS_CAPTURE_STDOUT | PROCESS_DISCARD_STDERR)) {
+    return -1;
+  }
+
+  FILE *fp = process_output(&process);
+  int found = 0;
+  char line[COMMAND_BUFFER_SIZE];
+  while (fp && !found && fgets(line, sizeof(line), fp) != NULL) {
+    found = strncmp(line, "archium ", 8) == 0;
+  }
+  wait_process(&process);
+  return found;
+}
+
+static void remove_clone_dir(const char *clone_dir) {
+  const char *const argv[] = {"rm", "-rf", clone_dir, NULL};
+  run_process(argv, 0);
 }
 
 void perform_self_update(void) {
-  FILE *fp = popen("pacman -Qm | grep '^archium '", "r");
-  if (!fp) {
+  int from_aur = is_installed_from_aur();
+  if (from_aur < 0) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
                          "Failed to check installation source", NULL);
     return;
   }
 
-  char buffer[COMMAND_BUFFER_SIZE];
-  if (fgets(buffer, sizeof(buffer), fp) != NULL) {
-    pclose(fp);
+  if (from_aur) {
     printf("\033[1;33mWarning: Archium appears to be installed via AUR.\n");
     printf("Please use your AUR helper to update instead:\n");
     printf("yay -Syu archium\n");
@@ -679,10 +1061,8 @@ void perform_self_update(void) {
     printf("paru -Syu archium\033[0m\n");
     return;
   }
-  pclose(fp);
 
   char clone_dir[COMMAND_BUFFER_SIZE];
-  char command[COMMAND_BUFFER_SIZE];
   int ret;
 
   const char *cache_dir = archium_config_get_cache_dir();
@@ -708,94 +1088,204 @@ void perform_self_update(void) {
     return;
   }
 
-  ret = snprintf(command, sizeof(command), "git clone -q %.256s %.256s",
-                 ARCHIUM_REPO_URL, clone_dir);
-  if (ret >= (int)sizeof(command)) {
-    archium_report_error(ARCHIUM_ERROR_INVALID_INPUT, "Command string too long",
-                         NULL);
-    rmdir(clone_dir);
-    return;
-  }
-
-  char output_buffer[2048];
-  int result1 =
-      execute_command_with_output_capture(command, "Cloning Archium repository",
-                                          output_buffer, sizeof(output_buffer));
+  const char *const clone_argv[] = {"git", "clone", "-q", ARCHIUM_REPO_URL,
+                                    clone_dir, NULL};
+  int result1 = execute_argv_with_output_capture(
+      clone_argv, "Cloning Archium repository", NULL);
   if (result1 != 0) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
                          "Failed to clone repository", NULL);
     rmdir(clone_dir);
     return;
   }
-  parse_and_show_generic_result(output_buffer, result1,
-                                "Cloning Archium repository");
+  parse_and_show_generic_result(result1, "Cloning Archium repository");
 
   if (chdir(clone_dir) != 0) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
                          "Failed to change to clone directory", NULL);
-    ret = snprintf(command, sizeof(command), "rm -rf %.256s", clone_dir);
-    if (ret < (int)sizeof(command)) {
-      system(command);
-    }
+    remove_clone_dir(clone_dir);
     return;
   }
 
-  int result2 = execute_command_with_output_capture(
-      "make", "Building Archium", output_buffer, sizeof(output_buffer));
+  const char *const make_argv[] = {"make", NULL};
+  int result2 =
+      execute_argv_with_output_capture(make_argv, "Building Archium", NULL);
   if (result2 != 0) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL, "Failed to build project",
                          NULL);
-    ret = snprintf(command, sizeof(command), "rm -rf %.256s", clone_dir);
-    if (ret < (int)sizeof(command)) {
-      system(command);
-    }
+    remove_clone_dir(clone_dir);
     return;
   }
-  parse_and_show_generic_result(output_buffer, result2, "Building Archium");
+  parse_and_show_generic_result(result2, "Building Archium");
 
-  int result3 = execute_command_with_output_capture(
-      "sudo make install", "Installing updates", output_buffer,
-      sizeof(output_buffer));
+  const char *const install_argv[] = {"sudo", "make", "install", NULL};
+  int result3 = execute_argv_with_output_capture(
+      install_argv, "Installing updates", NULL);
   if (result3 != 0) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL, "Failed to install updates",
                          NULL);
-    ret = snprintf(command, sizeof(command), "rm -rf %.256s", clone_dir);
-    if (ret < (int)sizeof(command)) {
-      system(command);
-    }
+    remove_clone_dir(clone_dir);
     return;
   }
-  parse_and_show_generic_result(output_buffer, result3, "Installing updates");
+  parse_and_show_generic_result(result3, "Installing updates");
 
-  ret = snprintf(command, sizeof(command), "rm -rf %.256s", clone_dir);
-  if (ret < (int)sizeof(command)) {
-    system(command);
-  }
+  remove_clone_dir(clone_dir);
 
   printf("\033[1;32mArchium has been updated successfully!\033[0m\n");
   log_info("Self-update completed successfully");
 }
 
+typedef struct {
+  uint64_t bytes;
+  uint32_t index;
+} SizedPackage;
+
+static int compare_sized_packages(const void *a, const void *b) {
+  const SizedPackage *left = a;
+  const SizedPackage *right = b;
+  if (left->bytes != right->bytes) {
+    return left->bytes < right->bytes ? -1 : 1;
+  }
+  return (left->index > right->index) - (left->index < right->index);
+}
+
+static void print_humanized_size(uint64_t bytes, const char *name) {
+  static const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB"};
+  double value = (double)bytes;
+  size_t unit = 0;
+  while (value > 2048.0 && unit < sizeof(units) / sizeof(units[0]) - 1) {
+    value /= 1024.0;
+    unit++;
+  }
+  printf("%.2f%s %s\n", value, units[unit], name);
+}
+
+static FILE *open_command_output(ArchiumProcess *process,
+                                 const char *const argv[]) {
+  if (!spawn_process(process, argv,
+                     PROCESS_CAPTURE_STDOUT | PROCESS_DISCARD_STDERR)) {
+    return NULL;
+  }
+  FILE *fp = process_output(process);
+  if (!fp) {
+    wait_process(process);
+  }
+  return fp;
+}
+
+static void report_command_failure(const char *command) {
+  fprintf(stderr, "\033[1;31mError: Command failed: \033[0m%s\n", command);
+}
+
 void list_packages_by_size(void) {
   printf("\033[1;34mListing installed packages by size...\033[0m\n");
-  execute_command(
-      "pacman -Qi | awk '/^Name/{name=$3} /^Installed Size/{size=$4$5; print "
-      "size, name}' | sort -h",
-      "Listed packages by size");
+
+  ArchiumLocalDb db;
+  if (!load_local_db(&db)) {
+    return;
+  }
+
+  SizedPackage *packages =
+      malloc((db.count ? db.count : 1) * sizeof(*packages));
+  if (!packages) {
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    archium_localdb_free(&db);
+    return;
+  }
+
+  for (uint32_t i = 0; i < db.count; i++) {
+    packages[i].bytes = db.size[i];
+    packages[i].index = i;
+  }
+  if (db.count > 1) {
+    qsort(packages, db.count, sizeof(*packages), compare_sized_packages);
+  }
+  for (uint32_t i = 0; i < db.count; i++) {
+    print_humanized_size(packages[i].bytes,
+                         archium_localdb_name(&db, packages[i].index));
+  }
+
+  free(packages);
+  archium_localdb_free(&db);
+  log_action("Listed packages by size");
+}
+
+static int contains_ignore_case(const char *haystack, const char *needle) {
+  size_t needle_length = strlen(needle);
+  for (; *haystack; haystack++) {
+    if (strncasecmp(haystack, needle, needle_length) == 0) {
+      return 1;
+    }
+  }
+  return 0;
 }
 
+#define RECENT_INSTALLS_SHOWN 20
+
 void list_recent_installs(void) {
   printf("\033[1;34mListing recently installed packages...\033[0m\n");
-  execute_command("grep -i installed /var/log/pacman.log | tail -n 20",
-                  "Listed recent installations");
+
+  FILE *fp = fopen("/var/log/pacman.log", "r");
+  if (!fp) {
+    report_command_failure("read /var/log/pacman.log");
+    return;
+  }
+
+  char recent[RECENT_INSTALLS_SHOWN][COMMAND_BUFFER_SIZE];
+  size_t seen = 0;
+  char line[COMMAND_BUFFER_SIZE];
+  while (fgets(line, sizeof(line), fp)) {
+    size_t length = strcspn(line, "\n");
+    if (line[length] != '\n' && !feof(fp)) {
+      int c;
+      while ((c = fgetc(fp)) != EOF && c != '\n') {
+      }
+    }
+    line[length] = '\0';
+
+    if (contains_ignore_case(line, "installed")) {
+      memcpy(recent[seen % RECENT_INSTALLS_SHOWN], line, length + 1);
+      seen++;
+    }
+  }
+  fclose(fp);
+
+  size_t first =
+      seen > RECENT_INSTALLS_SHOWN ? seen - RECENT_INSTALLS_SHOWN : 0;
+  for (size_t i = first; i < seen; i++) {
+    printf("%s\n", recent[i % RECENT_INSTALLS_SHOWN]);
+  }
+
+  log_action("Listed recent installations");
+}
+
+static int is_base_group(const char *group) {
+  return strcmp(group, "base") == 0 || strcmp(group, "base-devel") == 0;
 }
 
 void list_explicit_installs(void) {
   printf("\033[1;34mListing explicitly installed packages...\033[0m\n");
-  execute_command(
-      "pacman -Qei | awk '/^Name/ { name=$3 } /^Groups/ { if ($3 != \"base\" "
-      "&& $3 != \"base-devel\") { print name } }'",
-      "Listed explicit installations");
+
+  ArchiumLocalDb db;
+  if (!load_local_db(&db)) {
+    return;
+  }
+
+  for (uint32_t i = 0; i < db.count; i++) {
+    if (db.reason[i] != ARCHIUM_LOCALDB_REASON_EXPLICIT) {
+      continue;
+    }
+    uint32_t group_count;
+    const uint32_t *groups =
+        archium_localdb_list(&db, i, ARCHIUM_LOCALDB_GROUPS, &group_count);
+    if (group_count == 0 ||
+        !is_base_group(archium_localdb_string(&db, groups[0]))) {
+      printf("%s\n", archium_localdb_name(&db, i));
+    }
+  }
+
+  archium_localdb_free(&db);
+  log_action("Listed explicit installations");
 }
 
 void find_package_owner(const char *file) {
@@ -820,17 +1310,17 @@ void find_package_owner(const char *file) {
     return;
   }
 
-  char command[COMMAND_BUFFER_SIZE];
   char sanitized_file[4096];
   if (!sanitize_shell_input(file, sanitized_file, sizeof(sanitized_file))) {
     fprintf(stderr,
             "\033[1;31mError: File path contains invalid characters\033[0m\n");
+    record_command_exit_code(1);
     return;
   }
 
-  snprintf(command, sizeof(command), "pacman -Qo %s", sanitized_file);
+  const char *const argv[] = {"pacman", "-Qo", sanitized_file, NULL};
   printf("\033[1;34mFinding package owner for: %s\033[0m\n", file);
-  execute_command(command, NULL);
+  execute_command(argv, NULL);
 }
 
 void backup_pacman_config(void) {
@@ -838,12 +1328,14 @@ void backup_pacman_config(void) {
   char timestamp[32];
   strftime(timestamp, sizeof(timestamp), "%Y%m%d_%H%M%S", localtime(&now));
 
-  char command[COMMAND_BUFFER_SIZE];
-  snprintf(command, sizeof(command),
-           "sudo cp /etc/pacman.conf /etc/pacman.conf.backup_%s", timestamp);
+  char backup_path[MEDIUM_BUFFER_SIZE];
+  snprintf(backup_path, sizeof(backup_path), "/etc/pacman.conf.backup_%s",
+           timestamp);
+  const char *const argv[] = {"sudo", "cp", "/etc/pacman.conf", backup_path,
+                              NULL};
 
   printf("\033[1;34mBacking up pacman configuration...\033[0m\n");
-  if (system(command) == 0) {
+  if (run_process(argv, 0) == 0) {
     printf("\033[1;32mBackup created: /etc/pacman.conf.backup_%s\033[0m\n",
            timestamp);
     log_info("Pacman configuration backed up");
@@ -872,7 +1364,7 @@ void configure_preferences(void) {
   printf("14. View log file location\n");
 
   char choice[MAX_INPUT_LENGTH];
-  get_user_input(choice, "Enter your choice (1-14): ");
+  get_user_input(choice, "Enter your choice (1-14): ", COMPLETION_NONE);
 
   if (strcmp(choice, "1") == 0) {
     printf("\033[1;33mCurrent preference:\033[0m ");
@@ -883,7 +1375,8 @@ void configure_preferences(void) {
     }
 
     char pref[MAX_INPUT_LENGTH];
-    get_user_input(pref, "Set package manager preference (yay/paru): ");
+    get_user_input(pref, "Set package manager preference (yay/paru): ",
+                   COMPLETION_NONE);
 
     if (strcmp(pref, "yay") == 0 || strcmp(pref, "paru") == 0) {
       if (archium_config_set_preference("package_manager", pref)) {
@@ -942,7 +1435,8 @@ void configure_preferences(void) {
     }
   } else if (strcmp(choice, "7") == 0) {
     char ttl[MAX_INPUT_LENGTH];
-    get_user_input(ttl, "Enter cache TTL in seconds (60-86400): ");
+    get_user_input(ttl, "Enter cache TTL in seconds (60-86400): ",
+                   COMPLETION_NONE);
     if (archium_config_set_preference("cache_ttl_seconds", ttl)) {
       printf("\033[1;32mCache TTL set to %d seconds\033[0m\n",
              config.cache_ttl_seconds);
@@ -953,7 +1447,7 @@ void configure_preferences(void) {
     archium_config_print_effective(stdout);
   } else if (strcmp(choice, "9") == 0) {
     char path[MAX_INPUT_LENGTH];
-    get_user_input(path, "Export file path: ");
+    get_user_input(path, "Export file path: ", COMPLETION_FILES);
     if (archium_config_export_preferences(path)) {
       printf("\033[1;32mPreferences exported to: %s\033[0m\n", path);
     } else {
@@ -961,7 +1455,7 @@ void configure_preferences(void) {
     }
   } else if (strcmp(choice, "10") == 0) {
     char path[MAX_INPUT_LENGTH];
-    get_user_input(path, "Import file path: ");
+    get_user_input(path, "Import file path: ", COMPLETION_FILES);
     if (archium_config_import_preferences(path)) {
       printf("\033[1;32mPreferences imported successfully.\033[0m\n");
     } else {
@@ -976,7 +1470,7 @@ void configure_preferences(void) {
     }
   } else if (strcmp(choice, "12") == 0) {
     char path[MAX_INPUT_LENGTH];
-    get_user_input(path, "Backup file path to restore: ");
+    get_user_input(path, "Backup file path to restore: ", COMPLETION_FILES);
     if (archium_config_restore_preferences(path)) {
       printf("\033[1;32mPreferences restored successfully.\033[0m\n");
     } else {
@@ -1001,95 +1495,134 @@ void configure_preferences(void) {
   }
 }
 
-char **list_cached_versions(const char *package, int *count) {
-  char command[COMMAND_BUFFER_SIZE];
-  char **versions = NULL;
-  *count = 0;
+static int compare_versions(const void *a, const void *b) {
+  const char *left = *(const char *const *)a;
+  const char *right = *(const char *const *)b;
 
-  if (!validate_package_name(package)) {
-    fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
-            package);
-    return NULL;
+  while (*left && *right) {
+    if (isdigit((unsigned char)*left) && isdigit((unsigned char)*right)) {
+      while (*left == '0') {
+        left++;
+      }
+      while (*right == '0') {
+        right++;
+      }
+      size_t left_digits = 0;
+      size_t right_digits = 0;
+      while (isdigit((unsigned char)left[left_digits])) {
+        left_digits++;
+      }
+      while (isdigit((unsigned char)right[right_digits])) {
+        right_digits++;
+      }
+      if (left_digits != right_digits) {
+        return left_digits < right_digits ? -1 : 1;
+      }
+      int cmp = strncmp(left, right, left_digits);
+      if (cmp != 0) {
+        return cmp;
+      }
+      left += left_digits;
+      right += right_digits;
+      continue;
+    }
+
+    if (*left != *right) {
+      return (unsigned char)*left < (unsigned char)*right ? -1 : 1;
+    }
+    left++;
+    right++;
   }
 
-  char sanitized_package[256];
-  if (!sanitize_shell_input(package, sanitized_package,
-                            sizeof(sanitized_package))) {
-    fprintf(
-        stderr,
-        "\033[1;31mError: Package name contains invalid characters\033[0m\n");
+  return (unsigned char)*left - (unsigned char)*right;
+}
+
+static const char *cached_package_version(const char *filename,
+                                          const char *package,
+                                          size_t *version_length) {
+  size_t package_length = strlen(package);
+  if (strncmp(filename, package, package_length) != 0 ||
+      filename[package_length] != '-') {
     return NULL;
   }
 
-  snprintf(command, sizeof(command),
-           "ls -1 /var/cache/pacman/pkg/%s-*.pkg.tar.zst 2>/dev/null | sort -V",
-           sanitized_package);
-
-  FILE *fp = popen(command, "r");
-  if (!fp) {
+  const char *version = filename + package_length + 1;
+  const char *suffix = strstr(version, ".pkg.tar.zst");
+  if (!suffix || suffix[strlen(".pkg.tar.zst")] != '\0') {
     return NULL;
   }
 
-  char line[MEDIUM_BUFFER_SIZE];
-  while (fgets(line, sizeof(line), fp) != NULL) {
-    size_t len = strcspn(line, "\n");
-    if (len < sizeof(line)) {
-      line[len] = 0;
-    } else {
-      line[sizeof(line) - 1] = 0;
+  int separators = 0;
+  for (const char *cursor = version; cursor < suffix; cursor++) {
+    if (*cursor == '-') {
+      separators++;
     }
+  }
+  if (separators != 2) {
+    return NULL;
+  }
 
-    char *filename = strrchr(line, '/');
-    if (filename) {
-      filename++;
-    } else {
-      filename = line;
-    }
+  *version_length = (size_t)(suffix - version);
+  return version;
+}
 
-    char *version_start = strstr(filename, sanitized_package);
-    if (version_start) {
-      version_start += strlen(sanitized_package);
-      if (*version_start == '-') {
-        version_start++;
-      }
+char **list_cached_versions(const char *package, int *count,
+                            ArchiumArena *arena) {
+  char **versions = NULL;
+  size_t capacity = 0;
+  *count = 0;
 
-      char *version_end = strstr(version_start, "-");
-      if (version_end) {
-        *version_end = '\0';
+  if (!validate_package_name(package)) {
+    fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
+            package);
+    return NULL;
+  }
 
-        char **new_versions = realloc(versions, sizeof(char *) * (*count + 1));
-        if (!new_versions) {
-          pclose(fp);
-          for (int i = 0; i < *count; i++) {
-            free(versions[i]);
-          }
-          free(versions);
-          *count = 0;
-          return NULL;
-        }
-        versions = new_versions;
-        versions[*count] = strdup(version_start);
-        if (!versions[*count]) {
-          pclose(fp);
-          for (int i = 0; i < *count; i++) {
-            free(versions[i]);
-          }
-          free(versions);
-          *count = 0;
-          return NULL;
-        }
-        (*count)++;
+  DIR *dir = opendir(ARCHIUM_PKG_CACHE_DIR);
+  if (!dir) {
+    return NULL;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    size_t version_length = 0;
+    const char *version =
+        cached_package_version(entry->d_name, package, &version_length);
+    if (!version) {
+      continue;
+    }
+
+    if ((size_t)*count == capacity) {
+      size_t new_capacity = capacity ? capacity * 2 : 16;
+      char **new_versions =
+          archium_arena_grow(arena, versions, capacity * sizeof(char *),
+                             new_capacity * sizeof(char *));
+      if (!new_versions) {
+        closedir(dir);
+        *count = 0;
+        return NULL;
       }
+      versions = new_versions;
+      capacity = new_capacity;
+    }
+    versions[*count] = archium_arena_strndup(arena, version, version_length);
+    if (!versions[*count]) {
+      closedir(dir);
+      *count = 0;
+      return NULL;
     }
+    (*count)++;
   }
-  pclose(fp);
+  closedir(dir);
 
+  if (*count > 1) {
+    qsort(versions, (size_t)*count, sizeof(char *), compare_versions);
+  }
   return versions;
 }
 
 void downgrade_package(const char *package_manager, const char *packages) {
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
+  ArchiumOutput output;
 
   char sanitized_packages[MEDIUM_BUFFER_SIZE];
   if (!sanitize_shell_input(packages, sanitized_packages,
@@ -1097,6 +1630,7 @@ void downgrade_package(const char *package_manager, const char *packages) {
     fprintf(
         stderr,
         "\033[1;31mError: Package names contain invalid characters\033[0m\n");
+    record_command_exit_code(1);
     return;
   }
 
@@ -1116,7 +1650,10 @@ void downgrade_package(const char *package_manager, const char *packages) {
     }
 
     int version_count = 0;
-    char **versions = list_cached_versions(token, &version_count);
+    ArchiumArena version_arena;
+    archium_arena_init(&version_arena, SMALL_BUFFER_SIZE * 4);
+    char **versions =
+        list_cached_versions(token, &version_count, &version_arena);
 
     if (version_count == 0) {
       printf("\033[1;33mNo cached versions found for package: %s\033[0m\n",
@@ -1128,34 +1665,36 @@ void downgrade_package(const char *package_manager, const char *packages) {
       }
 
       char choice[16];
-      get_user_input(choice, "Select version to downgrade to (number): ");
+      get_user_input(choice, "Select version to downgrade to (number): ",
+                     COMPLETION_NONE);
 
       int selected = atoi(choice);
       if (selected > 0 && selected <= version_count) {
         char package_file[MEDIUM_BUFFER_SIZE];
         snprintf(package_file, sizeof(package_file),
-                 "/var/cache/pacman/pkg/%s-%s.pkg.tar.zst", token,
+                 ARCHIUM_PKG_CACHE_DIR "/%s-%s.pkg.tar.zst", token,
                  versions[selected - 1]);
 
         printf("\033[1;34mDowngrading %s to version %s...\033[0m\n", token,
                versions[selected - 1]);
 
-        if (strcmp(package_manager, "pacman") == 0) {
-          snprintf(command, sizeof(command), "sudo %s -U %s", package_manager,
-                   package_file);
-        } else {
-          snprintf(command, sizeof(command), "%s -S %s --needed --noconfirm",
-                   package_manager, token);
-        }
+        const char *const pacman_argv[] = {"sudo", package_manager, "-U",
+                                           package_file, NULL};
+        const char *const helper_argv[] = {package_manager, "-S", token,
+                                           "--needed", "--noconfirm", NULL};
+        const char *const *argv = strcmp(package_manager, "pacman") == 0
+                                      ? pacman_argv
+                                      : helper_argv;
 
         if (config.use_native_output) {
-          execute_command_native(command);
+          execute_argv_native(argv);
           printf("\033[1;32mDowngrade operation completed.\033[0m\n");
         } else {
-          int result = execute_command_with_output_capture(
-              command, "Downgrading package", output_buffer,
-              sizeof(output_buffer));
-          parse_and_show_install_result(output_buffer, result, token);
+          output_init(&output);
+          int result = execute_argv_with_output_capture(
+              argv, "Downgrading package", &output);
+          parse_and_show_install_result(&output, result, token);
+          output_free(&output);
 
           if (result == 0) {
             printf("\033[1;32mPackage %s downgraded successfully!\033[0m\n",
@@ -1168,11 +1707,8 @@ void downgrade_package(const char *package_manager, const char *packages) {
         printf("\033[1;31mInvalid selection.\033[0m\n");
       }
 
-      for (int i = 0; i < version_count; i++) {
-        free(versions[i]);
-      }
-      free(versions);
     }
+    archium_arena_free(&version_arena);
 
     token = strtok(NULL, " ");
   }
@@ -1196,19 +1732,24 @@ void system_health_check(void) {
       "\033["
       "0m\n\n");
 
-  char command[COMMAND_BUFFER_SIZE];
+  ArchiumProcess process;
   int issues_found = 0;
 
   printf("\033[1;33mDisk Space Analysis:\033[0m\n");
-  snprintf(command, sizeof(command), "df -h | grep -E '^/dev/' | head -5");
-  FILE *fp = popen(command, "r");
+  const char *const df_argv[] = {"df", "-h", NULL};
+  FILE *fp = open_command_output(&process, df_argv);
   if (fp) {
     char line[SMALL_BUFFER_SIZE];
-    while (fgets(line, sizeof(line), fp)) {
+    int devices = 0;
+    while (fgets(line, sizeof(line), fp) && devices < 5) {
       size_t len = strcspn(line, "\n");
       if (len < sizeof(line)) {
         line[len] = 0;
       }
+      if (strncmp(line, "/dev/", 5) != 0) {
+        continue;
+      }
+      devices++;
 
       char *usage = strchr(line, ' ');
       if (usage) {
@@ -1227,13 +1768,12 @@ void system_health_check(void) {
         }
       }
     }
-    pclose(fp);
+    wait_process(&process);
   }
 
   printf("\n\033[1;33mSystem Integrity:\033[0m\n");
-  snprintf(command, sizeof(command),
-           "pacman -Qk 2>/dev/null | grep -v '0 missing files'");
-  fp = popen(command, "r");
+  const char *const check_argv[] = {"pacman", "-Qk", NULL};
+  fp = open_command_output(&process, check_argv);
   if (fp) {
     char line[SMALL_BUFFER_SIZE];
     int integrity_issues = 0;
@@ -1242,13 +1782,13 @@ void system_health_check(void) {
       if (len < sizeof(line)) {
         line[len] = 0;
       }
-      if (strlen(line) > 0) {
+      if (strlen(line) > 0 && !strstr(line, "0 missing files")) {
         printf("  \033[1;31m[x] %s\033[0m\n", line);
         integrity_issues++;
         issues_found++;
       }
     }
-    pclose(fp);
+    wait_process(&process);
     if (integrity_issues == 0) {
       printf(
           "  \033[1;32m[*] All installed packages have valid file "
@@ -1257,9 +1797,9 @@ void system_health_check(void) {
   }
 
   printf("\n\033[1;33mSystem Services Status:\033[0m\n");
-  snprintf(command, sizeof(command),
-           "systemctl --failed --no-legend 2>/dev/null | head -5");
-  fp = popen(command, "r");
+  const char *const systemctl_argv[] = {"systemctl", "--failed",
+                                        "--no-legend", NULL};
+  fp = open_command_output(&process, systemctl_argv);
   if (fp) {
     char line[SMALL_BUFFER_SIZE];
     int failed_services = 0;
@@ -1274,7 +1814,7 @@ void system_health_check(void) {
         issues_found++;
       }
     }
-    pclose(fp);
+    wait_process(&process);
     if (failed_services == 0) {
       printf("  \033[1;32m[*] No failed system services\033[0m\n");
     } else if (failed_services == 3) {
@@ -1283,29 +1823,36 @@ void system_health_check(void) {
   }
 
   printf("\n\033[1;33mPackage Database:\033[0m\n");
-  snprintf(command, sizeof(command), "pacman -Qm 2>/dev/null | wc -l");
-  fp = popen(command, "r");
+  const char *const foreign_argv[] = {"pacman", "-Qm", NULL};
+  fp = open_command_output(&process, foreign_argv);
   if (fp) {
-    char foreign_count[16];
-    if (fgets(foreign_count, sizeof(foreign_count), fp)) {
-      int count = atoi(foreign_count);
-      if (count > 50) {
-        printf("  \033[1;33m[⚠] %d foreign/aur packages installed\033[0m\n",
-               count);
-      } else {
-        printf("  \033[1;32m[✓] %d foreign/aur packages installed\033[0m\n",
-               count);
+    int count = 0;
+    int c;
+    while ((c = fgetc(fp)) != EOF) {
+      if (c == '\n') {
+        count++;
       }
     }
-    pclose(fp);
+    if (count > 50) {
+      printf("  \033[1;33m[⚠] %d foreign/aur packages installed\033[0m\n",
+             count);
+    } else {
+      printf("  \033[1;32m[✓] %d foreign/aur packages installed\033[0m\n",
+             count);
+    }
+    wait_process(&process);
   }
 
   printf("\n\033[1;33mMemory Usage:\033[0m\n");
-  snprintf(command, sizeof(command), "free -h | grep '^Mem:'");
-  fp = popen(command, "r");
+  const char *const free_argv[] = {"free", "-h", NULL};
+  fp = open_command_output(&process, free_argv);
   if (fp) {
     char line[SMALL_BUFFER_SIZE];
-    if (fgets(line, sizeof(line), fp)) {
+    int found = 0;
+    while (!found && fgets(line, sizeof(line), fp)) {
+      found = strncmp(line, "Mem:", 4) == 0;
+    }
+    if (found) {
       size_t len = strcspn(line, "\n");
       if (len < sizeof(line)) {
         line[len] = 0;
@@ -1329,7 +1876,7 @@ void system_health_check(void) {
         }
       }
     }
-    pclose(fp);
+    wait_process(&process);
   }
 
   printf(
@@ -5,6 +5,9 @@
 #define CONFIG_VALUE_MAX_LEN 256
 #define CONFIG_CACHE_TTL_MIN 60
 #define CONFIG_CACHE_TTL_MAX 86400
+#define CONFIG_CAPTURE_LIMIT_MAX 1048576
+#define CONFIG_COMMAND_TIMEOUT_MAX 86400
+#define PREFERENCE_TABLE_SIZE 32
 
 static char config_dir_path[CONFIG_BUFFER_SIZE];
 static char log_file_path[CONFIG_BUFFER_SIZE];
@@ -15,6 +18,26 @@ static char preferred_package_manager[16] = "";
 
 static int config_initialized = 0;
 
+typedef struct {
+  char key[CONFIG_KEY_MAX_LEN];
+  char value[CONFIG_VALUE_MAX_LEN];
+  int used;
+} PreferenceSlot;
+
+typedef struct {
+  char *text;
+  int slot;
+} PreferenceLine;
+
+typedef struct {
+  PreferenceSlot slots[PREFERENCE_TABLE_SIZE];
+  PreferenceLine *lines;
+  size_t line_count;
+  size_t line_capacity;
+} PreferenceStore;
+
+static PreferenceStore preferences;
+
 static int parse_int_in_range(const char *value, int min, int max, int *out) {
   if (!value || !out) {
     return 0;
@@ -80,7 +103,10 @@ static int validate_preference_key_value(const char *key, const char *value) {
   }
 
   if (strcmp(key, "use_native_output") == 0 ||
-      strcmp(key, "show_welcome") == 0 || strcmp(key, "show_tips") == 0) {
+      strcmp(key, "show_welcome") == 0 || strcmp(key, "show_tips") == 0 ||
+      strcmp(key, "fuzzy_completion") == 0 ||
+      strcmp(key, "orphans_keep_optional") == 0 ||
+      strcmp(key, "orphans_keep_make") == 0) {
     return is_boolean_value(value);
   }
 
@@ -90,6 +116,21 @@ static int validate_preference_key_value(const char *key, const char *value) {
                               &ttl);
   }
 
+  if (strcmp(key, "capture_limit_kb") == 0) {
+    int limit = 0;
+    return parse_int_in_range(value, 0, CONFIG_CAPTURE_LIMIT_MAX, &limit);
+  }
+
+  if (strcmp(key, "command_timeout_seconds") == 0) {
+    int timeout = 0;
+    return parse_int_in_range(value, 0, CONFIG_COMMAND_TIMEOUT_MAX, &timeout);
+  }
+
+  if (strcmp(key, "scan_threads") == 0) {
+    int threads = 0;
+    return parse_int_in_range(value, 0, ARCHIUM_POOL_MAX_THREADS, &threads);
+  }
+
   return 0;
 }
 
@@ -130,21 +171,47 @@ static void apply_preference_to_runtime(const char *key, const char *value) {
     return;
   }
 
+  if (strcmp(key, "fuzzy_completion") == 0 &&
+      parse_bool_value(value, &bool_value)) {
+    config.fuzzy_completion = bool_value;
+    return;
+  }
+
+  if (strcmp(key, "orphans_keep_optional") == 0 &&
+      parse_bool_value(value, &bool_value)) {
+    config.orphans_keep_optional = bool_value;
+    return;
+  }
+
+  if (strcmp(key, "orphans_keep_make") == 0 &&
+      parse_bool_value(value, &bool_value)) {
+    config.orphans_keep_make = bool_value;
+    return;
+  }
+
   if (strcmp(key, "cache_ttl_seconds") == 0 &&
       parse_int_in_range(value, CONFIG_CACHE_TTL_MIN, CONFIG_CACHE_TTL_MAX,
                          &int_value)) {
     config.cache_ttl_seconds = int_value;
+    return;
   }
-}
 
-static void apply_preference_if_exists(const char *key) {
-  char *value = archium_config_get_preference(key);
-  if (!value) {
+  if (strcmp(key, "capture_limit_kb") == 0 &&
+      parse_int_in_range(value, 0, CONFIG_CAPTURE_LIMIT_MAX, &int_value)) {
+    config.capture_limit_kb = int_value;
     return;
   }
 
-  apply_preference_to_runtime(key, value);
-  free(value);
+  if (strcmp(key, "command_timeout_seconds") == 0 &&
+      parse_int_in_range(value, 0, CONFIG_COMMAND_TIMEOUT_MAX, &int_value)) {
+    config.command_timeout_seconds = int_value;
+    return;
+  }
+
+  if (strcmp(key, "scan_threads") == 0 &&
+      parse_int_in_range(value, 0, ARCHIUM_POOL_MAX_THREADS, &int_value)) {
+    config.scan_threads = int_value;
+  }
 }
 
 static void apply_env_override(const char *env_name, const char *key) {
@@ -170,93 +237,238 @@ static void apply_environment_overrides(void) {
   apply_env_override("ARCHIUM_SHOW_WELCOME", "show_welcome");
   apply_env_override("ARCHIUM_SHOW_TIPS", "show_tips");
   apply_env_override("ARCHIUM_CACHE_TTL_SECONDS", "cache_ttl_seconds");
+  apply_env_override("ARCHIUM_FUZZY_COMPLETION", "fuzzy_completion");
+  apply_env_override("ARCHIUM_CAPTURE_LIMIT_KB", "capture_limit_kb");
+  apply_env_override("ARCHIUM_COMMAND_TIMEOUT_SECONDS",
+                     "command_timeout_seconds");
+  apply_env_override("ARCHIUM_SCAN_THREADS", "scan_threads");
+  apply_env_override("ARCHIUM_ORPHANS_KEEP_OPTIONAL", "orphans_keep_optional");
+  apply_env_override("ARCHIUM_ORPHANS_KEEP_MAKE", "orphans_keep_make");
 }
 
-static int validate_preference_line(const char *line) {
-  if (!line) {
-    return 0;
-  }
-
-  if (line[0] == '\0' || line[0] == '#') {
-    return 1;
-  }
-
+static int split_preference_line(const char *line, char *key, char *value) {
   const char *sep = strchr(line, '=');
   if (!sep || sep == line || *(sep + 1) == '\0') {
     return 0;
   }
 
-  char key[CONFIG_KEY_MAX_LEN];
-  char value[CONFIG_VALUE_MAX_LEN];
   size_t key_len = (size_t)(sep - line);
   size_t value_len = strlen(sep + 1);
-
-  if (key_len == 0 || key_len >= sizeof(key) || value_len == 0 ||
-      value_len >= sizeof(value)) {
+  if (key_len >= CONFIG_KEY_MAX_LEN || value_len >= CONFIG_VALUE_MAX_LEN) {
     return 0;
   }
 
   memcpy(key, line, key_len);
   key[key_len] = '\0';
   memcpy(value, sep + 1, value_len + 1);
+  return 1;
+}
 
-  return validate_preference_key_value(key, value);
+static uint32_t preference_hash(const char *key) {
+  uint32_t hash = 2166136261u;
+  for (const unsigned char *p = (const unsigned char *)key; *p; p++) {
+    hash = (hash ^ *p) * 16777619u;
+  }
+  return hash;
 }
 
-static int copy_file_contents(const char *src_path, const char *dst_path) {
-  FILE *src = fopen(src_path, "r");
-  if (!src) {
-    return 0;
+static int preference_find(const PreferenceStore *store, const char *key) {
+  uint32_t index = preference_hash(key) & (PREFERENCE_TABLE_SIZE - 1);
+  for (int probe = 0; probe < PREFERENCE_TABLE_SIZE; probe++) {
+    const PreferenceSlot *slot = &store->slots[index];
+    if (!slot->used) {
+      return -1;
+    }
+    if (strcmp(slot->key, key) == 0) {
+      return (int)index;
+    }
+    index = (index + 1) & (PREFERENCE_TABLE_SIZE - 1);
   }
+  return -1;
+}
 
-  FILE *dst = fopen(dst_path, "w");
-  if (!dst) {
-    fclose(src);
-    return 0;
+static int preference_insert(PreferenceStore *store, const char *key,
+                             const char *value) {
+  uint32_t index = preference_hash(key) & (PREFERENCE_TABLE_SIZE - 1);
+  for (int probe = 0; probe < PREFERENCE_TABLE_SIZE; probe++) {
+    PreferenceSlot *slot = &store->slots[index];
+    if (!slot->used || strcmp(slot->key, key) == 0) {
+      snprintf(slot->key, sizeof(slot->key), "%s", key);
+      snprintf(slot->value, sizeof(slot->value), "%s", value);
+      slot->used = 1;
+      return (int)index;
+    }
+    index = (index + 1) & (PREFERENCE_TABLE_SIZE - 1);
   }
+  return -1;
+}
 
-  char buffer[CONFIG_BUFFER_SIZE];
-  size_t bytes_read = 0;
-  while ((bytes_read = fread(buffer, 1, sizeof(buffer), src)) > 0) {
-    if (fwrite(buffer, 1, bytes_read, dst) != bytes_read) {
-      fclose(src);
-      fclose(dst);
+static int preference_add_line(PreferenceStore *store, const char *text,
+                               int slot) {
+  if (store->line_count == store->line_capacity) {
+    size_t capacity = store->line_capacity ? store->line_capacity * 2 : 16;
+    PreferenceLine *grown =
+        realloc(store->lines, capacity * sizeof(*store->lines));
+    if (!grown) {
       return 0;
     }
+    store->lines = grown;
+    store->line_capacity = capacity;
   }
 
-  fclose(src);
-  fclose(dst);
+  char *copy = NULL;
+  if (text && !(copy = strdup(text))) {
+    return 0;
+  }
+  store->lines[store->line_count].text = copy;
+  store->lines[store->line_count].slot = slot;
+  store->line_count++;
   return 1;
 }
 
-static int validate_preferences_file(void) {
-  FILE *fp = fopen(preference_file_path, "r");
+static void preference_store_free(PreferenceStore *store) {
+  for (size_t i = 0; i < store->line_count; i++) {
+    free(store->lines[i].text);
+  }
+  free(store->lines);
+  memset(store, 0, sizeof(*store));
+}
+
+static int preference_store_load(PreferenceStore *store, const char *path,
+                                 int *all_valid) {
+  FILE *fp = fopen(path, "r");
   if (!fp) {
-    return 1;
+    return 0;
   }
 
   char line[CONFIG_BUFFER_SIZE];
   int line_number = 0;
-  int all_valid = 1;
+  int ok = 1;
 
-  while (fgets(line, sizeof(line), fp)) {
+  while (ok && fgets(line, sizeof(line), fp)) {
     line_number++;
     line[strcspn(line, "\n")] = '\0';
 
-    if (!validate_preference_line(line)) {
-      all_valid = 0;
+    char key[CONFIG_KEY_MAX_LEN];
+    char value[CONFIG_VALUE_MAX_LEN];
+    if (line[0] == '\0' || line[0] == '#') {
+      ok = preference_add_line(store, line, -1);
+      continue;
+    }
+
+    if (!split_preference_line(line, key, value) ||
+        !validate_preference_key_value(key, value)) {
+      *all_valid = 0;
       if (config.verbose) {
         char msg[CONFIG_BUFFER_SIZE];
         snprintf(msg, sizeof(msg), "Invalid preference on line %d",
                  line_number);
         log_debug(msg);
       }
+      ok = preference_add_line(store, line, -1);
+      continue;
     }
+
+    int slot = preference_find(store, key);
+    if (slot < 0) {
+      slot = preference_insert(store, key, value);
+    }
+    ok = slot >= 0 && preference_add_line(store, NULL, slot);
   }
 
   fclose(fp);
-  return all_valid;
+  return ok;
+}
+
+static int preference_store_write(const PreferenceStore *store,
+                                  const char *path) {
+  char temp_file[CONFIG_BUFFER_SIZE];
+  if (snprintf(temp_file, sizeof(temp_file), "%s.tmp", path) >=
+      (int)sizeof(temp_file)) {
+    return 0;
+  }
+
+  FILE *fp = fopen(temp_file, "w");
+  if (!fp) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < store->line_count; i++) {
+    const PreferenceLine *line = &store->lines[i];
+    if (line->slot >= 0) {
+      const PreferenceSlot *slot = &store->slots[line->slot];
+      fprintf(fp, "%s=%s\n", slot->key, slot->value);
+    } else {
+      fprintf(fp, "%s\n", line->text);
+    }
+  }
+
+  if (fclose(fp) != 0 || rename(temp_file, path) != 0) {
+    unlink(temp_file);
+    return 0;
+  }
+  return 1;
+}
+
+static struct {
+  int captured;
+  int json_output;
+  int batch_mode;
+  int use_native_output;
+} cli_flags;
+
+static void apply_stored_preferences(void) {
+  if (!cli_flags.captured) {
+    cli_flags.json_output = config.json_output;
+    cli_flags.batch_mode = config.batch_mode;
+    cli_flags.use_native_output = config.use_native_output;
+    cli_flags.captured = 1;
+  }
+
+  for (size_t i = 0; i < PREFERENCE_TABLE_SIZE; i++) {
+    if (preferences.slots[i].used) {
+      apply_preference_to_runtime(preferences.slots[i].key,
+                                  preferences.slots[i].value);
+    }
+  }
+  apply_environment_overrides();
+
+  if (cli_flags.json_output) {
+    config.json_output = 1;
+  }
+  if (cli_flags.batch_mode) {
+    config.batch_mode = 1;
+  }
+  if (!cli_flags.use_native_output) {
+    config.use_native_output = 0;
+  }
+}
+
+static int copy_file_contents(const char *src_path, const char *dst_path) {
+  FILE *src = fopen(src_path, "r");
+  if (!src) {
+    return 0;
+  }
+
+  FILE *dst = fopen(dst_path, "w");
+  if (!dst) {
+    fclose(src);
+    return 0;
+  }
+
+  char buffer[CONFIG_BUFFER_SIZE];
+  size_t bytes_read = 0;
+  while ((bytes_read = fread(buffer, 1, sizeof(buffer), src)) > 0) {
+    if (fwrite(buffer, 1, bytes_read, dst) != bytes_read) {
+      fclose(src);
+      fclose(dst);
+      return 0;
+    }
+  }
+
+  fclose(src);
+  fclose(dst);
+  return 1;
 }
 
 static int ensure_directory_exists(const char *path) {
@@ -290,6 +502,12 @@ static int ensure_preferences_file_exists(void) {
   fputs("show_welcome=1\n", fp);
   fputs("show_tips=1\n", fp);
   fputs("cache_ttl_seconds=3600\n", fp);
+  fputs("fuzzy_completion=1\n", fp);
+  fputs("capture_limit_kb=1024\n", fp);
+  fputs("command_timeout_seconds=0\n", fp);
+  fputs("scan_threads=0\n", fp);
+  fputs("orphans_keep_optional=1\n", fp);
+  fputs("orphans_keep_make=0\n", fp);
 
   fclose(fp);
   return 1;
@@ -392,20 +610,18 @@ int archium_config_init(void) {
 
   config_initialized = 1;
 
-  if (!validate_preferences_file()) {
+  int all_valid = 1;
+  if (!preference_store_load(&preferences, preference_file_path,
+                             &all_valid)) {
+    archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
+                         "Failed to read preferences file", NULL);
+  }
+  if (!all_valid) {
     archium_report_error(ARCHIUM_ERROR_CONFIG_INVALID,
                          "Preferences file contains invalid entries", NULL);
   }
 
-  apply_preference_if_exists("json_output");
-  apply_preference_if_exists("batch_mode");
-  apply_preference_if_exists("package_manager");
-  apply_preference_if_exists("use_native_output");
-  apply_preference_if_exists("show_welcome");
-  apply_preference_if_exists("show_tips");
-  apply_preference_if_exists("cache_ttl_seconds");
-
-  apply_environment_overrides();
+  apply_stored_preferences();
 
   return 1;
 }
@@ -490,55 +706,22 @@ int archium_config_set_preference(const char *key, const char *value) {
     return 0;
   }
 
-  FILE *fp = fopen(preference_file_path, "a+");
-  if (!fp) {
-    archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
-                         "Failed to open preferences file", NULL);
-    return 0;
-  }
-
-  char line[CONFIG_BUFFER_SIZE];
-  char temp_file[CONFIG_BUFFER_SIZE];
-  int ret =
-      snprintf(temp_file, sizeof(temp_file), "%s.tmp", preference_file_path);
-  if (ret >= (int)sizeof(temp_file)) {
-    fclose(fp);
-    archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
-                         "Temporary file path too long", NULL);
-    return 0;
-  }
-
-  FILE *temp_fp = fopen(temp_file, "w");
-  if (!temp_fp) {
-    fclose(fp);
-    archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
-                         "Failed to create temporary preferences file", NULL);
-    return 0;
-  }
-
-  int found = 0;
-  rewind(fp);
-  while (fgets(line, sizeof(line), fp)) {
-    line[strcspn(line, "\n")] = '\0';
-    if (strncmp(line, key, strlen(key)) == 0 && line[strlen(key)] == '=') {
-      fprintf(temp_fp, "%s=%s\n", key, value);
-      found = 1;
-    } else {
-      fprintf(temp_fp, "%s\n", line);
+  int slot = preference_find(&preferences, key);
+  if (slot >= 0) {
+    snprintf(preferences.slots[slot].value,
+             sizeof(preferences.slots[slot].value), "%s", value);
+  } else {
+    slot = preference_insert(&preferences, key, value);
+    if (slot < 0 || !preference_add_line(&preferences, NULL, slot)) {
+      archium_report_error(ARCHIUM_ERROR_MEMORY_ALLOCATION,
+                           "Failed to store preference", key);
+      return 0;
     }
   }
 
-  if (!found) {
-    fprintf(temp_fp, "%s=%s\n", key, value);
-  }
-
   apply_preference_to_runtime(key, value);
 
-  fclose(fp);
-  fclose(temp_fp);
-
-  if (rename(temp_file, preference_file_path) != 0) {
-    unlink(temp_file);
+  if (!preference_store_write(&preferences, preference_file_path)) {
     archium_report_error(ARCHIUM_ERROR_SYSTEM_CALL,
                          "Failed to update preferences file", NULL);
     return 0;
@@ -556,25 +739,8 @@ char *archium_config_get_preference(const char *key) {
     return NULL;
   }
 
-  FILE *fp = fopen(preference_file_path, "r");
-  if (!fp) {
-    return NULL;
-  }
-
-  char line[CONFIG_BUFFER_SIZE];
-  while (fgets(line, sizeof(line), fp)) {
-    line[strcspn(line, "\n")] = '\0';
-    if (!validate_preference_line(line)) {
-      continue;
-    }
-    if (strncmp(line, key, strlen(key)) == 0 && line[strlen(key)] == '=') {
-      fclose(fp);
-      return strdup(line + strlen(key) + 1);
-    }
-  }
-
-  fclose(fp);
-  return NULL;
+  int slot = preference_find(&preferences, key);
+  return slot >= 0 ? strdup(preferences.slots[slot].value) : NULL;
 }
 
 int archium_config_export_preferences(const char *file_path) {
@@ -609,53 +775,18 @@ int archium_config_import_preferences(const char *file_path) {
     return 0;
   }
 
-  FILE *src = fopen(file_path, "r");
-  if (!src) {
-    return 0;
-  }
-
-  char temp_file[CONFIG_BUFFER_SIZE];
-  if (snprintf(temp_file, sizeof(temp_file), "%s.import.tmp",
-               preference_file_path) >= (int)sizeof(temp_file)) {
-    fclose(src);
-    return 0;
-  }
-
-  FILE *temp = fopen(temp_file, "w");
-  if (!temp) {
-    fclose(src);
-    return 0;
-  }
-
-  char line[CONFIG_BUFFER_SIZE];
+  PreferenceStore imported;
+  memset(&imported, 0, sizeof(imported));
   int valid = 1;
-  while (fgets(line, sizeof(line), src)) {
-    line[strcspn(line, "\n")] = '\0';
-
-    if (!validate_preference_line(line)) {
-      valid = 0;
-      break;
-    }
-
-    fprintf(temp, "%s\n", line);
-  }
-
-  fclose(src);
-  fclose(temp);
-
-  if (!valid || rename(temp_file, preference_file_path) != 0) {
-    unlink(temp_file);
+  if (!preference_store_load(&imported, file_path, &valid) || !valid ||
+      !preference_store_write(&imported, preference_file_path)) {
+    preference_store_free(&imported);
     return 0;
   }
 
-  apply_preference_if_exists("json_output");
-  apply_preference_if_exists("batch_mode");
-  apply_preference_if_exists("package_manager");
-  apply_preference_if_exists("use_native_output");
-  apply_preference_if_exists("show_welcome");
-  apply_preference_if_exists("show_tips");
-  apply_preference_if_exists("cache_ttl_seconds");
-  apply_environment_overrides();
+  preference_store_free(&preferences);
+  preferences = imported;
+  apply_stored_preferences();
 
   return 1;
 }
@@ -707,6 +838,14 @@ void archium_config_print_effective(FILE *out) {
   fprintf(target, "  show_welcome=%d\n", config.show_welcome);
   fprintf(target, "  show_tips=%d\n", config.show_tips);
   fprintf(target, "  cache_ttl_seconds=%d\n", config.cache_ttl_seconds);
+  fprintf(target, "  fuzzy_completion=%d\n", config.fuzzy_completion);
+  fprintf(target, "  capture_limit_kb=%d\n", config.capture_limit_kb);
+  fprintf(target, "  command_timeout_seconds=%d\n",
+          config.command_timeout_seconds);
+  fprintf(target, "  scan_threads=%d\n", config.scan_threads);
+  fprintf(target, "  orphans_keep_optional=%d\n",
+          config.orphans_keep_optional);
+  fprintf(target, "  orphans_keep_make=%d\n", config.orphans_keep_make);
 }
 
 void archium_config_write_log(const char *level, const char *message) {
@@ -719,19 +858,8 @@ void archium_config_write_log(const char *level, const char *message) {
     return;
   }
 
-  FILE *fp = fopen(log_file_path, "a");
-  if (!fp) {
+  if (!archium_logger_open(log_file_path) ||
+      !archium_logger_write(level, message)) {
     fprintf(stderr, "[%s] %s\n", level, message);
-    return;
   }
-
-  time_t now;
-  char timestamp[26];
-
-  time(&now);
-  ctime_r(&now, timestamp);
-  timestamp[24] = '\0';
-
-  fprintf(fp, "[%s] [%s] %s\n", timestamp, level, message);
-  fclose(fp);
 }
@@ -0,0 +1,964 @@
+#include <stdint.h>
+
+#include "include/archium.h"
+
+#define INTERN_INITIAL_SLOTS 1024
+#define INTERN_INITIAL_STRINGS (64 * 1024)
+
+typedef enum {
+  DEP_ANY,
+  DEP_EQ,
+  DEP_LT,
+  DEP_LE,
+  DEP_GT,
+  DEP_GE,
+} DepOperator;
+
+typedef struct {
+  uint32_t name;
+  uint32_t node;
+  uint32_t version;
+} ProvideEntry;
+
+typedef struct {
+  const char *version;
+  size_t version_length;
+  uint8_t op;
+} EdgeConstraint;
+
+typedef enum { TREE_UNSEEN, TREE_ON_PATH, TREE_DONE } TreeState;
+
+typedef struct {
+  uint32_t node;
+  uint32_t position;
+  uint32_t end;
+} TreeFrame;
+
+static int rpmvercmp(const char *a, size_t a_length, const char *b,
+                     size_t b_length) {
+  if (a_length == b_length && memcmp(a, b, a_length) == 0) {
+    return 0;
+  }
+
+  const char *one = a;
+  const char *two = b;
+  const char *one_end = a + a_length;
+  const char *two_end = b + b_length;
+
+  while (one < one_end && two < two_end) {
+    const char *separator_one = one;
+    const char *separator_two = two;
+    while (one < one_end && !isalnum((unsigned char)*one)) {
+      one++;
+    }
+    while (two < two_end && !isalnum((unsigned char)*two)) {
+      two++;
+    }
+    if (one == one_end || two == two_end) {
+      break;
+    }
+    if (one - separator_one != two - separator_two) {
+      return one - separator_one < two - separator_two ? -1 : 1;
+    }
+
+    const char *segment_one = one;
+    const char *segment_two = two;
+    int numeric = isdigit((unsigned char)*one);
+    if (numeric) {
+      while (one < one_end && isdigit((unsigned char)*one)) {
+        one++;
+      }
+      while (two < two_end && isdigit((unsigned char)*two)) {
+        two++;
+      }
+    } else {
+      while (one < one_end && isalpha((unsigned char)*one)) {
+        one++;
+      }
+      while (two < two_end && isalpha((unsigned char)*two)) {
+        two++;
+      }
+    }
+
+    if (two == segment_two) {
+      return numeric ? 1 : -1;
+    }
+
+    if (numeric) {
+      while (segment_one < one && *segment_one == '0') {
+        segment_one++;
+      }
+      while (segment_two < two && *segment_two == '0') {
+        segment_two++;
+      }
+      if (one - segment_one != two - segment_two) {
+        return one - segment_one < two - segment_two ? -1 : 1;
+      }
+    }
+
+    size_t length_one = (size_t)(one - segment_one);
+    size_t length_two = (size_t)(two - segment_two);
+    int cmp = memcmp(segment_one, segment_two,
+                     length_one < length_two ? length_one : length_two);
+    if (cmp == 0 && length_one != length_two) {
+      cmp = length_one < length_two ? -1 : 1;
+    }
+    if (cmp != 0) {
+      return cmp < 0 ? -1 : 1;
+    }
+  }
+
+  if (one == one_end && two == two_end) {
+    return 0;
+  }
+  if ((one == one_end && !isalpha((unsigned char)*two)) ||
+      (one < one_end && isalpha((unsigned char)*one))) {
+    return -1;
+  }
+  return 1;
+}
+
+typedef struct {
+  const char *epoch;
+  size_t epoch_length;
+  const char *version;
+  size_t version_length;
+  const char *release;
+  size_t release_length;
+} Evr;
+
+static void parse_evr(const char *text, size_t length, Evr *evr) {
+  const char *end = text + length;
+  const char *cursor = text;
+  while (cursor < end && isdigit((unsigned char)*cursor)) {
+    cursor++;
+  }
+
+  evr->epoch = "0";
+  evr->epoch_length = 1;
+  const char *version = text;
+  if (cursor < end && *cursor == ':') {
+    if (cursor > text) {
+      evr->epoch = text;
+      evr->epoch_length = (size_t)(cursor - text);
+    }
+    version = cursor + 1;
+  }
+
+  const char *dash = NULL;
+  for (const char *p = version; p < end; p++) {
+    if (*p == '-') {
+      dash = p;
+    }
+  }
+
+  evr->version = version;
+  evr->version_length = (size_t)((dash ? dash : end) - version);
+  evr->release = dash ? dash + 1 : NULL;
+  evr->release_length = dash ? (size_t)(end - dash - 1) : 0;
+}
+
+static int vercmp_length(const char *a, size_t a_length, const char *b,
+                         size_t b_length) {
+  if (a_length == b_length && memcmp(a, b, a_length) == 0) {
+    return 0;
+  }
+
+  Evr left;
+  Evr right;
+  parse_evr(a, a_length, &left);
+  parse_evr(b, b_length, &right);
+
+  int cmp = rpmvercmp(left.epoch, left.epoch_length, right.epoch,
+                      right.epoch_length);
+  if (cmp == 0) {
+    cmp = rpmvercmp(left.version, left.version_length, right.version,
+                    right.version_length);
+  }
+  if (cmp == 0 && left.release && right.release) {
+    cmp = rpmvercmp(left.release, left.release_length, right.release,
+                    right.release_length);
+  }
+  return cmp;
+}
+
+int archium_vercmp(const char *a, const char *b) {
+  return vercmp_length(a, strlen(a), b, strlen(b));
+}
+
+static uint64_t hash_bytes(const char *text, size_t length) {
+  uint64_t hash = 1469598103934665603ull;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)text[i];
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+static int intern_rehash(ArchiumInternTable *table, uint32_t slot_count) {
+  uint32_t *slots = calloc(slot_count, sizeof(*slots));
+  if (!slots) {
+    return 0;
+  }
+
+  for (uint32_t id = 0; id < table->count; id++) {
+    const char *text = table->strings + table->offsets[id];
+    uint64_t slot = hash_bytes(text, strlen(text)) & (slot_count - 1);
+    while (slots[slot] != 0) {
+      slot = (slot + 1) & (slot_count - 1);
+    }
+    slots[slot] = id + 1;
+  }
+
+  free(table->slots);
+  table->slots = slots;
+  table->slot_count = slot_count;
+  return 1;
+}
+
+static uint32_t intern_lookup(const ArchiumInternTable *table,
+                              const char *text, size_t length) {
+  if (table->slot_count == 0) {
+    return ARCHIUM_DEPGRAPH_NONE;
+  }
+
+  uint64_t slot = hash_bytes(text, length) & (table->slot_count - 1);
+  while (table->slots[slot] != 0) {
+    uint32_t id = table->slots[slot] - 1;
+    const char *candidate = table->strings + table->offsets[id];
+    if (strncmp(candidate, text, length) == 0 && candidate[length] == '\0') {
+      return id;
+    }
+    slot = (slot + 1) & (table->slot_count - 1);
+  }
+  return ARCHIUM_DEPGRAPH_NONE;
+}
+
+static uint32_t intern(ArchiumInternTable *table, const char *text,
+                       size_t length) {
+  uint32_t id = intern_lookup(table, text, length);
+  if (id != ARCHIUM_DEPGRAPH_NONE) {
+    return id;
+  }
+
+  if ((table->count + 1) * 2 > table->slot_count &&
+      !intern_rehash(table, table->slot_count ? table->slot_count * 2
+                                              : INTERN_INITIAL_SLOTS)) {
+    return ARCHIUM_DEPGRAPH_NONE;
+  }
+
+  if (table->count == table->capacity) {
+    uint32_t capacity = table->capacity ? table->capacity * 2
+                                        : INTERN_INITIAL_SLOTS / 2;
+    uint32_t *offsets =
+        realloc(table->offsets, (size_t)capacity * sizeof(*offsets));
+    if (!offsets) {
+      return ARCHIUM_DEPGRAPH_NONE;
+    }
+    table->offsets = offsets;
+    table->capacity = capacity;
+  }
+
+  if (length >= UINT32_MAX - table->strings_size) {
+    return ARCHIUM_DEPGRAPH_NONE;
+  }
+  if (table->strings_size + length + 1 > table->strings_capacity) {
+    uint32_t capacity = table->strings_capacity ? table->strings_capacity
+                                                : INTERN_INITIAL_STRINGS;
+    while (table->strings_size + length + 1 > capacity) {
+      capacity *= 2;
+    }
+    char *strings = realloc(table->strings, capacity);
+    if (!strings) {
+      return ARCHIUM_DEPGRAPH_NONE;
+    }
+    table->strings = strings;
+    table->strings_capacity = capacity;
+  }
+
+  id = table->count++;
+  table->offsets[id] = table->strings_size;
+  memcpy(table->strings + table->strings_size, text, length);
+  table->strings[table->strings_size + length] = '\0';
+  table->strings_size += (uint32_t)length + 1;
+
+  uint64_t slot = hash_bytes(text, length) & (table->slot_count - 1);
+  while (table->slots[slot] != 0) {
+    slot = (slot + 1) & (table->slot_count - 1);
+  }
+  table->slots[slot] = id + 1;
+  return id;
+}
+
+static size_t parse_dep(const char *dep, int optional, size_t *name_length,
+                        EdgeConstraint *constraint) {
+  size_t length = strlen(dep);
+  if (optional) {
+    const char *description = strstr(dep, ": ");
+    if (description) {
+      length = (size_t)(description - dep);
+    }
+  }
+
+  size_t name = strcspn(dep, "<>=");
+  if (name > length) {
+    name = length;
+  }
+  *name_length = name;
+
+  constraint->op = DEP_ANY;
+  constraint->version = NULL;
+  constraint->version_length = 0;
+  if (name == length) {
+    return length;
+  }
+
+  const char *op = dep + name;
+  size_t op_length = 1;
+  if (op[0] == '=') {
+    constraint->op = DEP_EQ;
+  } else if (op[1] == '=') {
+    constraint->op = op[0] == '<' ? DEP_LE : DEP_GE;
+    op_length = 2;
+  } else {
+    constraint->op = op[0] == '<' ? DEP_LT : DEP_GT;
+  }
+  constraint->version = op + op_length;
+  constraint->version_length = length - name - op_length;
+  return length;
+}
+
+static int version_satisfies(const char *version, const EdgeConstraint *c) {
+  if (c->op == DEP_ANY) {
+    return 1;
+  }
+
+  int cmp =
+      vercmp_length(version, strlen(version), c->version, c->version_length);
+  switch (c->op) {
+    case DEP_EQ:
+      return cmp == 0;
+    case DEP_LT:
+      return cmp < 0;
+    case DEP_LE:
+      return cmp <= 0;
+    case DEP_GT:
+      return cmp > 0;
+    case DEP_GE:
+      return cmp >= 0;
+    default:
+      return 1;
+  }
+}
+
+static int provide_satisfies(const ArchiumDepGraph *graph, uint32_t provide,
+                             const EdgeConstraint *constraint) {
+  return constraint->op == DEP_ANY ||
+         (graph->provide_version[provide] != ARCHIUM_DEPGRAPH_NONE &&
+          version_satisfies(
+              archium_depgraph_string(graph, graph->provide_version[provide]),
+              constraint));
+}
+
+/*
+ * Like pacman, an installed package that satisfies the dependency wins over a
+ * repo package, even one with the exact name: iptables-nft satisfies
+ * "iptables" on a system that has it installed. Only when nothing satisfies
+ * the constraint do we fall back to the closest name match.
+ */
+static uint32_t resolve_dep(const ArchiumDepGraph *graph, uint32_t name,
+                            const EdgeConstraint *constraint) {
+  uint32_t by_name = graph->name_node[name];
+  int by_name_satisfies =
+      by_name != ARCHIUM_DEPGRAPH_NONE &&
+      version_satisfies(
+          archium_depgraph_string(graph, graph->node_version[by_name]),
+          constraint);
+  uint32_t first = graph->provide_first[name];
+  uint32_t last = graph->provide_first[name + 1];
+
+  for (int installed_only = 1; installed_only >= 0; installed_only--) {
+    if (by_name_satisfies &&
+        (!installed_only || graph->node_installed[by_name])) {
+      return by_name;
+    }
+    for (uint32_t i = first; i < last; i++) {
+      uint32_t node = graph->provide_node[i];
+      if ((!installed_only || graph->node_installed[node]) &&
+          provide_satisfies(graph, i, constraint)) {
+        return node;
+      }
+    }
+  }
+
+  if (by_name != ARCHIUM_DEPGRAPH_NONE && graph->node_installed[by_name]) {
+    return by_name;
+  }
+  for (uint32_t i = first; i < last; i++) {
+    if (graph->node_installed[graph->provide_node[i]]) {
+      return graph->provide_node[i];
+    }
+  }
+  if (by_name != ARCHIUM_DEPGRAPH_NONE) {
+    return by_name;
+  }
+  return first < last ? graph->provide_node[first] : ARCHIUM_DEPGRAPH_NONE;
+}
+
+static int grow_u32(uint32_t **array, uint32_t *capacity, uint32_t needed) {
+  if (needed <= *capacity) {
+    return 1;
+  }
+  uint32_t grown = *capacity ? *capacity : 1024;
+  while (grown < needed) {
+    grown *= 2;
+  }
+  uint32_t *resized = realloc(*array, (size_t)grown * sizeof(**array));
+  if (!resized) {
+    return 0;
+  }
+  *array = resized;
+  *capacity = grown;
+  return 1;
+}
+
+static uint32_t *counts_to_offsets(const uint32_t *keys, uint32_t count,
+                                   uint32_t key_count) {
+  uint32_t *first = calloc((size_t)key_count + 1, sizeof(*first));
+  if (!first) {
+    return NULL;
+  }
+  for (uint32_t i = 0; i < count; i++) {
+    first[keys[i] + 1]++;
+  }
+  for (uint32_t i = 0; i < key_count; i++) {
+    first[i + 1] += first[i];
+  }
+  return first;
+}
+
+static int build_nodes(ArchiumDepGraph *graph, const ArchiumLocalDb **sources,
+                       uint32_t *node_source, uint32_t *node_package) {
+  uint32_t name_node_capacity = 0;
+  for (uint32_t s = 0; s < 2; s++) {
+    const ArchiumLocalDb *db = sources[s];
+    for (uint32_t i = 0; db && i < db->count; i++) {
+      const char *name = archium_localdb_name(db, i);
+      uint32_t id = intern(&graph->names, name, strlen(name));
+      if (id == ARCHIUM_DEPGRAPH_NONE) {
+        return 0;
+      }
+
+      uint32_t old_capacity = name_node_capacity;
+      if (!grow_u32(&graph->name_node, &name_node_capacity, id + 1)) {
+        return 0;
+      }
+      for (uint32_t j = old_capacity; j < name_node_capacity; j++) {
+        graph->name_node[j] = ARCHIUM_DEPGRAPH_NONE;
+      }
+      if (graph->name_node[id] != ARCHIUM_DEPGRAPH_NONE) {
+        continue;
+      }
+
+      const char *version = archium_localdb_version(db, i);
+      uint32_t node = graph->node_count++;
+      graph->name_node[id] = node;
+      graph->node_name[node] = id;
+      graph->node_version[node] = intern(&graph->names, version,
+                                         strlen(version));
+      graph->node_installed[node] = s == 0;
+      graph->node_explicit[node] =
+          s == 0 && db->reason[i] == ARCHIUM_LOCALDB_REASON_EXPLICIT;
+      node_source[node] = s;
+      node_package[node] = i;
+      if (graph->node_version[node] == ARCHIUM_DEPGRAPH_NONE) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static int build_provides(ArchiumDepGraph *graph,
+                          const ArchiumLocalDb **sources,
+                          const uint32_t *node_source,
+                          const uint32_t *node_package,
+                          ProvideEntry **provides, uint32_t *count) {
+  uint32_t capacity = 0;
+  *provides = NULL;
+  *count = 0;
+
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    const ArchiumLocalDb *db = sources[node_source[node]];
+    uint32_t length;
+    const uint32_t *items = archium_localdb_list(
+        db, node_package[node], ARCHIUM_LOCALDB_PROVIDES, &length);
+    for (uint32_t i = 0; i < length; i++) {
+      const char *provide = archium_localdb_string(db, items[i]);
+      size_t name_length;
+      EdgeConstraint constraint;
+      parse_dep(provide, 0, &name_length, &constraint);
+
+      if (*count == capacity) {
+        uint32_t grown = capacity ? capacity * 2 : 1024;
+        ProvideEntry *resized =
+            realloc(*provides, (size_t)grown * sizeof(**provides));
+        if (!resized) {
+          return 0;
+        }
+        *provides = resized;
+        capacity = grown;
+      }
+
+      ProvideEntry *entry = &(*provides)[(*count)++];
+      entry->name = intern(&graph->names, provide, name_length);
+      entry->node = node;
+      entry->version = ARCHIUM_DEPGRAPH_NONE;
+      if (constraint.op == DEP_EQ) {
+        entry->version = intern(&graph->names, constraint.version,
+                                constraint.version_length);
+        if (entry->version == ARCHIUM_DEPGRAPH_NONE) {
+          return 0;
+        }
+      }
+      if (entry->name == ARCHIUM_DEPGRAPH_NONE) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+static const uint32_t *edge_list(const ArchiumLocalDb **sources,
+                                 uint32_t source, uint32_t package,
+                                 ArchiumLocalDbList list, uint32_t *length,
+                                 const ArchiumLocalDb **owner) {
+  const ArchiumLocalDb *db = sources[source];
+  const uint32_t *items = archium_localdb_list(db, package, list, length);
+  *owner = db;
+
+  const ArchiumLocalDb *sync = sources[1];
+  if (*length == 0 && list == ARCHIUM_LOCALDB_MAKEDEPENDS && source == 0 &&
+      sync) {
+    const char *name = archium_localdb_name(db, package);
+    int64_t match = archium_localdb_find(sync, name, strlen(name));
+    if (match >= 0) {
+      items = archium_localdb_list(sync, (uint32_t)match, list, length);
+      *owner = sync;
+    }
+  }
+  return items;
+}
+
+static int build_edges(ArchiumDepGraph *graph, const ArchiumLocalDb **sources,
+                       const uint32_t *node_source,
+                       const uint32_t *node_package,
+                       EdgeConstraint **constraints) {
+  static const struct {
+    ArchiumLocalDbList list;
+    ArchiumEdgeKind kind;
+  } edge_lists[] = {
+      {ARCHIUM_LOCALDB_DEPENDS, ARCHIUM_EDGE_DEPEND},
+      {ARCHIUM_LOCALDB_OPTDEPENDS, ARCHIUM_EDGE_OPTDEPEND},
+      {ARCHIUM_LOCALDB_MAKEDEPENDS, ARCHIUM_EDGE_MAKEDEPEND},
+  };
+
+  uint32_t total = 0;
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    for (size_t l = 0; l < sizeof(edge_lists) / sizeof(edge_lists[0]); l++) {
+      uint32_t length;
+      const ArchiumLocalDb *owner;
+      edge_list(sources, node_source[node], node_package[node],
+                edge_lists[l].list, &length, &owner);
+      total += length;
+    }
+  }
+
+  size_t slots = total ? total : 1;
+  graph->edge_source = malloc(slots * sizeof(*graph->edge_source));
+  graph->edge_target = malloc(slots * sizeof(*graph->edge_target));
+  graph->edge_name = malloc(slots * sizeof(*graph->edge_name));
+  graph->edge_kind = malloc(slots * sizeof(*graph->edge_kind));
+  *constraints = malloc(slots * sizeof(**constraints));
+  if (!graph->edge_source || !graph->edge_target || !graph->edge_name ||
+      !graph->edge_kind || !*constraints) {
+    return 0;
+  }
+
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    for (size_t l = 0; l < sizeof(edge_lists) / sizeof(edge_lists[0]); l++) {
+      uint32_t length;
+      const ArchiumLocalDb *owner;
+      const uint32_t *items =
+          edge_list(sources, node_source[node], node_package[node],
+                    edge_lists[l].list, &length, &owner);
+      for (uint32_t i = 0; i < length; i++) {
+        const char *dep = archium_localdb_string(owner, items[i]);
+        size_t name_length;
+        uint32_t edge = graph->edge_count++;
+        parse_dep(dep, edge_lists[l].kind == ARCHIUM_EDGE_OPTDEPEND,
+                  &name_length, &(*constraints)[edge]);
+        graph->edge_source[edge] = node;
+        graph->edge_name[edge] = intern(&graph->names, dep, name_length);
+        graph->edge_kind[edge] = (uint8_t)edge_lists[l].kind;
+        if (graph->edge_name[edge] == ARCHIUM_DEPGRAPH_NONE) {
+          return 0;
+        }
+      }
+    }
+  }
+  return 1;
+}
+
+static int build_adjacency(ArchiumDepGraph *graph,
+                           const ProvideEntry *provides,
+                           uint32_t provide_count,
+                           const EdgeConstraint *constraints) {
+  uint32_t name_count = graph->names.count;
+  uint32_t *name_node =
+      realloc(graph->name_node, ((size_t)name_count + 1) * sizeof(*name_node));
+  if (!name_node) {
+    return 0;
+  }
+  graph->name_node = name_node;
+  for (uint32_t id = 0; id < name_count; id++) {
+    name_node[id] = ARCHIUM_DEPGRAPH_NONE;
+  }
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    name_node[graph->node_name[node]] = node;
+  }
+
+  uint32_t *provide_names =
+      malloc(((size_t)provide_count + 1) * sizeof(*provide_names));
+  if (!provide_names) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < provide_count; i++) {
+    provide_names[i] = provides[i].name;
+  }
+  graph->provide_first =
+      counts_to_offsets(provide_names, provide_count, name_count);
+  free(provide_names);
+  size_t provide_slots = provide_count ? provide_count : 1;
+  graph->provide_node = malloc(provide_slots * sizeof(*graph->provide_node));
+  graph->provide_version =
+      malloc(provide_slots * sizeof(*graph->provide_version));
+  uint32_t *fill = calloc((size_t)name_count + 1, sizeof(*fill));
+  if (!graph->provide_first || !graph->provide_node ||
+      !graph->provide_version || !fill) {
+    free(fill);
+    return 0;
+  }
+  for (uint32_t i = 0; i < provide_count; i++) {
+    uint32_t slot = graph->provide_first[provides[i].name] +
+                    fill[provides[i].name]++;
+    graph->provide_node[slot] = provides[i].node;
+    graph->provide_version[slot] = provides[i].version;
+  }
+  free(fill);
+
+  uint32_t kept = 0;
+  uint32_t source_start = 0;
+  for (uint32_t edge = 0; edge < graph->edge_count; edge++) {
+    uint32_t source = graph->edge_source[edge];
+    uint32_t target =
+        resolve_dep(graph, graph->edge_name[edge], &constraints[edge]);
+    if (kept == 0 || graph->edge_source[kept - 1] != source) {
+      source_start = kept;
+    }
+
+    int duplicate = 0;
+    for (uint32_t i = source_start;
+         target != ARCHIUM_DEPGRAPH_NONE && i < kept && !duplicate; i++) {
+      duplicate = graph->edge_target[i] == target &&
+                  graph->edge_kind[i] == graph->edge_kind[edge];
+    }
+    if (duplicate) {
+      continue;
+    }
+
+    graph->edge_source[kept] = source;
+    graph->edge_target[kept] = target;
+    graph->edge_name[kept] = graph->edge_name[edge];
+    graph->edge_kind[kept] = graph->edge_kind[edge];
+    kept++;
+  }
+  graph->edge_count = kept;
+
+  graph->forward_first = counts_to_offsets(graph->edge_source,
+                                           graph->edge_count,
+                                           graph->node_count);
+  if (!graph->forward_first) {
+    return 0;
+  }
+
+  uint32_t resolved = 0;
+  for (uint32_t edge = 0; edge < graph->edge_count; edge++) {
+    if (graph->edge_target[edge] != ARCHIUM_DEPGRAPH_NONE) {
+      resolved++;
+    }
+  }
+  graph->reverse_first =
+      calloc((size_t)graph->node_count + 1, sizeof(*graph->reverse_first));
+  graph->reverse_edge =
+      malloc((resolved ? resolved : 1) * sizeof(*graph->reverse_edge));
+  fill = calloc((size_t)graph->node_count + 1, sizeof(*fill));
+  if (!graph->reverse_first || !graph->reverse_edge || !fill) {
+    free(fill);
+    return 0;
+  }
+  for (uint32_t edge = 0; edge < graph->edge_count; edge++) {
+    if (graph->edge_target[edge] != ARCHIUM_DEPGRAPH_NONE) {
+      graph->reverse_first[graph->edge_target[edge] + 1]++;
+    }
+  }
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    graph->reverse_first[node + 1] += graph->reverse_first[node];
+  }
+  for (uint32_t edge = 0; edge < graph->edge_count; edge++) {
+    uint32_t target = graph->edge_target[edge];
+    if (target != ARCHIUM_DEPGRAPH_NONE) {
+      graph->reverse_edge[graph->reverse_first[target] + fill[target]++] =
+          edge;
+    }
+  }
+  free(fill);
+  return 1;
+}
+
+int archium_depgraph_build(ArchiumDepGraph *graph, const ArchiumLocalDb *local,
+                           const ArchiumLocalDb *sync) {
+  memset(graph, 0, sizeof(*graph));
+
+  const ArchiumLocalDb *sources[2] = {local, sync};
+  size_t capacity = (size_t)(local ? local->count : 0) +
+                    (sync ? sync->count : 0);
+  if (capacity == 0) {
+    capacity = 1;
+  }
+  if (capacity > UINT32_MAX / 2) {
+    return 0;
+  }
+
+  graph->node_name = malloc(capacity * sizeof(*graph->node_name));
+  graph->node_version = malloc(capacity * sizeof(*graph->node_version));
+  graph->node_installed = malloc(capacity);
+  graph->node_explicit = malloc(capacity);
+  uint32_t *node_source = malloc(capacity * sizeof(*node_source));
+  uint32_t *node_package = malloc(capacity * sizeof(*node_package));
+  ProvideEntry *provides = NULL;
+  uint32_t provide_count = 0;
+  EdgeConstraint *constraints = NULL;
+
+  int ok = graph->node_name && graph->node_version &&
+           graph->node_installed && graph->node_explicit && node_source &&
+           node_package &&
+           build_nodes(graph, sources, node_source, node_package) &&
+           build_provides(graph, sources, node_source, node_package,
+                          &provides, &provide_count) &&
+           build_edges(graph, sources, node_source, node_package,
+                       &constraints) &&
+           build_adjacency(graph, provides, provide_count, constraints);
+
+  free(node_source);
+  free(node_package);
+  free(provides);
+  free(constraints);
+
+  if (!ok) {
+    archium_depgraph_free(graph);
+  }
+  return ok;
+}
+
+void archium_depgraph_free(ArchiumDepGraph *graph) {
+  free(graph->names.strings);
+  free(graph->names.offsets);
+  free(graph->names.slots);
+  free(graph->name_node);
+  free(graph->node_name);
+  free(graph->node_version);
+  free(graph->node_installed);
+  free(graph->node_explicit);
+  free(graph->provide_first);
+  free(graph->provide_node);
+  free(graph->provide_version);
+  free(graph->forward_first);
+  free(graph->edge_source);
+  free(graph->edge_target);
+  free(graph->edge_name);
+  free(graph->edge_kind);
+  free(graph->reverse_first);
+  free(graph->reverse_edge);
+  memset(graph, 0, sizeof(*graph));
+}
+
+uint32_t archium_depgraph_find(const ArchiumDepGraph *graph,
+                               const char *name) {
+  uint32_t id = intern_lookup(&graph->names, name, strlen(name));
+  return id == ARCHIUM_DEPGRAPH_NONE ? id : graph->name_node[id];
+}
+
+const char *archium_depgraph_string(const ArchiumDepGraph *graph,
+                                    uint32_t id) {
+  return graph->names.strings + graph->names.offsets[id];
+}
+
+int archium_depgraph_find_orphans(const ArchiumDepGraph *graph,
+                                  unsigned int keep, uint32_t **orphans,
+                                  uint32_t *count) {
+  *orphans = NULL;
+  *count = 0;
+
+  uint8_t *marked = calloc(graph->node_count ? graph->node_count : 1, 1);
+  uint32_t *stack =
+      malloc((graph->node_count ? graph->node_count : 1) * sizeof(*stack));
+  if (!marked || !stack) {
+    free(marked);
+    free(stack);
+    return 0;
+  }
+
+  uint32_t top = 0;
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    if (graph->node_installed[node] && graph->node_explicit[node]) {
+      marked[node] = 1;
+      stack[top++] = node;
+    }
+  }
+
+  while (top > 0) {
+    uint32_t node = stack[--top];
+    for (uint32_t edge = graph->forward_first[node];
+         edge < graph->forward_first[node + 1]; edge++) {
+      uint32_t target = graph->edge_target[edge];
+      uint8_t kind = graph->edge_kind[edge];
+      if (target == ARCHIUM_DEPGRAPH_NONE || marked[target] ||
+          !graph->node_installed[target] ||
+          (kind == ARCHIUM_EDGE_OPTDEPEND &&
+           !(keep & ARCHIUM_ORPHAN_KEEP_OPTIONAL)) ||
+          (kind == ARCHIUM_EDGE_MAKEDEPEND &&
+           !(keep & ARCHIUM_ORPHAN_KEEP_MAKE))) {
+        continue;
+      }
+      marked[target] = 1;
+      stack[top++] = target;
+    }
+  }
+
+  for (uint32_t node = 0; node < graph->node_count; node++) {
+    if (graph->node_installed[node] && !marked[node]) {
+      stack[(*count)++] = node;
+    }
+  }
+  free(marked);
+
+  if (*count == 0) {
+    free(stack);
+    return 1;
+  }
+  *orphans = stack;
+  return 1;
+}
+
+static int tree_edge_visible(const ArchiumDepGraph *graph, int reverse,
+                             uint32_t edge) {
+  if (graph->edge_kind[edge] != ARCHIUM_EDGE_DEPEND) {
+    return 0;
+  }
+  return !reverse || graph->node_installed[graph->edge_source[edge]];
+}
+
+static uint32_t tree_edge_at(const ArchiumDepGraph *graph, int reverse,
+                             uint32_t position) {
+  return reverse ? graph->reverse_edge[position] : position;
+}
+
+static uint32_t tree_advance(const ArchiumDepGraph *graph, int reverse,
+                             uint32_t position, uint32_t end) {
+  while (position < end &&
+         !tree_edge_visible(graph, reverse,
+                            tree_edge_at(graph, reverse, position))) {
+    position++;
+  }
+  return position;
+}
+
+static void tree_push(const ArchiumDepGraph *graph, int reverse,
+                      TreeFrame *frame, uint32_t node) {
+  const uint32_t *first =
+      reverse ? graph->reverse_first : graph->forward_first;
+  frame->node = node;
+  frame->end = first[node + 1];
+  frame->position = tree_advance(graph, reverse, first[node], frame->end);
+}
+
+void archium_depgraph_print_tree(const ArchiumDepGraph *graph, uint32_t root,
+                                 int reverse, int max_depth) {
+  uint8_t *state = calloc(graph->node_count, 1);
+  TreeFrame *stack = malloc(((size_t)graph->node_count + 1) * sizeof(*stack));
+  if (!state || !stack) {
+    free(state);
+    free(stack);
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    return;
+  }
+
+  printf("%s\n", archium_depgraph_string(graph, graph->node_name[root]));
+  int top = -1;
+  if (max_depth != 0) {
+    state[root] = TREE_ON_PATH;
+    tree_push(graph, reverse, &stack[++top], root);
+  }
+
+  while (top >= 0) {
+    TreeFrame *frame = &stack[top];
+    if (frame->position >= frame->end) {
+      state[frame->node] = TREE_DONE;
+      top--;
+      continue;
+    }
+
+    uint32_t edge = tree_edge_at(graph, reverse, frame->position);
+    frame->position =
+        tree_advance(graph, reverse, frame->position + 1, frame->end);
+    uint32_t child =
+        reverse ? graph->edge_source[edge] : graph->edge_target[edge];
+
+    for (int level = 0; level < top; level++) {
+      fputs(stack[level].position < stack[level].end ? "│ " : "  ", stdout);
+    }
+    fputs(frame->position < frame->end ? "├─" : "└─", stdout);
+
+    const char *dep_name =
+        archium_depgraph_string(graph, graph->edge_name[edge]);
+    if (child == ARCHIUM_DEPGRAPH_NONE) {
+      printf("%s \033[1;31m(not found)\033[0m\n", dep_name);
+      continue;
+    }
+
+    const char *child_name =
+        archium_depgraph_string(graph, graph->node_name[child]);
+    if (!reverse && graph->edge_name[edge] != graph->node_name[child]) {
+      printf("%s provides %s", child_name, dep_name);
+    } else {
+      fputs(child_name, stdout);
+    }
+
+    if (state[child] == TREE_ON_PATH) {
+      puts(" \033[1;33m(cycle)\033[0m");
+      continue;
+    }
+    putchar('\n');
+
+    if (state[child] == TREE_DONE ||
+        (max_depth > 0 && top + 1 >= max_depth)) {
+      continue;
+    }
+    state[child] = TREE_ON_PATH;
+    tree_push(graph, reverse, &stack[++top], child);
+  }
+
+  free(state);
+  free(stack);
+}
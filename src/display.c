@@ -110,9 +110,15 @@ void display_cli_help(void) {
   printf(
       "\033[1;32m--exec <command>\033[0m    - Execute a specific command "
       "directly\n");
+  printf(
+      "\033[1;32m--script <file>\033[0m     - Run commands from a file, one "
+      "per line (--exec - reads stdin)\n");
   printf(
       "\033[1;32m--self-update\033[0m - Update Archium to the latest "
       "version\n");
+  printf(
+      "\033[1;32m--no-completion-cache\033[0m - Skip building the package "
+      "completion cache\n");
   printf(
       "  \033[1;32m--json\033[0m       - Output machine-readable JSON and "
       "suppress UI\n");
@@ -125,6 +131,9 @@ void display_cli_help(void) {
   printf("\n\033[1;33mExample:\033[0m\n");
   printf("  \033[1;32marchium --exec u\033[0m - Update the system\n");
   printf("  \033[1;32marchium --exec i\033[0m - Install packages\n");
+  printf(
+      "  \033[1;32marchium --exec \"i git && c\"\033[0m - Chain commands "
+      "with ; and &&\n");
 }
 
 void display_help(void) {
@@ -150,61 +159,61 @@ void display_help(void) {
   printf("  \033[1;32mq\033[0m         - Quit Archium\n");
 }
 
+typedef struct {
+  const char *name;
+  const char *usage;
+  int help;
+  const char *summary;
+} HelpEntry;
+
+static const HelpEntry help_entries[] = {
+#define X(name, type, handler, prompt, completion, usage, help, summary) \
+  {name, usage, help, summary},
+    ARCHIUM_COMMAND_SPEC(X)
+#undef X
+};
+
+static const struct {
+  const char *name;
+  const char *title;
+  int mask;
+} help_categories[] = {
+    {"packages", "Package Operations", HELP_PACKAGES},
+    {"system", "System Utilities", HELP_SYSTEM},
+    {"info", "Information Commands", HELP_INFO},
+    {"config", "Configuration & Plugins", HELP_CONFIG},
+    {"plugin", "Plugin Management Commands", HELP_PLUGIN},
+};
+
 void display_help_category(const char *category) {
-  if (strcmp(category, "packages") == 0) {
-    printf("\n\033[1;33mPackage Operations:\033[0m\n");
-    printf("\033[1;32mi\033[0m           - Install packages\n");
-    printf("\033[1;32mr\033[0m           - Remove packages\n");
-    printf(
-        "\033[1;32md\033[0m           - Downgrade packages to cached "
-        "versions\n");
-    printf(
-        "\033[1;32mp\033[0m           - Purge packages (remove with "
-        "dependencies)\n");
-    printf("\033[1;32ms\033[0m           - Search for packages\n");
-    printf(
-        "\033[1;32mu\033[0m [package] - Update system or specific package\n");
-  } else if (strcmp(category, "system") == 0) {
-    printf("\n\033[1;33mSystem Utilities:\033[0m\n");
-    printf(
-        "\033[1;32mhealth\033[0m      - System health check (disk, integrity, "
-        "services)\n");
-    printf("\033[1;32mc\033[0m           - Clean package cache\n");
-    printf("\033[1;32mcc\033[0m          - Clear build cache\n");
-    printf("\033[1;32mo\033[0m           - Clean orphaned packages\n");
-    printf("\033[1;32mlo\033[0m          - List orphaned packages\n");
-    printf("\033[1;32mcu\033[0m          - Check for package updates\n");
-    printf("\033[1;32mba\033[0m          - Backup pacman configuration\n");
-  } else if (strcmp(category, "info") == 0) {
-    printf("\n\033[1;33mInformation Commands:\033[0m\n");
-    printf("\033[1;32ml\033[0m           - List all installed packages\n");
-    printf("\033[1;32m?\033[0m           - Show package information\n");
-    printf("\033[1;32mdt\033[0m          - Display package dependency tree\n");
-    printf("\033[1;32msi\033[0m          - List packages by size\n");
-    printf("\033[1;32mre\033[0m          - Show recently installed packages\n");
-    printf(
-        "\033[1;32mex\033[0m          - List explicitly installed packages\n");
-    printf("\033[1;32mow\033[0m          - Find which package owns a file\n");
-  } else if (strcmp(category, "config") == 0) {
-    printf("\n\033[1;33mConfiguration & Plugins:\033[0m\n");
-    printf("\033[1;32mconfig\033[0m      - Configure Archium preferences\n");
-    printf("\033[1;32mpl\033[0m          - List loaded plugins\n");
-    printf("\033[1;32mpd\033[0m          - View plugin directory\n");
-    printf("\033[1;32mpe\033[0m          - Create example plugin\n");
-    archium_plugin_display_help();
-  } else if (strcmp(category, "plugin") == 0) {
-    printf("\n\033[1;33mPlugin Management Commands:\033[0m\n");
-    printf("\033[1;32mpl\033[0m          - List loaded plugins\n");
-    printf("\033[1;32mpd\033[0m          - View plugin directory\n");
-    printf("\033[1;32mpe\033[0m          - Create example plugin\n");
-    archium_plugin_display_help();
-  } else {
-    printf("\n\033[1;31mUnknown category: %s\033[0m\n", category);
-    printf(
-        "Available categories: \033[1;32mpackages\033[0m, "
-        "\033[1;32msystem\033[0m, \033[1;32minfo\033[0m, "
-        "\033[1;32mconfig\033[0m, \033[1;32mplugin\033[0m\n");
+  for (size_t i = 0; i < sizeof(help_categories) / sizeof(help_categories[0]);
+       i++) {
+    if (strcmp(category, help_categories[i].name) != 0) {
+      continue;
+    }
+
+    printf("\n\033[1;33m%s:\033[0m\n", help_categories[i].title);
+    for (size_t j = 0; j < sizeof(help_entries) / sizeof(help_entries[0]);
+         j++) {
+      const HelpEntry *entry = &help_entries[j];
+      if (!(entry->help & help_categories[i].mask)) {
+        continue;
+      }
+      int width = (int)(strlen(entry->name) + strlen(entry->usage));
+      printf("\033[1;32m%s\033[0m%s%*s- %s\n", entry->name, entry->usage,
+             width < 12 ? 12 - width : 1, "", entry->summary);
+    }
+    if (help_categories[i].mask & (HELP_CONFIG | HELP_PLUGIN)) {
+      archium_plugin_display_help();
+    }
+    return;
   }
+
+  printf("\n\033[1;31mUnknown category: %s\033[0m\n", category);
+  printf(
+      "Available categories: \033[1;32mpackages\033[0m, "
+      "\033[1;32msystem\033[0m, \033[1;32minfo\033[0m, "
+      "\033[1;32mconfig\033[0m, \033[1;32mplugin\033[0m\n");
 }
 
 void display_help_quick(void) {
@@ -76,12 +76,20 @@ ArchiumError parse_arguments(int argc, char *argv[]) {
   config.version = 0;
   config.exec_mode = 0;
   config.exec_command = NULL;
+  config.script_path = NULL;
   config.json_output = 0;
   config.batch_mode = 0;
   config.use_native_output = 1;
   config.show_welcome = 1;
   config.show_tips = 1;
   config.cache_ttl_seconds = 3600;
+  config.no_completion_cache = 0;
+  config.fuzzy_completion = 1;
+  config.capture_limit_kb = 1024;
+  config.command_timeout_seconds = 0;
+  config.scan_threads = 0;
+  config.orphans_keep_optional = 1;
+  config.orphans_keep_make = 0;
 
   for (int i = 1; i < argc; i++) {
     if (strcmp(argv[i], "--verbose") == 0 || strcmp(argv[i], "-V") == 0) {
@@ -97,9 +105,22 @@ ArchiumError parse_arguments(int argc, char *argv[]) {
       if (i + 1 < argc) {
         config.exec_command = argv[++i];
       }
+      if (config.exec_command && strcmp(config.exec_command, "-") == 0) {
+        config.script_path = config.exec_command;
+      }
+    } else if (strcmp(argv[i], "--script") == 0) {
+      if (i + 1 >= argc) {
+        fprintf(stderr,
+                "\033[1;31mError: --script requires a file argument\033[0m\n");
+        return ARCHIUM_ERROR_INVALID_INPUT;
+      }
+      config.exec_mode = 1;
+      config.script_path = argv[++i];
     } else if (strcmp(argv[i], "--self-update") == 0) {
       perform_self_update();
       exit(ARCHIUM_SUCCESS);
+    } else if (strcmp(argv[i], "--no-completion-cache") == 0) {
+      config.no_completion_cache = 1;
     } else if (strcmp(argv[i], "--json") == 0) {
       config.json_output = 1;
     } else if (strcmp(argv[i], "--batch") == 0) {
@@ -0,0 +1,145 @@
+#include "include/archium.h"
+
+#define FUZZY_MATCH_SCORE 16
+#define FUZZY_CONSECUTIVE_BONUS 12
+#define FUZZY_BOUNDARY_BONUS 10
+#define FUZZY_PREFIX_BONUS 24
+#define FUZZY_GAP_PENALTY 1
+
+static int fold(char c) { return tolower((unsigned char)c); }
+
+static int is_word_boundary(const char *name, size_t i) {
+  return i == 0 || !isalnum((unsigned char)name[i - 1]);
+}
+
+static int score_from(const char *name, size_t length, size_t start,
+                      const char *pattern, size_t pattern_length) {
+  int score = 0;
+  size_t previous = start;
+  size_t matched = 0;
+
+  for (size_t i = start; i < length && matched < pattern_length; i++) {
+    if (fold(name[i]) != fold(pattern[matched])) {
+      continue;
+    }
+
+    score += FUZZY_MATCH_SCORE;
+    if (matched > 0 && i == previous + 1) {
+      score += FUZZY_CONSECUTIVE_BONUS;
+    } else if (matched > 0) {
+      score -= FUZZY_GAP_PENALTY * (int)(i - previous - 1);
+    }
+    if (is_word_boundary(name, i)) {
+      score += FUZZY_BOUNDARY_BONUS;
+    }
+    previous = i;
+    matched++;
+  }
+
+  if (matched < pattern_length) {
+    return -1;
+  }
+  if (start == 0) {
+    score += FUZZY_PREFIX_BONUS;
+  }
+  return score;
+}
+
+int archium_fuzzy_score(const char *name, size_t length, const char *pattern,
+                        size_t pattern_length) {
+  if (!name || !pattern || pattern_length == 0 || pattern_length > length) {
+    return -1;
+  }
+
+  int best = -1;
+  int first = fold(pattern[0]);
+  for (size_t i = 0; i + pattern_length <= length; i++) {
+    if (fold(name[i]) != first) {
+      continue;
+    }
+    int score = score_from(name, length, i, pattern, pattern_length);
+    if (score < 0) {
+      break;
+    }
+    if (score > best) {
+      best = score;
+    }
+  }
+
+  if (best < 0) {
+    return -1;
+  }
+  best -= (int)(length - pattern_length) / 2;
+  return best > 0 ? best : 0;
+}
+
+static int ranks_before(const ArchiumFuzzyMatch *a,
+                        const ArchiumFuzzyMatch *b) {
+  if (a->score != b->score) {
+    return a->score > b->score;
+  }
+  if (a->length != b->length) {
+    return a->length < b->length;
+  }
+  return strcmp(a->name, b->name) < 0;
+}
+
+void archium_fuzzy_add(ArchiumFuzzyResults *results, const char *name,
+                       size_t length, const char *pattern,
+                       size_t pattern_length) {
+  int score = archium_fuzzy_score(name, length, pattern, pattern_length);
+  if (score < 0) {
+    return;
+  }
+
+  ArchiumFuzzyMatch match = {name, length, score};
+  size_t count = results->count;
+  if (count == ARCHIUM_FUZZY_MAX_RESULTS) {
+    if (!ranks_before(&match, &results->matches[count - 1])) {
+      return;
+    }
+    count--;
+  }
+
+  size_t slot = count;
+  while (slot > 0 && ranks_before(&match, &results->matches[slot - 1])) {
+    results->matches[slot] = results->matches[slot - 1];
+    slot--;
+  }
+  results->matches[slot] = match;
+  results->count = count + 1;
+}
+
+void archium_fuzzy_search_blob(ArchiumFuzzyResults *results, const char *blob,
+                               size_t blob_size, const char *pattern,
+                               size_t pattern_length) {
+  if (!blob || pattern_length == 0) {
+    return;
+  }
+
+  unsigned char lower = (unsigned char)tolower((unsigned char)pattern[0]);
+  unsigned char upper = (unsigned char)toupper((unsigned char)pattern[0]);
+  const char *end = blob + blob_size;
+  const char *cursor = blob;
+
+  while (cursor < end) {
+    const char *hit =
+        archium_scan_byte2(cursor, (size_t)(end - cursor), lower, upper);
+    if (!hit) {
+      break;
+    }
+
+    const char *name = hit;
+    while (name > cursor && name[-1] != '\0') {
+      name--;
+    }
+    const char *terminator = memchr(hit, '\0', (size_t)(end - hit));
+    if (!terminator) {
+      break;
+    }
+
+    archium_fuzzy_add(results, name, (size_t)(terminator - name), pattern,
+                      pattern_length);
+    cursor = terminator + 1;
+  }
+}
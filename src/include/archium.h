@@ -40,13 +40,24 @@ int sanitize_shell_input(const char *input, char *output, size_t output_size);
 int validate_package_name(const char *package);
 int validate_file_path(const char *path);
 
+#include "arena.h"
 #include "autocomplete.h"
+#include "command_spec.h"
 #include "commands.h"
 #include "config.h"
+#include "depgraph.h"
 #include "display.h"
 #include "error.h"
+#include "fuzzy.h"
+#include "localdb.h"
+#include "logger.h"
+#include "package_index.h"
 #include "package_manager.h"
 #include "plugin.h"
+#include "simd_scan.h"
+#include "sync_db.h"
+#include "thread_pool.h"
+#include "transaction.h"
 #include "utils.h"
 
 #endif
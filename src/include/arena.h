@@ -0,0 +1,22 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARCHIUM_ARENA_DEFAULT_CHUNK (16 * 1024)
+
+typedef struct ArchiumArenaChunk ArchiumArenaChunk;
+
+typedef struct {
+  ArchiumArenaChunk *head;
+  size_t next_size;
+} ArchiumArena;
+
+void archium_arena_init(ArchiumArena *arena, size_t initial_size);
+void *archium_arena_alloc(ArchiumArena *arena, size_t size);
+void *archium_arena_grow(ArchiumArena *arena, void *old, size_t old_size,
+                         size_t new_size);
+char *archium_arena_strndup(ArchiumArena *arena, const char *s, size_t length);
+void archium_arena_free(ArchiumArena *arena);
+
+#endif
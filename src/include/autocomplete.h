@@ -1,11 +1,22 @@
 #ifndef AUTOCOMPLETE_H
 #define AUTOCOMPLETE_H
 
-extern char **cached_commands;
+typedef enum {
+  COMPLETION_AUTO,
+  COMPLETION_NONE,
+  COMPLETION_COMMANDS,
+  COMPLETION_SYNC,
+  COMPLETION_INSTALLED,
+  COMPLETION_CACHED,
+  COMPLETION_FILES,
+} CompletionSource;
 
 char **command_completion(const char *text, int start, int end);
 char *command_generator(const char *text, int state);
+CompletionSource completion_source_for_command(const char *command);
+void set_completion_source(CompletionSource source);
 void cache_pacman_commands(void);
+void start_completion_warmup(void);
 void cleanup_cached_commands(void);
 void invalidate_package_cache(void);
 
@@ -0,0 +1,107 @@
+#ifndef COMMAND_SPEC_H
+#define COMMAND_SPEC_H
+
+#include <stddef.h>
+
+#define ARCHIUM_COMMAND_HASH_SIZE 64
+
+typedef enum {
+  HELP_NONE = 0,
+  HELP_PACKAGES = 1,
+  HELP_SYSTEM = 2,
+  HELP_INFO = 4,
+  HELP_CONFIG = 8,
+  HELP_PLUGIN = 16,
+} HelpCategory;
+
+/*
+ * X(name, type, handler, prompt, completion, usage, help, summary)
+ *
+ * Built-in command table. Dispatch, validation, prompts, completion and the
+ * help listings are all generated from these rows, and the build derives a
+ * perfect hash over the names (scripts/gen-command-hash.c). Rows are listed
+ * in the order they appear in help output.
+ */
+#define ARCHIUM_COMMAND_SPEC(X)                                               \
+  X("i", WITH_PM_ARGS, install_package, "Enter package names to install: ",  \
+    COMPLETION_SYNC, "", HELP_PACKAGES, "Install packages")                   \
+  X("r", WITH_PM_ARGS, remove_package, "Enter package names to remove: ",    \
+    COMPLETION_INSTALLED, "", HELP_PACKAGES, "Remove packages")               \
+  X("d", WITH_PM_ARGS, downgrade_package,                                    \
+    "Enter package names to downgrade: ", COMPLETION_CACHED, "",              \
+    HELP_PACKAGES, "Downgrade packages to cached versions")                   \
+  X("p", WITH_PM_ARGS, purge_package, "Enter package names to purge: ",      \
+    COMPLETION_INSTALLED, "", HELP_PACKAGES,                                  \
+    "Purge packages (remove with dependencies)")                              \
+  X("s", WITH_PM_ARGS, search_package, "Enter package name to search: ",     \
+    COMPLETION_SYNC, "", HELP_PACKAGES, "Search for packages")                \
+  X("u", WITH_PM_ARGS, update_system, "Enter package names to update: ",     \
+    COMPLETION_INSTALLED, " [package]", HELP_PACKAGES,                        \
+    "Update system or specific package")                                      \
+  X("begin", SIMPLE, archium_transaction_begin, NULL, COMPLETION_NONE, "",  \
+    HELP_PACKAGES, "Start queuing i/r/p into one transaction")                \
+  X("commit", WITH_PM, archium_transaction_commit, NULL, COMPLETION_NONE,    \
+    "", HELP_PACKAGES, "Run the queued transaction")                          \
+  X("abort", SIMPLE, archium_transaction_abort, NULL, COMPLETION_NONE, "",   \
+    HELP_PACKAGES, "Discard the queued transaction")                          \
+  X("health", SIMPLE, system_health_check, NULL, COMPLETION_NONE, "",        \
+    HELP_SYSTEM, "System health check (disk, integrity, services)")           \
+  X("c", WITH_PM, clean_cache, NULL, COMPLETION_NONE, "", HELP_SYSTEM,       \
+    "Clean package cache")                                                    \
+  X("cc", SIMPLE, clear_build_cache, NULL, COMPLETION_NONE, "", HELP_SYSTEM, \
+    "Clear build cache")                                                      \
+  X("o", WITH_PM, clean_orphans, NULL, COMPLETION_NONE, "", HELP_SYSTEM,     \
+    "Clean orphaned packages")                                                \
+  X("lo", SIMPLE, list_orphans, NULL, COMPLETION_NONE, "", HELP_SYSTEM,      \
+    "List orphaned packages")                                                 \
+  X("cu", SIMPLE, check_package_updates, NULL, COMPLETION_NONE, "",          \
+    HELP_SYSTEM, "Check for package updates")                                 \
+  X("ba", SIMPLE, backup_pacman_config, NULL, COMPLETION_NONE, "",           \
+    HELP_SYSTEM, "Backup pacman configuration")                               \
+  X("l", SIMPLE, list_installed_packages, NULL, COMPLETION_NONE, "",         \
+    HELP_INFO, "List all installed packages")                                 \
+  X("?", WITH_PM_ARGS, show_package_info,                                    \
+    "Enter package name to show info: ", COMPLETION_SYNC, "", HELP_INFO,      \
+    "Show package information")                                               \
+  X("dt", WITH_PM_ARGS, display_dependency_tree,                             \
+    "Enter package name to view dependencies: ", COMPLETION_SYNC,             \
+    " [-r] [-d N]", HELP_INFO,                                                \
+    "Display dependency tree (-r reverse, -d depth)")                         \
+  X("si", SIMPLE, list_packages_by_size, NULL, COMPLETION_NONE, "",          \
+    HELP_INFO, "List packages by size")                                       \
+  X("re", SIMPLE, list_recent_installs, NULL, COMPLETION_NONE, "",           \
+    HELP_INFO, "Show recently installed packages")                            \
+  X("ex", SIMPLE, list_explicit_installs, NULL, COMPLETION_NONE, "",         \
+    HELP_INFO, "List explicitly installed packages")                          \
+  X("ow", ARGS_ONLY, find_package_owner, "Enter file path: ",                \
+    COMPLETION_FILES, "", HELP_INFO, "Find which package owns a file")        \
+  X("config", SIMPLE, configure_preferences, NULL, COMPLETION_NONE, "",      \
+    HELP_CONFIG, "Configure Archium preferences")                             \
+  X("pl", SIMPLE, archium_plugin_list_loaded, NULL, COMPLETION_NONE, "",     \
+    HELP_CONFIG | HELP_PLUGIN, "List loaded plugins")                         \
+  X("pd", SIMPLE, show_plugin_directory, NULL, COMPLETION_NONE, "",          \
+    HELP_CONFIG | HELP_PLUGIN, "View plugin directory")                       \
+  X("pe", SIMPLE, create_example_plugin, NULL, COMPLETION_NONE, "",          \
+    HELP_CONFIG | HELP_PLUGIN, "Create example plugin")                       \
+  X("h", ARGS_ONLY, show_help, NULL, COMPLETION_COMMANDS, "", HELP_NONE,     \
+    "Show help")                                                              \
+  X("help", ARGS_ONLY, show_help, NULL, COMPLETION_COMMANDS, "", HELP_NONE,  \
+    "Show help")                                                              \
+  X("q", QUIT, NULL, NULL, COMPLETION_NONE, "", HELP_NONE, "Quit Archium")   \
+  X("quit", QUIT, NULL, NULL, COMPLETION_NONE, "", HELP_NONE,                \
+    "Quit Archium")                                                           \
+  X("exit", QUIT, NULL, NULL, COMPLETION_NONE, "", HELP_NONE, "Quit Archium")
+
+static inline unsigned int archium_command_hash(const char *name,
+                                                size_t length,
+                                                unsigned int seed) {
+  unsigned int hash = 2166136261u ^ seed;
+  for (size_t i = 0; i < length; i++) {
+    hash ^= (unsigned char)name[i];
+    hash *= 16777619u;
+  }
+  hash ^= hash >> 15;
+  return hash & (ARCHIUM_COMMAND_HASH_SIZE - 1);
+}
+
+#endif
@@ -3,19 +3,30 @@
 
 #include <stddef.h>
 
+#include "arena.h"
+#include "autocomplete.h"
 #include "config.h"
 #include "error.h"
 
+#define ARCHIUM_PKG_CACHE_DIR "/var/cache/pacman/pkg"
+
 ArchiumError handle_exec_command(const char *command,
                                  const char *package_manager);
 ArchiumError handle_command(const char *input, const char *package_manager);
+ArchiumError handle_command_line(const char *line,
+                                 const char *package_manager);
+ArchiumError handle_script(const char *path, const char *package_manager);
 void get_input(char *input, size_t input_size, const char *prompt);
 int is_valid_command(const char *command);
+const char *get_valid_command(size_t index);
+int builtin_command_index(const char *name);
+CompletionSource builtin_command_completion(int index);
 int check_archium_file(void);
 void install_git(void);
 void perform_self_update(void);
 void downgrade_package(const char *package_manager, const char *packages);
-char **list_cached_versions(const char *package, int *count);
+char **list_cached_versions(const char *package, int *count,
+                            ArchiumArena *arena);
 void system_health_check(void);
 
 #endif
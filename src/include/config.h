@@ -10,12 +10,20 @@ typedef struct {
   int version;
   int exec_mode;
   char *exec_command;
+  char *script_path;
   int json_output;
   int batch_mode;
   int use_native_output;
   int show_welcome;
   int show_tips;
   int cache_ttl_seconds;
+  int no_completion_cache;
+  int fuzzy_completion;
+  int capture_limit_kb;
+  int command_timeout_seconds;
+  int scan_threads;
+  int orphans_keep_optional;
+  int orphans_keep_make;
 } ArchiumConfig;
 
 extern ArchiumConfig config;
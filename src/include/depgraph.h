@@ -0,0 +1,75 @@
+#ifndef DEPGRAPH_H
+#define DEPGRAPH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "localdb.h"
+
+#define ARCHIUM_DEPGRAPH_NONE UINT32_MAX
+
+#define ARCHIUM_ORPHAN_KEEP_OPTIONAL 1
+#define ARCHIUM_ORPHAN_KEEP_MAKE 2
+
+typedef enum {
+  ARCHIUM_EDGE_DEPEND,
+  ARCHIUM_EDGE_OPTDEPEND,
+  ARCHIUM_EDGE_MAKEDEPEND,
+} ArchiumEdgeKind;
+
+typedef struct {
+  char *strings;
+  uint32_t strings_size;
+  uint32_t strings_capacity;
+  uint32_t *offsets;
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *slots;
+  uint32_t slot_count;
+} ArchiumInternTable;
+
+/*
+ * Packages are nodes, every distinct string is interned once, and the
+ * dependency edges are stored in compressed sparse row form: the edges of
+ * node n are [forward_first[n], forward_first[n + 1]). reverse_edge lists the
+ * same edges grouped by target.
+ */
+typedef struct {
+  ArchiumInternTable names;
+  uint32_t *name_node;
+
+  uint32_t node_count;
+  uint32_t *node_name;
+  uint32_t *node_version;
+  uint8_t *node_installed;
+  uint8_t *node_explicit;
+
+  uint32_t *provide_first;
+  uint32_t *provide_node;
+  uint32_t *provide_version;
+
+  uint32_t edge_count;
+  uint32_t *forward_first;
+  uint32_t *edge_source;
+  uint32_t *edge_target;
+  uint32_t *edge_name;
+  uint8_t *edge_kind;
+  uint32_t *reverse_first;
+  uint32_t *reverse_edge;
+} ArchiumDepGraph;
+
+int archium_vercmp(const char *a, const char *b);
+
+int archium_depgraph_build(ArchiumDepGraph *graph, const ArchiumLocalDb *local,
+                           const ArchiumLocalDb *sync);
+void archium_depgraph_free(ArchiumDepGraph *graph);
+uint32_t archium_depgraph_find(const ArchiumDepGraph *graph, const char *name);
+const char *archium_depgraph_string(const ArchiumDepGraph *graph,
+                                    uint32_t id);
+int archium_depgraph_find_orphans(const ArchiumDepGraph *graph,
+                                  unsigned int keep, uint32_t **orphans,
+                                  uint32_t *count);
+void archium_depgraph_print_tree(const ArchiumDepGraph *graph, uint32_t root,
+                                 int reverse, int max_depth);
+
+#endif
@@ -1,6 +1,9 @@
 #ifndef DISPLAY_H
 #define DISPLAY_H
 
+#include "error.h"
+#include "utils.h"
+
 void display_version(void);
 void display_cli_help(void);
 void display_help(void);
@@ -11,13 +14,15 @@ void display_random_tip(void);
 void handle_signal(int signal);
 void show_progress_bar(int current, int total, const char *prefix);
 void show_spinner(int position, const char *message);
-void parse_and_show_upgrade_result(const char *output, int exit_code);
-void parse_and_show_install_result(const char *output, int exit_code,
+void parse_and_show_upgrade_result(const ArchiumOutput *output,
+                                   int exit_code);
+void parse_and_show_install_result(const ArchiumOutput *output, int exit_code,
                                    const char *package);
-void parse_and_show_remove_result(const char *output, int exit_code,
+void parse_and_show_remove_result(const ArchiumOutput *output, int exit_code,
                                   const char *package);
-void parse_and_show_generic_result(const char *output, int exit_code,
-                                   const char *operation);
+void parse_and_show_generic_result(int exit_code, const char *operation);
+void print_command_status(const char *command, ArchiumError status,
+                          int exit_code, int executed);
 void display_fallback_logo(void);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef FUZZY_H
+#define FUZZY_H
+
+#include <stddef.h>
+
+#define ARCHIUM_FUZZY_MAX_RESULTS 64
+
+typedef struct {
+  const char *name;
+  size_t length;
+  int score;
+} ArchiumFuzzyMatch;
+
+typedef struct {
+  ArchiumFuzzyMatch matches[ARCHIUM_FUZZY_MAX_RESULTS];
+  size_t count;
+} ArchiumFuzzyResults;
+
+int archium_fuzzy_score(const char *name, size_t length, const char *pattern,
+                        size_t pattern_length);
+void archium_fuzzy_add(ArchiumFuzzyResults *results, const char *name,
+                       size_t length, const char *pattern,
+                       size_t pattern_length);
+void archium_fuzzy_search_blob(ArchiumFuzzyResults *results, const char *blob,
+                               size_t blob_size, const char *pattern,
+                               size_t pattern_length);
+
+#endif
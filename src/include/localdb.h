@@ -0,0 +1,103 @@
+#ifndef LOCALDB_H
+#define LOCALDB_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#ifndef ARCHIUM_LOCAL_DB_DIR
+#define ARCHIUM_LOCAL_DB_DIR "/var/lib/pacman/local"
+#endif
+
+#define ARCHIUM_LOCALDB_MAGIC "ARCHLDB"
+#define ARCHIUM_LOCALDB_SNAPSHOT_VERSION 3
+#define ARCHIUM_LOCALDB_SNAPSHOT_FILE "localdb.bin"
+
+#define ARCHIUM_LOCALDB_REASON_EXPLICIT 0
+#define ARCHIUM_LOCALDB_REASON_DEPEND 1
+
+typedef enum {
+  ARCHIUM_LOCALDB_DEPENDS,
+  ARCHIUM_LOCALDB_OPTDEPENDS,
+  ARCHIUM_LOCALDB_MAKEDEPENDS,
+  ARCHIUM_LOCALDB_PROVIDES,
+  ARCHIUM_LOCALDB_GROUPS,
+  ARCHIUM_LOCALDB_LIST_COUNT,
+} ArchiumLocalDbList;
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+  uint32_t item_count;
+  uint32_t strings_size;
+  uint32_t alpm_db_version;
+  uint32_t reserved;
+  uint64_t source_inode;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+  int64_t desc_ctime_sec;
+  int64_t desc_ctime_nsec;
+} ArchiumLocalDbHeader;
+
+/*
+ * What a snapshot is checked against: the local/ directory itself, which
+ * changes when packages come and go, and the newest desc change time, which
+ * catches in-place rewrites such as pacman -D --asexplicit.
+ */
+typedef struct {
+  struct stat dir;
+  struct timespec newest_desc;
+  uint32_t alpm_db_version;
+} ArchiumLocalDbSource;
+
+typedef struct {
+  uint32_t count;
+  uint32_t capacity;
+  uint32_t *name;
+  uint32_t *version;
+  uint8_t *reason;
+  uint64_t *size;
+  int64_t *install_date;
+  uint32_t *list_first[ARCHIUM_LOCALDB_LIST_COUNT];
+  uint32_t *list_length[ARCHIUM_LOCALDB_LIST_COUNT];
+
+  uint32_t *items;
+  uint32_t item_count;
+  uint32_t item_capacity;
+
+  char *strings;
+  uint32_t strings_size;
+  uint32_t strings_capacity;
+
+  void *map;
+  size_t map_size;
+} ArchiumLocalDb;
+
+void archium_localdb_init(ArchiumLocalDb *db);
+int archium_localdb_load(ArchiumLocalDb *db, const char *path,
+                         size_t threads);
+int archium_localdb_load_sync(ArchiumLocalDb *db, const char *sync_dir);
+int archium_localdb_parse_desc(ArchiumLocalDb *db, const char *desc,
+                               size_t length);
+void archium_localdb_free(ArchiumLocalDb *db);
+
+int archium_localdb_stat_source(const char *path,
+                                ArchiumLocalDbSource *source);
+int archium_localdb_snapshot_open(ArchiumLocalDb *db, const char *path,
+                                  const ArchiumLocalDbSource *source);
+int archium_localdb_snapshot_write(const ArchiumLocalDb *db, const char *path,
+                                   const ArchiumLocalDbSource *source);
+int archium_localdb_open_cached(ArchiumLocalDb *db, const char *path,
+                                const char *snapshot_path, size_t threads);
+
+const char *archium_localdb_string(const ArchiumLocalDb *db, uint32_t offset);
+const char *archium_localdb_name(const ArchiumLocalDb *db, uint32_t index);
+const char *archium_localdb_version(const ArchiumLocalDb *db, uint32_t index);
+const uint32_t *archium_localdb_list(const ArchiumLocalDb *db, uint32_t index,
+                                     ArchiumLocalDbList list,
+                                     uint32_t *length);
+int64_t archium_localdb_find(const ArchiumLocalDb *db, const char *name,
+                             size_t length);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stddef.h>
+
+#define ARCHIUM_LOG_SLOTS 256
+#define ARCHIUM_LOG_LEVEL_MAX 16
+#define ARCHIUM_LOG_MESSAGE_MAX 512
+#define ARCHIUM_LOG_ROTATE_BYTES (1024 * 1024)
+
+int archium_logger_open(const char *path);
+int archium_logger_write(const char *level, const char *message);
+void archium_logger_flush(void);
+void archium_logger_flush_from_signal(void);
+void archium_logger_shutdown(void);
+
+#endif
@@ -0,0 +1,88 @@
+#ifndef PACKAGE_INDEX_H
+#define PACKAGE_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+#define ARCHIUM_INDEX_MAGIC "ARCHIDX"
+#define ARCHIUM_INDEX_VERSION 2
+#define ARCHIUM_INDEX_REPO_NAME_MAX 64
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t count;
+  uint32_t blob_size;
+  uint32_t repo_count;
+  uint32_t repo_name_count;
+  uint32_t reserved;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+} ArchiumIndexHeader;
+
+typedef struct {
+  char name[ARCHIUM_INDEX_REPO_NAME_MAX];
+  uint64_t size;
+  int64_t mtime_sec;
+  int64_t mtime_nsec;
+  uint64_t inode;
+  uint32_t first;
+  uint32_t count;
+} ArchiumIndexRepo;
+
+typedef struct {
+  void *map;
+  size_t map_size;
+  const ArchiumIndexHeader *header;
+  const ArchiumIndexRepo *repos;
+  const uint32_t *offsets;
+  const uint32_t *repo_offsets;
+  const char *blob;
+  uint32_t count;
+  uint32_t blob_size;
+  uint32_t repo_count;
+  uint32_t repo_name_count;
+} ArchiumPackageIndex;
+
+typedef struct {
+  char *blob;
+  size_t blob_size;
+  size_t blob_capacity;
+  uint32_t *offsets;
+  size_t count;
+  size_t capacity;
+  ArchiumIndexRepo *repos;
+  size_t repo_count;
+  size_t repo_capacity;
+  int64_t source_mtime_sec;
+  int64_t source_mtime_nsec;
+} ArchiumIndexBuilder;
+
+int archium_index_open(ArchiumPackageIndex *index, const char *path);
+void archium_index_close(ArchiumPackageIndex *index);
+const char *archium_index_name(const ArchiumPackageIndex *index, uint32_t i);
+uint32_t archium_index_prefix_range(const ArchiumPackageIndex *index,
+                                    const char *prefix, size_t length,
+                                    uint32_t *first);
+const ArchiumIndexRepo *archium_index_find_repo(
+    const ArchiumPackageIndex *index, const char *name);
+const char *archium_index_repo_name(const ArchiumPackageIndex *index,
+                                    const ArchiumIndexRepo *repo, uint32_t i);
+int archium_index_repo_matches(const ArchiumIndexRepo *repo,
+                               const struct stat *st);
+int archium_index_source_matches(const ArchiumPackageIndex *index,
+                                 const struct stat *st);
+
+void archium_index_builder_init(ArchiumIndexBuilder *builder);
+void archium_index_builder_set_source(ArchiumIndexBuilder *builder,
+                                      const struct stat *st);
+int archium_index_builder_begin_repo(ArchiumIndexBuilder *builder,
+                                     const char *name, const struct stat *st);
+int archium_index_builder_add(ArchiumIndexBuilder *builder, const char *name,
+                              size_t length);
+int archium_index_builder_write(ArchiumIndexBuilder *builder,
+                                const char *path);
+void archium_index_builder_free(ArchiumIndexBuilder *builder);
+
+#endif
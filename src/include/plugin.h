@@ -34,6 +34,7 @@ int archium_plugin_find_by_command(const char *command);
 ArchiumError archium_plugin_execute(const char *command, const char *args,
                                     const char *package_manager);
 int archium_plugin_is_plugin_command(const char *command);
+const char *archium_plugin_command_at(int index);
 ArchiumError archium_plugin_before_command(const char *command,
                                            const char *args,
                                            const char *package_manager);
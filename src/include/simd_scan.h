@@ -0,0 +1,9 @@
+#ifndef SIMD_SCAN_H
+#define SIMD_SCAN_H
+
+#include <stddef.h>
+
+const char *archium_scan_byte2(const char *data, size_t length,
+                               unsigned char first, unsigned char second);
+
+#endif
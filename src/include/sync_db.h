@@ -0,0 +1,21 @@
+#ifndef SYNC_DB_H
+#define SYNC_DB_H
+
+#include <stddef.h>
+
+#define ARCHIUM_SYNC_DB_DIR "/var/lib/pacman/sync"
+
+typedef int (*ArchiumDescFn)(const char *desc, size_t length, void *user_data);
+typedef int (*ArchiumNameFn)(const char *name, size_t length, void *user_data);
+
+const char *archium_desc_field(const char *desc, size_t length,
+                               const char *field, size_t *value_length);
+int archium_syncdb_is_db_file(const char *filename);
+int archium_syncdb_foreach_desc(const char *db_path, ArchiumDescFn fn,
+                                void *user_data);
+int archium_syncdb_read_names(const char *db_path, ArchiumNameFn fn,
+                              void *user_data);
+int archium_syncdb_read_all_names(const char *sync_dir, ArchiumNameFn fn,
+                                  void *user_data);
+
+#endif
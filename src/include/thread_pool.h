@@ -0,0 +1,21 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <stddef.h>
+
+#define ARCHIUM_POOL_MAX_THREADS 64
+#define ARCHIUM_POOL_AUTO_THREADS 16
+
+typedef struct ArchiumThreadPool ArchiumThreadPool;
+
+typedef void (*ArchiumPoolTaskFn)(size_t worker, size_t index,
+                                  void *user_data);
+
+size_t archium_pool_default_threads(void);
+ArchiumThreadPool *archium_pool_create(size_t threads);
+size_t archium_pool_thread_count(const ArchiumThreadPool *pool);
+void archium_pool_run(ArchiumThreadPool *pool, size_t count,
+                      ArchiumPoolTaskFn fn, void *user_data);
+void archium_pool_destroy(ArchiumThreadPool *pool);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef TRANSACTION_H
+#define TRANSACTION_H
+
+#include <stddef.h>
+
+typedef enum {
+  ARCHIUM_TX_INSTALL,
+  ARCHIUM_TX_REMOVE,
+  ARCHIUM_TX_PURGE,
+} ArchiumTransactionAction;
+
+int archium_transaction_is_open(void);
+void archium_transaction_begin(void);
+void archium_transaction_abort(void);
+void archium_transaction_commit(const char *package_manager);
+int archium_transaction_queue(ArchiumTransactionAction action,
+                              const char *packages);
+size_t archium_transaction_pending(void);
+
+#endif
@@ -2,15 +2,79 @@
 #define UTILS_H
 
 #include <stddef.h>
+#include <stdio.h>
+#include <sys/types.h>
+
+#include "arena.h"
+
+#define PROCESS_CAPTURE_STDOUT 1
+#define PROCESS_MERGE_STDERR 2
+#define PROCESS_DISCARD_STDOUT 4
+#define PROCESS_DISCARD_STDERR 8
+#define PROCESS_NEW_GROUP 16
+
+typedef struct {
+  pid_t pid;
+  pid_t group;
+  int exit_code;
+  int output_fd;
+  int terminal_fd;
+  FILE *output;
+} ArchiumProcess;
+
+typedef struct {
+  int nothing_to_do;
+  int up_to_date;
+  int already_installed;
+  int not_installed;
+  int changed_lines;
+} ArchiumOutputSummary;
+
+typedef struct {
+  char *data;
+  size_t length;
+  size_t capacity;
+  size_t limit;
+  int truncated;
+  ArchiumOutputSummary summary;
+} ArchiumOutput;
+
+typedef struct {
+  ArchiumArena arena;
+  const char **items;
+  size_t count;
+  size_t capacity;
+} ArchiumArgv;
 
 void log_action(const char *action);
 void log_debug(const char *debug_message);
 void log_info(const char *info_message);
-int execute_command_with_spinner(const char *command, const char *message);
+void argv_init(ArchiumArgv *args);
+int argv_push(ArchiumArgv *args, const char *arg);
+int argv_push_length(ArchiumArgv *args, const char *arg, size_t length);
+int argv_push_words(ArchiumArgv *args, const char *words);
+void argv_free(ArchiumArgv *args);
+int spawn_process(ArchiumProcess *process, const char *const argv[],
+                  int flags);
+FILE *process_output(ArchiumProcess *process);
+int wait_process(ArchiumProcess *process);
+int run_process(const char *const argv[], int flags);
+void reset_command_exit_code(void);
+void record_command_exit_code(int exit_code);
+int get_command_exit_code(void);
+int execute_argv_with_spinner(const char *const argv[], const char *message);
+void output_init(ArchiumOutput *output);
+int output_append(ArchiumOutput *output, const char *data, size_t length);
+void output_scan_line(ArchiumOutput *output, const char *line);
+const char *output_text(const ArchiumOutput *output);
+void output_free(ArchiumOutput *output);
+int execute_argv_with_output_capture(const char *const argv[],
+                                     const char *message,
+                                     ArchiumOutput *output);
+int execute_argv_native(const char *const argv[]);
 int execute_command_with_output_capture(const char *command,
                                         const char *message,
                                         char *output_buffer,
                                         size_t buffer_size);
-int execute_command_native(const char *command);
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,887 @@
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdint.h>
+#include <sys/mman.h>
+
+#include "include/archium.h"
+
+#define LOCALDB_INITIAL_PACKAGES 256
+#define LOCALDB_INITIAL_ITEMS 2048
+#define LOCALDB_INITIAL_STRINGS (64 * 1024)
+#define LOCALDB_DESC_CHUNK (16 * 1024)
+#define LOCALDB_MIN_ENTRIES_PER_THREAD 64
+
+typedef enum {
+  FIELD_NONE,
+  FIELD_NAME,
+  FIELD_VERSION,
+  FIELD_REASON,
+  FIELD_SIZE,
+  FIELD_INSTALLDATE,
+  FIELD_LIST,
+} DescField;
+
+static const struct {
+  const char *header;
+  DescField field;
+  ArchiumLocalDbList list;
+} desc_fields[] = {
+    {"%NAME%", FIELD_NAME, 0},
+    {"%VERSION%", FIELD_VERSION, 0},
+    {"%REASON%", FIELD_REASON, 0},
+    {"%SIZE%", FIELD_SIZE, 0},
+    {"%INSTALLDATE%", FIELD_INSTALLDATE, 0},
+    {"%DEPENDS%", FIELD_LIST, ARCHIUM_LOCALDB_DEPENDS},
+    {"%OPTDEPENDS%", FIELD_LIST, ARCHIUM_LOCALDB_OPTDEPENDS},
+    {"%MAKEDEPENDS%", FIELD_LIST, ARCHIUM_LOCALDB_MAKEDEPENDS},
+    {"%PROVIDES%", FIELD_LIST, ARCHIUM_LOCALDB_PROVIDES},
+    {"%GROUPS%", FIELD_LIST, ARCHIUM_LOCALDB_GROUPS},
+};
+
+typedef struct {
+  const char *name;
+  uint32_t index;
+} SortEntry;
+
+void archium_localdb_init(ArchiumLocalDb *db) { memset(db, 0, sizeof(*db)); }
+
+void archium_localdb_free(ArchiumLocalDb *db) {
+  if (db->map) {
+    munmap(db->map, db->map_size);
+    archium_localdb_init(db);
+    return;
+  }
+
+  free(db->name);
+  free(db->version);
+  free(db->reason);
+  free(db->size);
+  free(db->install_date);
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    free(db->list_first[list]);
+    free(db->list_length[list]);
+  }
+  free(db->items);
+  free(db->strings);
+  archium_localdb_init(db);
+}
+
+static int grow_array(void *array, size_t element_size, uint32_t capacity) {
+  void **slot = array;
+  void *grown = realloc(*slot, (size_t)capacity * element_size);
+  if (!grown) {
+    return 0;
+  }
+  *slot = grown;
+  return 1;
+}
+
+static int reserve_packages(ArchiumLocalDb *db, uint32_t needed) {
+  if (needed <= db->capacity) {
+    return 1;
+  }
+
+  uint32_t capacity = db->capacity ? db->capacity : LOCALDB_INITIAL_PACKAGES;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+  if (!grow_array(&db->name, sizeof(*db->name), capacity) ||
+      !grow_array(&db->version, sizeof(*db->version), capacity) ||
+      !grow_array(&db->reason, sizeof(*db->reason), capacity) ||
+      !grow_array(&db->size, sizeof(*db->size), capacity) ||
+      !grow_array(&db->install_date, sizeof(*db->install_date), capacity)) {
+    return 0;
+  }
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    if (!grow_array(&db->list_first[list], sizeof(uint32_t), capacity) ||
+        !grow_array(&db->list_length[list], sizeof(uint32_t), capacity)) {
+      return 0;
+    }
+  }
+  db->capacity = capacity;
+  return 1;
+}
+
+static int reserve_strings(ArchiumLocalDb *db, size_t extra) {
+  if (extra >= UINT32_MAX - db->strings_size - 1) {
+    return 0;
+  }
+
+  size_t needed = db->strings_size + extra + 1;
+  if (needed <= db->strings_capacity) {
+    return 1;
+  }
+
+  uint32_t capacity =
+      db->strings_capacity ? db->strings_capacity : LOCALDB_INITIAL_STRINGS;
+  while (needed > capacity) {
+    capacity = capacity > UINT32_MAX / 2 ? UINT32_MAX : capacity * 2;
+  }
+  if (!grow_array(&db->strings, 1, capacity)) {
+    return 0;
+  }
+  db->strings_capacity = capacity;
+  return 1;
+}
+
+static int reserve_items(ArchiumLocalDb *db, uint32_t extra) {
+  uint32_t needed = db->item_count + extra;
+  if (needed <= db->item_capacity) {
+    return 1;
+  }
+
+  uint32_t capacity =
+      db->item_capacity ? db->item_capacity : LOCALDB_INITIAL_ITEMS;
+  while (capacity < needed) {
+    capacity *= 2;
+  }
+  if (!grow_array(&db->items, sizeof(*db->items), capacity)) {
+    return 0;
+  }
+  db->item_capacity = capacity;
+  return 1;
+}
+
+static int append_string(ArchiumLocalDb *db, const char *text, size_t length,
+                         uint32_t *offset) {
+  if (!reserve_strings(db, length)) {
+    return 0;
+  }
+
+  if (db->strings_size == 0 && length > 0) {
+    db->strings[db->strings_size++] = '\0';
+  }
+  *offset = length > 0 ? db->strings_size : 0;
+  if (length > 0) {
+    memcpy(db->strings + db->strings_size, text, length);
+    db->strings[db->strings_size + length] = '\0';
+    db->strings_size += (uint32_t)length + 1;
+  }
+  return 1;
+}
+
+static int append_item(ArchiumLocalDb *db, uint32_t offset) {
+  if (!reserve_items(db, 1)) {
+    return 0;
+  }
+  db->items[db->item_count++] = offset;
+  return 1;
+}
+
+static uint64_t parse_unsigned(const char *text, size_t length) {
+  uint64_t value = 0;
+  for (size_t i = 0; i < length && isdigit((unsigned char)text[i]); i++) {
+    value = value * 10 + (uint64_t)(text[i] - '0');
+  }
+  return value;
+}
+
+int archium_localdb_parse_desc(ArchiumLocalDb *db, const char *desc,
+                               size_t length) {
+  if (!reserve_packages(db, db->count + 1)) {
+    return 0;
+  }
+
+  uint32_t index = db->count;
+  uint32_t strings_mark = db->strings_size;
+  uint32_t items_mark = db->item_count;
+
+  db->name[index] = 0;
+  db->version[index] = 0;
+  db->reason[index] = ARCHIUM_LOCALDB_REASON_EXPLICIT;
+  db->size[index] = 0;
+  db->install_date[index] = 0;
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    db->list_first[list][index] = 0;
+    db->list_length[list][index] = 0;
+  }
+
+  DescField field = FIELD_NONE;
+  ArchiumLocalDbList list = 0;
+  const char *end = desc + length;
+  const char *line = desc;
+  while (line < end) {
+    const char *newline = memchr(line, '\n', (size_t)(end - line));
+    size_t line_length =
+        newline ? (size_t)(newline - line) : (size_t)(end - line);
+    const char *next = newline ? newline + 1 : end;
+
+    if (line_length == 0) {
+      field = FIELD_NONE;
+      line = next;
+      continue;
+    }
+
+    if (field == FIELD_NONE) {
+      if (line[0] == '%' && line[line_length - 1] == '%') {
+        for (size_t i = 0; i < sizeof(desc_fields) / sizeof(desc_fields[0]);
+             i++) {
+          if (strlen(desc_fields[i].header) == line_length &&
+              memcmp(desc_fields[i].header, line, line_length) == 0) {
+            field = desc_fields[i].field;
+            list = desc_fields[i].list;
+            break;
+          }
+        }
+        if (field == FIELD_LIST) {
+          db->list_first[list][index] = db->item_count;
+          db->list_length[list][index] = 0;
+        }
+      }
+      line = next;
+      continue;
+    }
+
+    uint32_t offset;
+    switch (field) {
+      case FIELD_NAME:
+      case FIELD_VERSION:
+        if (!append_string(db, line, line_length, &offset)) {
+          goto fail;
+        }
+        if (field == FIELD_NAME) {
+          db->name[index] = offset;
+        } else {
+          db->version[index] = offset;
+        }
+        field = FIELD_NONE;
+        break;
+      case FIELD_REASON:
+        db->reason[index] = parse_unsigned(line, line_length) ? 1 : 0;
+        field = FIELD_NONE;
+        break;
+      case FIELD_SIZE:
+        db->size[index] = parse_unsigned(line, line_length);
+        field = FIELD_NONE;
+        break;
+      case FIELD_INSTALLDATE:
+        db->install_date[index] = (int64_t)parse_unsigned(line, line_length);
+        field = FIELD_NONE;
+        break;
+      case FIELD_LIST:
+        if (!append_string(db, line, line_length, &offset) ||
+            !append_item(db, offset)) {
+          goto fail;
+        }
+        db->list_length[list][index]++;
+        break;
+      default:
+        break;
+    }
+    line = next;
+  }
+
+  if (db->name[index] == 0) {
+    db->strings_size = strings_mark;
+    db->item_count = items_mark;
+    return 1;
+  }
+  db->count++;
+  return 1;
+
+fail:
+  db->strings_size = strings_mark;
+  db->item_count = items_mark;
+  return 0;
+}
+
+static int read_desc(int dir_fd, const char *entry, char **buffer,
+                     size_t *capacity, size_t *length) {
+  char path[NAME_MAX + 8];
+  if (snprintf(path, sizeof(path), "%s/desc", entry) >= (int)sizeof(path)) {
+    return 0;
+  }
+
+  int fd = openat(dir_fd, path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+
+  *length = 0;
+  for (;;) {
+    if (*length == *capacity) {
+      size_t grown_capacity = *capacity ? *capacity * 2 : LOCALDB_DESC_CHUNK;
+      char *grown = realloc(*buffer, grown_capacity);
+      if (!grown) {
+        close(fd);
+        return 0;
+      }
+      *buffer = grown;
+      *capacity = grown_capacity;
+    }
+
+    ssize_t got = read(fd, *buffer + *length, *capacity - *length);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      close(fd);
+      return 0;
+    }
+    if (got == 0) {
+      break;
+    }
+    *length += (size_t)got;
+  }
+  close(fd);
+  return 1;
+}
+
+static int compare_sort_entries(const void *a, const void *b) {
+  const SortEntry *left = a;
+  const SortEntry *right = b;
+  return strcmp(left->name, right->name);
+}
+
+#define LOCALDB_PERMUTE(db, field, order, scratch)                  \
+  do {                                                              \
+    for (uint32_t i = 0; i < (db)->count; i++) {                    \
+      memcpy((char *)(scratch) + (size_t)i * sizeof(*(db)->field),  \
+             &(db)->field[(order)[i].index], sizeof(*(db)->field)); \
+    }                                                               \
+    memcpy((db)->field, (scratch),                                  \
+           (size_t)(db)->count * sizeof(*(db)->field));             \
+  } while (0)
+
+static int sort_by_name(ArchiumLocalDb *db) {
+  if (db->count < 2) {
+    return 1;
+  }
+
+  SortEntry *order = malloc((size_t)db->count * sizeof(*order));
+  uint64_t *scratch = malloc((size_t)db->count * sizeof(*scratch));
+  if (!order || !scratch) {
+    free(order);
+    free(scratch);
+    return 0;
+  }
+
+  for (uint32_t i = 0; i < db->count; i++) {
+    order[i].name = db->strings + db->name[i];
+    order[i].index = i;
+  }
+  qsort(order, db->count, sizeof(*order), compare_sort_entries);
+
+  LOCALDB_PERMUTE(db, name, order, scratch);
+  LOCALDB_PERMUTE(db, version, order, scratch);
+  LOCALDB_PERMUTE(db, reason, order, scratch);
+  LOCALDB_PERMUTE(db, size, order, scratch);
+  LOCALDB_PERMUTE(db, install_date, order, scratch);
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    LOCALDB_PERMUTE(db, list_first[list], order, scratch);
+    LOCALDB_PERMUTE(db, list_length[list], order, scratch);
+  }
+
+  free(order);
+  free(scratch);
+  return 1;
+}
+
+static int append_partial(ArchiumLocalDb *db, const ArchiumLocalDb *part) {
+  if (part->count == 0) {
+    return 1;
+  }
+  if (!reserve_packages(db, db->count + part->count) ||
+      !reserve_strings(db, part->strings_size) ||
+      !reserve_items(db, part->item_count)) {
+    return 0;
+  }
+
+  uint32_t string_base = db->strings_size;
+  uint32_t item_base = db->item_count;
+  memcpy(db->strings + string_base, part->strings, part->strings_size);
+  db->strings_size += part->strings_size;
+
+  for (uint32_t i = 0; i < part->item_count; i++) {
+    uint32_t offset = part->items[i];
+    db->items[item_base + i] = offset ? offset + string_base : 0;
+  }
+  db->item_count += part->item_count;
+
+  for (uint32_t i = 0; i < part->count; i++) {
+    uint32_t to = db->count + i;
+    db->name[to] = part->name[i] + string_base;
+    db->version[to] = part->version[i] ? part->version[i] + string_base : 0;
+    db->reason[to] = part->reason[i];
+    db->size[to] = part->size[i];
+    db->install_date[to] = part->install_date[i];
+    for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+      db->list_first[list][to] = part->list_first[list][i] + item_base;
+      db->list_length[list][to] = part->list_length[list][i];
+    }
+  }
+  db->count += part->count;
+  return 1;
+}
+
+typedef struct {
+  _Alignas(64) ArchiumLocalDb db;
+  char *buffer;
+  size_t capacity;
+  int failed;
+} ScanShard;
+
+typedef struct {
+  int dir_fd;
+  char **entries;
+  ScanShard *shards;
+} ScanJob;
+
+static void scan_entry(size_t worker, size_t index, void *user_data) {
+  ScanJob *job = user_data;
+  ScanShard *shard = &job->shards[worker];
+  if (shard->failed) {
+    return;
+  }
+
+  size_t length;
+  if (read_desc(job->dir_fd, job->entries[index], &shard->buffer,
+                &shard->capacity, &length) &&
+      !archium_localdb_parse_desc(&shard->db, shard->buffer, length)) {
+    shard->failed = 1;
+  }
+}
+
+static int collect_entries(DIR *dir, ArchiumArena *arena, char ***entries,
+                           size_t *count) {
+  size_t capacity = 0;
+  *entries = NULL;
+  *count = 0;
+
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.' ||
+        strcmp(entry->d_name, "ALPM_DB_VERSION") == 0) {
+      continue;
+    }
+
+    if (*count == capacity) {
+      size_t grown_capacity =
+          capacity ? capacity * 2 : LOCALDB_INITIAL_PACKAGES;
+      char **grown = archium_arena_grow(arena, *entries,
+                                        capacity * sizeof(*grown),
+                                        grown_capacity * sizeof(*grown));
+      if (!grown) {
+        return 0;
+      }
+      *entries = grown;
+      capacity = grown_capacity;
+    }
+
+    char *name =
+        archium_arena_strndup(arena, entry->d_name, strlen(entry->d_name));
+    if (!name) {
+      return 0;
+    }
+    (*entries)[(*count)++] = name;
+  }
+  return 1;
+}
+
+int archium_localdb_load(ArchiumLocalDb *db, const char *path,
+                         size_t threads) {
+  archium_localdb_init(db);
+
+  DIR *dir = opendir(path ? path : ARCHIUM_LOCAL_DB_DIR);
+  if (!dir) {
+    return 0;
+  }
+
+  ArchiumArena arena;
+  archium_arena_init(&arena, 0);
+  ScanJob job = {dirfd(dir), NULL, NULL};
+  size_t count = 0;
+  int ok = collect_entries(dir, &arena, &job.entries, &count);
+
+  if (threads == 0) {
+    threads = archium_pool_default_threads();
+  }
+  if (threads > count / LOCALDB_MIN_ENTRIES_PER_THREAD) {
+    threads = count / LOCALDB_MIN_ENTRIES_PER_THREAD;
+  }
+  if (threads == 0) {
+    threads = 1;
+  }
+
+  ArchiumThreadPool *pool = NULL;
+  if (ok && threads > 1) {
+    pool = archium_pool_create(threads);
+  }
+  threads = archium_pool_thread_count(pool);
+
+  job.shards = ok ? aligned_alloc(_Alignof(ScanShard),
+                                  threads * sizeof(*job.shards))
+                  : NULL;
+  if (job.shards) {
+    memset(job.shards, 0, threads * sizeof(*job.shards));
+    archium_pool_run(pool, count, scan_entry, &job);
+  } else {
+    ok = 0;
+  }
+  archium_pool_destroy(pool);
+
+  for (size_t i = 0; job.shards && i < threads; i++) {
+    ScanShard *shard = &job.shards[i];
+    if (shard->failed) {
+      ok = 0;
+    }
+    if (ok) {
+      if (i == 0) {
+        *db = shard->db;
+        archium_localdb_init(&shard->db);
+      } else if (!append_partial(db, &shard->db)) {
+        ok = 0;
+      }
+    }
+    archium_localdb_free(&shard->db);
+    free(shard->buffer);
+  }
+
+  free(job.shards);
+  archium_arena_free(&arena);
+  closedir(dir);
+
+  if (!ok || !sort_by_name(db)) {
+    archium_localdb_free(db);
+    return 0;
+  }
+  return 1;
+}
+
+static size_t snapshot_size(const ArchiumLocalDbHeader *header) {
+  size_t count = header->count;
+  return sizeof(*header) + count * (2 * sizeof(uint64_t) + sizeof(uint8_t)) +
+         count * sizeof(uint32_t) * (2 + 2 * ARCHIUM_LOCALDB_LIST_COUNT) +
+         (size_t)header->item_count * sizeof(uint32_t) + header->strings_size;
+}
+
+static int snapshot_offsets_valid(const ArchiumLocalDb *db) {
+  for (uint32_t i = 0; i < db->count; i++) {
+    if (db->name[i] == 0 || db->name[i] >= db->strings_size ||
+        db->version[i] >= db->strings_size) {
+      return 0;
+    }
+    for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+      if (db->list_length[list][i] > db->item_count ||
+          db->list_first[list][i] >
+              db->item_count - db->list_length[list][i]) {
+        return 0;
+      }
+    }
+  }
+  for (uint32_t i = 0; i < db->item_count; i++) {
+    if (db->items[i] >= db->strings_size && db->items[i] != 0) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int archium_localdb_snapshot_open(ArchiumLocalDb *db, const char *path,
+                                  const ArchiumLocalDbSource *source) {
+  archium_localdb_init(db);
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      st.st_size < (off_t)sizeof(ArchiumLocalDbHeader)) {
+    close(fd);
+    return 0;
+  }
+
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return 0;
+  }
+
+  const ArchiumLocalDbHeader *header = map;
+  if (memcmp(header->magic, ARCHIUM_LOCALDB_MAGIC, sizeof(header->magic)) !=
+          0 ||
+      header->version != ARCHIUM_LOCALDB_SNAPSHOT_VERSION ||
+      header->alpm_db_version != source->alpm_db_version ||
+      header->source_inode != (uint64_t)source->dir.st_ino ||
+      header->source_mtime_sec != (int64_t)source->dir.st_mtim.tv_sec ||
+      header->source_mtime_nsec != (int64_t)source->dir.st_mtim.tv_nsec ||
+      header->desc_ctime_sec != (int64_t)source->newest_desc.tv_sec ||
+      header->desc_ctime_nsec != (int64_t)source->newest_desc.tv_nsec ||
+      snapshot_size(header) != (size_t)st.st_size ||
+      (header->strings_size == 0 && header->count != 0) ||
+      (header->strings_size > 0 &&
+       ((const char *)map)[st.st_size - 1] != '\0')) {
+    munmap(map, (size_t)st.st_size);
+    return 0;
+  }
+
+  char *cursor = (char *)map + sizeof(*header);
+  size_t count = header->count;
+  db->size = (uint64_t *)cursor;
+  cursor += count * sizeof(uint64_t);
+  db->install_date = (int64_t *)cursor;
+  cursor += count * sizeof(int64_t);
+  db->name = (uint32_t *)cursor;
+  cursor += count * sizeof(uint32_t);
+  db->version = (uint32_t *)cursor;
+  cursor += count * sizeof(uint32_t);
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    db->list_first[list] = (uint32_t *)cursor;
+    cursor += count * sizeof(uint32_t);
+    db->list_length[list] = (uint32_t *)cursor;
+    cursor += count * sizeof(uint32_t);
+  }
+  db->items = (uint32_t *)cursor;
+  cursor += (size_t)header->item_count * sizeof(uint32_t);
+  db->reason = (uint8_t *)cursor;
+  cursor += count;
+  db->strings = header->strings_size > 0 ? cursor : NULL;
+
+  db->count = header->count;
+  db->item_count = header->item_count;
+  db->strings_size = header->strings_size;
+  db->map = map;
+  db->map_size = (size_t)st.st_size;
+
+  if (!snapshot_offsets_valid(db)) {
+    archium_localdb_free(db);
+    return 0;
+  }
+  return 1;
+}
+
+int archium_localdb_snapshot_write(const ArchiumLocalDb *db, const char *path,
+                                   const ArchiumLocalDbSource *source) {
+  ArchiumLocalDbHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ARCHIUM_LOCALDB_MAGIC, sizeof(header.magic));
+  header.version = ARCHIUM_LOCALDB_SNAPSHOT_VERSION;
+  header.count = db->count;
+  header.item_count = db->item_count;
+  header.strings_size = db->strings_size;
+  header.alpm_db_version = source->alpm_db_version;
+  header.source_inode = (uint64_t)source->dir.st_ino;
+  header.source_mtime_sec = (int64_t)source->dir.st_mtim.tv_sec;
+  header.source_mtime_nsec = (int64_t)source->dir.st_mtim.tv_nsec;
+  header.desc_ctime_sec = (int64_t)source->newest_desc.tv_sec;
+  header.desc_ctime_nsec = (int64_t)source->newest_desc.tv_nsec;
+
+  char temp_path[COMMAND_BUFFER_SIZE];
+  FILE *fp = NULL;
+  if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) <
+      (int)sizeof(temp_path)) {
+    fp = fopen(temp_path, "wb");
+  }
+  if (!fp) {
+    return 0;
+  }
+
+  size_t count = db->count;
+  int ok = fwrite(&header, sizeof(header), 1, fp) == 1;
+  if (count > 0) {
+    ok = ok && fwrite(db->size, sizeof(uint64_t), count, fp) == count &&
+         fwrite(db->install_date, sizeof(int64_t), count, fp) == count &&
+         fwrite(db->name, sizeof(uint32_t), count, fp) == count &&
+         fwrite(db->version, sizeof(uint32_t), count, fp) == count;
+    for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+      ok = ok &&
+           fwrite(db->list_first[list], sizeof(uint32_t), count, fp) ==
+               count &&
+           fwrite(db->list_length[list], sizeof(uint32_t), count, fp) ==
+               count;
+    }
+  }
+  ok = ok && (db->item_count == 0 ||
+              fwrite(db->items, sizeof(uint32_t), db->item_count, fp) ==
+                  db->item_count);
+  ok = ok && (count == 0 || fwrite(db->reason, 1, count, fp) == count);
+  ok = ok && (db->strings_size == 0 ||
+              fwrite(db->strings, 1, db->strings_size, fp) ==
+                  db->strings_size);
+
+  if (fclose(fp) != 0) {
+    ok = 0;
+  }
+  if (!ok || rename(temp_path, path) != 0) {
+    unlink(temp_path);
+    return 0;
+  }
+  return 1;
+}
+
+static uint32_t read_alpm_db_version(int dir_fd) {
+  int fd = openat(dir_fd, "ALPM_DB_VERSION", O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+
+  char text[32];
+  ssize_t got = read(fd, text, sizeof(text) - 1);
+  close(fd);
+  if (got <= 0) {
+    return 0;
+  }
+  text[got] = '\0';
+  return (uint32_t)strtoul(text, NULL, 10);
+}
+
+static int newest_desc_change(int dir_fd, struct timespec *newest) {
+  int list_fd = dup(dir_fd);
+  DIR *dir = list_fd >= 0 ? fdopendir(list_fd) : NULL;
+  if (!dir) {
+    if (list_fd >= 0) {
+      close(list_fd);
+    }
+    return 0;
+  }
+
+  newest->tv_sec = 0;
+  newest->tv_nsec = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (entry->d_name[0] == '.' ||
+        strcmp(entry->d_name, "ALPM_DB_VERSION") == 0) {
+      continue;
+    }
+
+    char desc_path[NAME_MAX + 8];
+    struct stat st;
+    if (snprintf(desc_path, sizeof(desc_path), "%s/desc", entry->d_name) >=
+            (int)sizeof(desc_path) ||
+        fstatat(dir_fd, desc_path, &st, 0) != 0) {
+      continue;
+    }
+    if (st.st_ctim.tv_sec > newest->tv_sec ||
+        (st.st_ctim.tv_sec == newest->tv_sec &&
+         st.st_ctim.tv_nsec > newest->tv_nsec)) {
+      *newest = st.st_ctim;
+    }
+  }
+  closedir(dir);
+  return 1;
+}
+
+int archium_localdb_stat_source(const char *path,
+                                ArchiumLocalDbSource *source) {
+  memset(source, 0, sizeof(*source));
+
+  int dir_fd = open(path ? path : ARCHIUM_LOCAL_DB_DIR,
+                    O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (dir_fd < 0) {
+    return 0;
+  }
+
+  int ok = fstat(dir_fd, &source->dir) == 0 &&
+           newest_desc_change(dir_fd, &source->newest_desc);
+  source->alpm_db_version = read_alpm_db_version(dir_fd);
+  close(dir_fd);
+  return ok;
+}
+
+int archium_localdb_open_cached(ArchiumLocalDb *db, const char *path,
+                                const char *snapshot_path, size_t threads) {
+  ArchiumLocalDbSource source;
+  int have_source =
+      snapshot_path && archium_localdb_stat_source(path, &source);
+
+  if (have_source && archium_localdb_snapshot_open(db, snapshot_path,
+                                                   &source)) {
+    return 1;
+  }
+
+  if (!archium_localdb_load(db, path, threads)) {
+    return 0;
+  }
+
+  if (have_source &&
+      !archium_localdb_snapshot_write(db, snapshot_path, &source)) {
+    log_debug("Failed to write local package database snapshot");
+  }
+  return 1;
+}
+
+static int parse_sync_desc(const char *desc, size_t length, void *user_data) {
+  return archium_localdb_parse_desc(user_data, desc, length);
+}
+
+int archium_localdb_load_sync(ArchiumLocalDb *db, const char *sync_dir) {
+  archium_localdb_init(db);
+  if (!sync_dir) {
+    sync_dir = ARCHIUM_SYNC_DB_DIR;
+  }
+
+  DIR *dir = opendir(sync_dir);
+  if (!dir) {
+    return 0;
+  }
+
+  int databases = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (!archium_syncdb_is_db_file(entry->d_name)) {
+      continue;
+    }
+
+    char db_path[COMMAND_BUFFER_SIZE];
+    if (snprintf(db_path, sizeof(db_path), "%s/%s", sync_dir,
+                 entry->d_name) >= (int)sizeof(db_path)) {
+      continue;
+    }
+    if (archium_syncdb_foreach_desc(db_path, parse_sync_desc, db)) {
+      databases++;
+    }
+  }
+  closedir(dir);
+
+  if (!sort_by_name(db)) {
+    archium_localdb_free(db);
+    return 0;
+  }
+  return databases;
+}
+
+const char *archium_localdb_string(const ArchiumLocalDb *db, uint32_t offset) {
+  return db->strings ? db->strings + offset : "";
+}
+
+const char *archium_localdb_name(const ArchiumLocalDb *db, uint32_t index) {
+  return archium_localdb_string(db, db->name[index]);
+}
+
+const char *archium_localdb_version(const ArchiumLocalDb *db, uint32_t index) {
+  return archium_localdb_string(db, db->version[index]);
+}
+
+const uint32_t *archium_localdb_list(const ArchiumLocalDb *db, uint32_t index,
+                                     ArchiumLocalDbList list,
+                                     uint32_t *length) {
+  *length = db->list_length[list][index];
+  return *length ? db->items + db->list_first[list][index] : NULL;
+}
+
+int64_t archium_localdb_find(const ArchiumLocalDb *db, const char *name,
+                             size_t length) {
+  uint32_t low = 0;
+  uint32_t high = db->count;
+  while (low < high) {
+    uint32_t middle = low + (high - low) / 2;
+    const char *candidate = archium_localdb_name(db, middle);
+    int cmp = strncmp(candidate, name, length);
+    if (cmp == 0) {
+      cmp = candidate[length] == '\0' ? 0 : 1;
+    }
+    if (cmp == 0) {
+      return middle;
+    }
+    if (cmp < 0) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  return -1;
+}
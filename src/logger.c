@@ -0,0 +1,415 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+
+#include "include/archium.h"
+
+#define LOG_BATCH_SIZE (64 * 1024)
+#define LOG_LINE_MAX (ARCHIUM_LOG_LEVEL_MAX + ARCHIUM_LOG_MESSAGE_MAX + 64)
+
+typedef enum { LOGGER_CLOSED, LOGGER_ASYNC, LOGGER_SYNC } LoggerState;
+
+typedef struct {
+  atomic_size_t sequence;
+  time_t timestamp;
+  size_t level_length;
+  size_t message_length;
+  char level[ARCHIUM_LOG_LEVEL_MAX];
+  char message[ARCHIUM_LOG_MESSAGE_MAX];
+} LogSlot;
+
+static LogSlot slots[ARCHIUM_LOG_SLOTS];
+static atomic_size_t enqueue_position;
+static atomic_size_t dequeue_position;
+static atomic_size_t dropped_messages;
+
+static atomic_int logger_state = LOGGER_CLOSED;
+static atomic_int logger_stopping;
+static atomic_int wake_pending;
+static pthread_mutex_t open_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t drain_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_t logger_thread_id;
+static int shutdown_registered = 0;
+
+static char log_path[PATH_MAX];
+static int log_fd = -1;
+static int wake_fd = -1;
+
+static time_t cached_timestamp = (time_t)-1;
+static char cached_timestamp_text[32];
+static long utc_offset_seconds;
+
+static int open_log_file(void) {
+  return open(log_path, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
+}
+
+static void rotate_log_file(void) {
+  char rotated[PATH_MAX + 2];
+  snprintf(rotated, sizeof(rotated), "%s.1", log_path);
+
+  close(log_fd);
+  rename(log_path, rotated);
+  log_fd = open_log_file();
+}
+
+static void write_batch(const char *data, size_t length) {
+  if (log_fd < 0) {
+    return;
+  }
+
+  struct stat st;
+  if (fstat(log_fd, &st) == 0 && st.st_size > 0 &&
+      (size_t)st.st_size + length > ARCHIUM_LOG_ROTATE_BYTES) {
+    rotate_log_file();
+    if (log_fd < 0) {
+      return;
+    }
+  }
+
+  while (length > 0) {
+    ssize_t written = write(log_fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+}
+
+static const char *format_timestamp(time_t timestamp) {
+  if (timestamp != cached_timestamp) {
+    struct tm local;
+    localtime_r(&timestamp, &local);
+    strftime(cached_timestamp_text, sizeof(cached_timestamp_text),
+             "%a %b %e %H:%M:%S %Y", &local);
+    cached_timestamp = timestamp;
+  }
+  return cached_timestamp_text;
+}
+
+static size_t format_slot(char *out, size_t size, const LogSlot *slot) {
+  int length = snprintf(out, size, "[%s] [%.*s] %.*s\n",
+                        format_timestamp(slot->timestamp),
+                        (int)slot->level_length, slot->level,
+                        (int)slot->message_length, slot->message);
+  if (length < 0) {
+    return 0;
+  }
+  return (size_t)length < size ? (size_t)length : size - 1;
+}
+
+/*
+ * Slots are only handed back to writers once their batch is on disk, so a
+ * drain interrupted by a fatal signal can at worst repeat lines in
+ * archium_logger_flush_from_signal(), never lose them.
+ */
+static void release_slots(size_t end) {
+  size_t position =
+      atomic_load_explicit(&dequeue_position, memory_order_relaxed);
+  for (; position != end; position++) {
+    atomic_store_explicit(&slots[position & (ARCHIUM_LOG_SLOTS - 1)].sequence,
+                          position + ARCHIUM_LOG_SLOTS, memory_order_release);
+  }
+  atomic_store_explicit(&dequeue_position, end, memory_order_release);
+}
+
+static void drain_ring(void) {
+  static char batch[LOG_BATCH_SIZE];
+  size_t used = 0;
+  size_t position =
+      atomic_load_explicit(&dequeue_position, memory_order_relaxed);
+
+  for (;;) {
+    LogSlot *slot = &slots[position & (ARCHIUM_LOG_SLOTS - 1)];
+    size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence != position + 1) {
+      break;
+    }
+
+    if (used + LOG_LINE_MAX > sizeof(batch)) {
+      write_batch(batch, used);
+      used = 0;
+      release_slots(position);
+    }
+    used += format_slot(batch + used, sizeof(batch) - used, slot);
+    position++;
+  }
+
+  size_t dropped = atomic_exchange(&dropped_messages, 0);
+  if (dropped > 0) {
+    int length = snprintf(batch + used, sizeof(batch) - used,
+                          "[%s] [WARN] %zu log messages dropped\n",
+                          format_timestamp(time(NULL)), dropped);
+    if (length > 0 && (size_t)length < sizeof(batch) - used) {
+      used += (size_t)length;
+    }
+  }
+
+  if (used > 0) {
+    write_batch(batch, used);
+  }
+  release_slots(position);
+}
+
+static char *append_text(char *out, const char *end, const char *text,
+                         size_t length) {
+  if (length > (size_t)(end - out)) {
+    length = (size_t)(end - out);
+  }
+  memcpy(out, text, length);
+  return out + length;
+}
+
+static char *append_number(char *out, const char *end, long value,
+                           int width, char pad) {
+  char digits[24];
+  int count = 0;
+  do {
+    digits[count++] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value > 0 && count < (int)sizeof(digits));
+  while (count < width && out < end) {
+    *out++ = pad;
+    width--;
+  }
+  while (count > 0 && out < end) {
+    *out++ = digits[--count];
+  }
+  return out;
+}
+
+/*
+ * Same layout as format_timestamp() ("%a %b %e %H:%M:%S %Y"), computed by
+ * hand from the UTC offset captured at open time because localtime_r and
+ * strftime are not async-signal-safe.
+ */
+static char *append_timestamp(char *out, const char *end, time_t timestamp) {
+  static const char days[] = "ThuFriSatSunMonTueWed";
+  static const char months[] = "JanFebMarAprMayJunJulAugSepOctNovDec";
+
+  long long local = (long long)timestamp + utc_offset_seconds;
+  long long day = local >= 0 ? local / 86400 : (local - 86399) / 86400;
+  long seconds = (long)(local - day * 86400);
+
+  long long era = (day + 719468 >= 0 ? day + 719468 : day + 719468 - 146096) /
+                  146097;
+  long day_of_era = (long)(day + 719468 - era * 146097);
+  long year_of_era =
+      (day_of_era - day_of_era / 1460 + day_of_era / 36524 -
+       day_of_era / 146096) /
+      365;
+  long day_of_year =
+      day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+  long month_index = (5 * day_of_year + 2) / 153;
+  long month_day = day_of_year - (153 * month_index + 2) / 5 + 1;
+  long month = month_index < 10 ? month_index + 3 : month_index - 9;
+  long year = (long)(year_of_era + era * 400) + (month <= 2);
+  long weekday = (long)(((day % 7) + 7) % 7);
+
+  out = append_text(out, end, days + weekday * 3, 3);
+  out = append_text(out, end, " ", 1);
+  out = append_text(out, end, months + (month - 1) * 3, 3);
+  out = append_text(out, end, " ", 1);
+  out = append_number(out, end, month_day, 2, ' ');
+  out = append_text(out, end, " ", 1);
+  out = append_number(out, end, seconds / 3600, 2, '0');
+  out = append_text(out, end, ":", 1);
+  out = append_number(out, end, seconds / 60 % 60, 2, '0');
+  out = append_text(out, end, ":", 1);
+  out = append_number(out, end, seconds % 60, 2, '0');
+  out = append_text(out, end, " ", 1);
+  return append_number(out, end, year, 4, '0');
+}
+
+void archium_logger_flush_from_signal(void) {
+  static char line[LOG_LINE_MAX];
+  if (atomic_load(&logger_state) == LOGGER_CLOSED || log_fd < 0) {
+    return;
+  }
+
+  size_t position =
+      atomic_load_explicit(&dequeue_position, memory_order_acquire);
+  for (;;) {
+    const LogSlot *slot = &slots[position & (ARCHIUM_LOG_SLOTS - 1)];
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) !=
+        position + 1) {
+      break;
+    }
+
+    char *out = line;
+    const char *end = line + sizeof(line);
+    out = append_text(out, end, "[", 1);
+    out = append_timestamp(out, end, slot->timestamp);
+    out = append_text(out, end, "] [", 3);
+    out = append_text(out, end, slot->level, slot->level_length);
+    out = append_text(out, end, "] ", 2);
+    out = append_text(out, end, slot->message, slot->message_length);
+    out = append_text(out, end, "\n", 1);
+
+    const char *cursor = line;
+    while (cursor < out) {
+      ssize_t written = write(log_fd, cursor, (size_t)(out - cursor));
+      if (written < 0) {
+        if (errno == EINTR) {
+          continue;
+        }
+        return;
+      }
+      cursor += written;
+    }
+    position++;
+  }
+}
+
+static void *logger_thread(void *arg) {
+  (void)arg;
+
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  while (!atomic_load(&logger_stopping)) {
+    uint64_t value;
+    if (read(wake_fd, &value, sizeof(value)) < 0 && errno != EINTR) {
+      break;
+    }
+    atomic_store(&wake_pending, 0);
+    archium_logger_flush();
+  }
+  return NULL;
+}
+
+int archium_logger_open(const char *path) {
+  if (atomic_load_explicit(&logger_state, memory_order_acquire) !=
+      LOGGER_CLOSED) {
+    return 1;
+  }
+
+  pthread_mutex_lock(&open_mutex);
+  if (atomic_load(&logger_state) != LOGGER_CLOSED) {
+    pthread_mutex_unlock(&open_mutex);
+    return 1;
+  }
+
+  if (!path || snprintf(log_path, sizeof(log_path), "%s", path) >=
+                   (int)sizeof(log_path)) {
+    pthread_mutex_unlock(&open_mutex);
+    return 0;
+  }
+
+  log_fd = open_log_file();
+  if (log_fd < 0) {
+    pthread_mutex_unlock(&open_mutex);
+    return 0;
+  }
+
+  for (size_t i = 0; i < ARCHIUM_LOG_SLOTS; i++) {
+    atomic_init(&slots[i].sequence, i);
+  }
+  atomic_store(&enqueue_position, 0);
+  atomic_store(&dequeue_position, 0);
+
+  time_t now = time(NULL);
+  struct tm local;
+  if (localtime_r(&now, &local)) {
+    utc_offset_seconds = local.tm_gmtoff;
+  }
+
+  LoggerState state = LOGGER_SYNC;
+  wake_fd = eventfd(0, EFD_CLOEXEC);
+  if (wake_fd >= 0) {
+    if (pthread_create(&logger_thread_id, NULL, logger_thread, NULL) == 0) {
+      state = LOGGER_ASYNC;
+    } else {
+      close(wake_fd);
+      wake_fd = -1;
+    }
+  }
+
+  if (!shutdown_registered) {
+    atexit(archium_logger_shutdown);
+    shutdown_registered = 1;
+  }
+
+  atomic_store_explicit(&logger_state, state, memory_order_release);
+  pthread_mutex_unlock(&open_mutex);
+  return 1;
+}
+
+int archium_logger_write(const char *level, const char *message) {
+  int state = atomic_load_explicit(&logger_state, memory_order_acquire);
+  if (state == LOGGER_CLOSED) {
+    return 0;
+  }
+
+  size_t position =
+      atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+  LogSlot *slot;
+  for (;;) {
+    slot = &slots[position & (ARCHIUM_LOG_SLOTS - 1)];
+    size_t sequence =
+        atomic_load_explicit(&slot->sequence, memory_order_acquire);
+    if (sequence == position) {
+      if (atomic_compare_exchange_weak_explicit(
+              &enqueue_position, &position, position + 1,
+              memory_order_relaxed, memory_order_relaxed)) {
+        break;
+      }
+    } else if ((intptr_t)(sequence - position) < 0) {
+      atomic_fetch_add(&dropped_messages, 1);
+      return 1;
+    } else {
+      position = atomic_load_explicit(&enqueue_position, memory_order_relaxed);
+    }
+  }
+
+  slot->timestamp = time(NULL);
+  slot->level_length = strnlen(level, sizeof(slot->level));
+  memcpy(slot->level, level, slot->level_length);
+  slot->message_length = strnlen(message, sizeof(slot->message));
+  memcpy(slot->message, message, slot->message_length);
+  atomic_store_explicit(&slot->sequence, position + 1, memory_order_release);
+
+  if (state == LOGGER_SYNC) {
+    archium_logger_flush();
+  } else if (!atomic_exchange(&wake_pending, 1)) {
+    uint64_t one = 1;
+    if (write(wake_fd, &one, sizeof(one)) < 0) {
+      atomic_store(&wake_pending, 0);
+    }
+  }
+  return 1;
+}
+
+void archium_logger_flush(void) {
+  if (atomic_load(&logger_state) == LOGGER_CLOSED) {
+    return;
+  }
+
+  pthread_mutex_lock(&drain_mutex);
+  drain_ring();
+  pthread_mutex_unlock(&drain_mutex);
+}
+
+void archium_logger_shutdown(void) {
+  if (atomic_load(&logger_state) != LOGGER_ASYNC) {
+    return;
+  }
+
+  atomic_store(&logger_stopping, 1);
+  uint64_t one = 1;
+  if (write(wake_fd, &one, sizeof(one)) >= 0) {
+    pthread_join(logger_thread_id, NULL);
+  }
+
+  atomic_store(&logger_state, LOGGER_SYNC);
+  archium_logger_flush();
+}
@@ -1,7 +1,5 @@
 #include "include/archium.h"
 
-char **cached_commands = NULL;
-
 int main(int argc, char *argv[]) {
   ArchiumError status = parse_arguments(argc, argv);
   if (status != ARCHIUM_SUCCESS) {
@@ -65,7 +63,14 @@ int main(int argc, char *argv[]) {
   }
 
   rl_attempted_completion_function = command_completion;
-  cache_pacman_commands();
+
+  if (config.script_path) {
+    status = handle_script(config.script_path, package_manager);
+    log_info("Executed commands in script mode");
+    cleanup_cached_commands();
+    archium_plugin_cleanup();
+    return status;
+  }
 
   if (config.exec_mode) {
     status = handle_exec_command(config.exec_command, package_manager);
@@ -76,6 +81,8 @@ int main(int argc, char *argv[]) {
   }
 
   if (!config.json_output) {
+    start_completion_warmup();
+
     struct winsize w;
     int term_width = 80;
     if (config.show_welcome) {
@@ -122,10 +129,7 @@ int main(int argc, char *argv[]) {
 
       if (*input_line) {
         add_history(input_line);
-        status = handle_command(input_line, package_manager);
-        if (status != ARCHIUM_SUCCESS) {
-          archium_report_error(status, "Command execution failed", input_line);
-        }
+        handle_command_line(input_line, package_manager);
       }
     }
   } else {
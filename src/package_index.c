@@ -0,0 +1,397 @@
+#include <fcntl.h>
+#include <sys/mman.h>
+
+#include "include/archium.h"
+
+#define INDEX_INITIAL_NAMES 1024
+#define INDEX_INITIAL_BLOB (INDEX_INITIAL_NAMES * 16)
+
+int archium_index_open(ArchiumPackageIndex *index, const char *path) {
+  if (!index || !path) {
+    return 0;
+  }
+
+  memset(index, 0, sizeof(*index));
+
+  int fd = open(path, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(ArchiumIndexHeader)) {
+    close(fd);
+    return 0;
+  }
+
+  void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (map == MAP_FAILED) {
+    return 0;
+  }
+
+  const ArchiumIndexHeader *header = map;
+  size_t repos_size = (size_t)header->repo_count * sizeof(ArchiumIndexRepo);
+  size_t expected = sizeof(ArchiumIndexHeader) + repos_size +
+                    (size_t)header->count * sizeof(uint32_t) +
+                    (size_t)header->repo_name_count * sizeof(uint32_t) +
+                    header->blob_size;
+  if (memcmp(header->magic, ARCHIUM_INDEX_MAGIC, sizeof(header->magic)) != 0 ||
+      header->version != ARCHIUM_INDEX_VERSION ||
+      expected != (size_t)st.st_size ||
+      (header->blob_size == 0 && header->count != 0)) {
+    munmap(map, (size_t)st.st_size);
+    return 0;
+  }
+
+  const char *base = map;
+  const char *cursor = base + sizeof(ArchiumIndexHeader);
+  index->map = map;
+  index->map_size = (size_t)st.st_size;
+  index->header = header;
+  index->count = header->count;
+  index->blob_size = header->blob_size;
+  index->repo_count = header->repo_count;
+  index->repo_name_count = header->repo_name_count;
+  index->repos = (const ArchiumIndexRepo *)cursor;
+  cursor += repos_size;
+  index->offsets = (const uint32_t *)cursor;
+  cursor += (size_t)header->count * sizeof(uint32_t);
+  index->repo_offsets = (const uint32_t *)cursor;
+  cursor += (size_t)header->repo_name_count * sizeof(uint32_t);
+  index->blob = cursor;
+
+  if (index->blob_size > 0 && index->blob[index->blob_size - 1] != '\0') {
+    archium_index_close(index);
+    return 0;
+  }
+
+  return 1;
+}
+
+void archium_index_close(ArchiumPackageIndex *index) {
+  if (!index) {
+    return;
+  }
+
+  if (index->map) {
+    munmap(index->map, index->map_size);
+  }
+  memset(index, 0, sizeof(*index));
+}
+
+const char *archium_index_name(const ArchiumPackageIndex *index, uint32_t i) {
+  if (!index || i >= index->count) {
+    return NULL;
+  }
+
+  uint32_t offset = index->offsets[i];
+  if (offset >= index->blob_size) {
+    return NULL;
+  }
+  return index->blob + offset;
+}
+
+static uint32_t prefix_bound(const ArchiumPackageIndex *index,
+                             const char *prefix, size_t length, int upper) {
+  uint32_t low = 0;
+  uint32_t high = index->count;
+
+  while (low < high) {
+    uint32_t mid = low + (high - low) / 2;
+    const char *name = archium_index_name(index, mid);
+    int cmp = name ? strncmp(name, prefix, length) : -1;
+    if (cmp < 0 || (upper && cmp == 0)) {
+      low = mid + 1;
+    } else {
+      high = mid;
+    }
+  }
+
+  return low;
+}
+
+uint32_t archium_index_prefix_range(const ArchiumPackageIndex *index,
+                                    const char *prefix, size_t length,
+                                    uint32_t *first) {
+  if (!index || !prefix || !first) {
+    return 0;
+  }
+
+  if (length == 0) {
+    *first = 0;
+    return index->count;
+  }
+
+  *first = prefix_bound(index, prefix, length, 0);
+  return prefix_bound(index, prefix, length, 1) - *first;
+}
+
+const ArchiumIndexRepo *archium_index_find_repo(
+    const ArchiumPackageIndex *index, const char *name) {
+  if (!index || !name) {
+    return NULL;
+  }
+
+  for (uint32_t i = 0; i < index->repo_count; i++) {
+    const ArchiumIndexRepo *repo = &index->repos[i];
+    if (strncmp(repo->name, name, sizeof(repo->name)) == 0) {
+      return repo;
+    }
+  }
+  return NULL;
+}
+
+const char *archium_index_repo_name(const ArchiumPackageIndex *index,
+                                    const ArchiumIndexRepo *repo, uint32_t i) {
+  if (!index || !repo || i >= repo->count ||
+      (uint64_t)repo->first + i >= index->repo_name_count) {
+    return NULL;
+  }
+
+  uint32_t offset = index->repo_offsets[repo->first + i];
+  if (offset >= index->blob_size) {
+    return NULL;
+  }
+  return index->blob + offset;
+}
+
+int archium_index_repo_matches(const ArchiumIndexRepo *repo,
+                               const struct stat *st) {
+  return repo && st && repo->size == (uint64_t)st->st_size &&
+         repo->mtime_sec == (int64_t)st->st_mtim.tv_sec &&
+         repo->mtime_nsec == (int64_t)st->st_mtim.tv_nsec &&
+         repo->inode == (uint64_t)st->st_ino;
+}
+
+int archium_index_source_matches(const ArchiumPackageIndex *index,
+                                 const struct stat *st) {
+  return index && index->header && st &&
+         index->header->source_mtime_sec == (int64_t)st->st_mtim.tv_sec &&
+         index->header->source_mtime_nsec == (int64_t)st->st_mtim.tv_nsec;
+}
+
+void archium_index_builder_init(ArchiumIndexBuilder *builder) {
+  memset(builder, 0, sizeof(*builder));
+}
+
+void archium_index_builder_set_source(ArchiumIndexBuilder *builder,
+                                      const struct stat *st) {
+  builder->source_mtime_sec = (int64_t)st->st_mtim.tv_sec;
+  builder->source_mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+}
+
+int archium_index_builder_begin_repo(ArchiumIndexBuilder *builder,
+                                     const char *name, const struct stat *st) {
+  if (!builder || !name || !st ||
+      strlen(name) >= ARCHIUM_INDEX_REPO_NAME_MAX) {
+    return 0;
+  }
+
+  if (builder->repo_count == 0 && builder->count > 0) {
+    return 0;
+  }
+
+  if (builder->repo_count == builder->repo_capacity) {
+    size_t capacity = builder->repo_capacity ? builder->repo_capacity * 2 : 8;
+    ArchiumIndexRepo *repos =
+        realloc(builder->repos, capacity * sizeof(*builder->repos));
+    if (!repos) {
+      return 0;
+    }
+    builder->repos = repos;
+    builder->repo_capacity = capacity;
+  }
+
+  ArchiumIndexRepo *repo = &builder->repos[builder->repo_count++];
+  memset(repo, 0, sizeof(*repo));
+  snprintf(repo->name, sizeof(repo->name), "%s", name);
+  repo->size = (uint64_t)st->st_size;
+  repo->mtime_sec = (int64_t)st->st_mtim.tv_sec;
+  repo->mtime_nsec = (int64_t)st->st_mtim.tv_nsec;
+  repo->inode = (uint64_t)st->st_ino;
+  repo->first = (uint32_t)builder->count;
+  return 1;
+}
+
+int archium_index_builder_add(ArchiumIndexBuilder *builder, const char *name,
+                              size_t length) {
+  if (!builder || !name || length == 0) {
+    return 0;
+  }
+
+  if (builder->count == builder->capacity) {
+    size_t capacity =
+        builder->capacity ? builder->capacity * 2 : INDEX_INITIAL_NAMES;
+    uint32_t *offsets =
+        realloc(builder->offsets, capacity * sizeof(*builder->offsets));
+    if (!offsets) {
+      return 0;
+    }
+    builder->offsets = offsets;
+    builder->capacity = capacity;
+  }
+
+  if (builder->blob_size + length + 1 > builder->blob_capacity) {
+    size_t capacity =
+        builder->blob_capacity ? builder->blob_capacity : INDEX_INITIAL_BLOB;
+    while (builder->blob_size + length + 1 > capacity) {
+      capacity *= 2;
+    }
+    if (capacity > UINT32_MAX) {
+      return 0;
+    }
+    char *blob = realloc(builder->blob, capacity);
+    if (!blob) {
+      return 0;
+    }
+    builder->blob = blob;
+    builder->blob_capacity = capacity;
+  }
+
+  builder->offsets[builder->count++] = (uint32_t)builder->blob_size;
+  memcpy(builder->blob + builder->blob_size, name, length);
+  builder->blob_size += length;
+  builder->blob[builder->blob_size++] = '\0';
+  return 1;
+}
+
+typedef struct {
+  const char *name;
+  uint32_t entry;
+} SortedName;
+
+static int compare_names(const void *a, const void *b) {
+  return strcmp(((const SortedName *)a)->name, ((const SortedName *)b)->name);
+}
+
+static int write_index_file(FILE *fp, const ArchiumIndexHeader *header,
+                            const ArchiumIndexBuilder *builder,
+                            const SortedName *sorted, size_t unique,
+                            const uint32_t *entry_offsets) {
+  if (fwrite(header, sizeof(*header), 1, fp) != 1) {
+    return 0;
+  }
+
+  if (header->repo_count > 0 &&
+      fwrite(builder->repos, sizeof(*builder->repos), header->repo_count,
+             fp) != header->repo_count) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < unique; i++) {
+    if (fwrite(&entry_offsets[sorted[i].entry], sizeof(uint32_t), 1, fp) !=
+        1) {
+      return 0;
+    }
+  }
+
+  if (header->repo_name_count > 0 &&
+      fwrite(entry_offsets, sizeof(uint32_t), header->repo_name_count, fp) !=
+          header->repo_name_count) {
+    return 0;
+  }
+
+  for (size_t i = 0; i < unique; i++) {
+    size_t length = strlen(sorted[i].name) + 1;
+    if (fwrite(sorted[i].name, 1, length, fp) != length) {
+      return 0;
+    }
+  }
+
+  return 1;
+}
+
+int archium_index_builder_write(ArchiumIndexBuilder *builder,
+                                const char *path) {
+  if (!builder || !path) {
+    return 0;
+  }
+
+  SortedName *sorted = NULL;
+  uint32_t *entry_offsets = NULL;
+  if (builder->count > 0) {
+    sorted = malloc(builder->count * sizeof(*sorted));
+    entry_offsets = malloc(builder->count * sizeof(*entry_offsets));
+    if (!sorted || !entry_offsets) {
+      free(sorted);
+      free(entry_offsets);
+      return 0;
+    }
+    for (size_t i = 0; i < builder->count; i++) {
+      sorted[i].name = builder->blob + builder->offsets[i];
+      sorted[i].entry = (uint32_t)i;
+    }
+    qsort(sorted, builder->count, sizeof(*sorted), compare_names);
+  }
+
+  size_t unique = 0;
+  uint32_t blob_size = 0;
+  for (size_t i = 0; i < builder->count; i++) {
+    if (unique > 0 && strcmp(sorted[unique - 1].name, sorted[i].name) == 0) {
+      entry_offsets[sorted[i].entry] =
+          entry_offsets[sorted[unique - 1].entry];
+      continue;
+    }
+    entry_offsets[sorted[i].entry] = blob_size;
+    blob_size += (uint32_t)strlen(sorted[i].name) + 1;
+    sorted[unique++] = sorted[i];
+  }
+
+  for (size_t i = 0; i < builder->repo_count; i++) {
+    size_t end = i + 1 < builder->repo_count ? builder->repos[i + 1].first
+                                             : builder->count;
+    builder->repos[i].count = (uint32_t)(end - builder->repos[i].first);
+  }
+
+  ArchiumIndexHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, ARCHIUM_INDEX_MAGIC, sizeof(header.magic));
+  header.version = ARCHIUM_INDEX_VERSION;
+  header.count = (uint32_t)unique;
+  header.blob_size = blob_size;
+  header.repo_count = (uint32_t)builder->repo_count;
+  header.repo_name_count =
+      builder->repo_count > 0 ? (uint32_t)builder->count : 0;
+  header.source_mtime_sec = builder->source_mtime_sec;
+  header.source_mtime_nsec = builder->source_mtime_nsec;
+
+  char temp_path[COMMAND_BUFFER_SIZE];
+  FILE *fp = NULL;
+  if (snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) <
+      (int)sizeof(temp_path)) {
+    fp = fopen(temp_path, "wb");
+  }
+  if (!fp) {
+    free(sorted);
+    free(entry_offsets);
+    return 0;
+  }
+
+  int ok = write_index_file(fp, &header, builder, sorted, unique,
+                            entry_offsets);
+  free(sorted);
+  free(entry_offsets);
+
+  if (fclose(fp) != 0) {
+    ok = 0;
+  }
+
+  if (!ok || rename(temp_path, path) != 0) {
+    unlink(temp_path);
+    return 0;
+  }
+
+  return 1;
+}
+
+void archium_index_builder_free(ArchiumIndexBuilder *builder) {
+  if (!builder) {
+    return;
+  }
+
+  free(builder->blob);
+  free(builder->offsets);
+  free(builder->repos);
+  memset(builder, 0, sizeof(*builder));
+}
@@ -2,35 +2,225 @@
 
 int check_archium_file(void) { return archium_config_check_paru_preference(); }
 
+#define PM_CACHE_FILE "package_managers"
+
+typedef struct {
+  const char *name;
+  int resolved;
+  int found;
+  char path[COMMAND_BUFFER_SIZE];
+  struct timespec mtime;
+  char version[SMALL_BUFFER_SIZE];
+} PackageManagerEntry;
+
+static PackageManagerEntry pm_entries[] = {{.name = "yay"},
+                                           {.name = "paru"},
+                                           {.name = "pacman"}};
+static int pm_cache_loaded = 0;
+static int pm_cache_dirty = 0;
+
+static int find_in_path(const char *command, char *out, size_t out_size,
+                        struct stat *st) {
+  if (!command || command[0] == '\0') {
+    return 0;
+  }
+  if (strchr(command, '/')) {
+    return snprintf(out, out_size, "%s", command) < (int)out_size &&
+           stat(command, st) == 0 && access(command, X_OK) == 0;
+  }
+
+  const char *path = getenv("PATH");
+  if (!path || path[0] == '\0') {
+    path = "/usr/local/bin:/usr/bin:/bin";
+  }
+
+  while (*path) {
+    size_t dir_length = strcspn(path, ":");
+    int written =
+        dir_length == 0
+            ? snprintf(out, out_size, "./%s", command)
+            : snprintf(out, out_size, "%.*s/%s", (int)dir_length, path,
+                       command);
+    if (written > 0 && written < (int)out_size && stat(out, st) == 0 &&
+        S_ISREG(st->st_mode) && access(out, X_OK) == 0) {
+      return 1;
+    }
+
+    path += dir_length;
+    if (*path == ':') {
+      path++;
+    }
+  }
+  return 0;
+}
+
 int check_command(const char *command) {
-  char cmd[COMMAND_BUFFER_SIZE];
-  if (snprintf(cmd, sizeof(cmd), "command -v %s > /dev/null 2>&1", command) >=
-      (int)sizeof(cmd)) {
-    fprintf(stderr, "\033[1;31mError: Command buffer overflow.\033[0m\n");
+  char resolved[COMMAND_BUFFER_SIZE];
+  struct stat st;
+  return find_in_path(command, resolved, sizeof(resolved), &st);
+}
+
+static PackageManagerEntry *find_pm_entry(const char *name) {
+  for (size_t i = 0; i < sizeof(pm_entries) / sizeof(pm_entries[0]); i++) {
+    if (strcmp(pm_entries[i].name, name) == 0) {
+      return &pm_entries[i];
+    }
+  }
+  return NULL;
+}
+
+static int build_pm_cache_path(char *out, size_t out_size) {
+  const char *cache_dir = archium_config_get_cache_dir();
+  if (!cache_dir) {
     return 0;
   }
-  return (system(cmd) == 0);
+  return snprintf(out, out_size, "%s/%s", cache_dir, PM_CACHE_FILE) <
+         (int)out_size;
 }
 
-int check_package_manager(void) {
-  const char *preferred = archium_config_get_preferred_package_manager();
+static void load_pm_cache(void) {
+  pm_cache_loaded = 1;
+
+  char cache_path[COMMAND_BUFFER_SIZE];
+  if (!build_pm_cache_path(cache_path, sizeof(cache_path))) {
+    return;
+  }
+
+  FILE *fp = fopen(cache_path, "r");
+  if (!fp) {
+    return;
+  }
+
+  const char *current_path = getenv("PATH");
+  char line[COMMAND_BUFFER_SIZE * 4];
+  int path_matches = 0;
+  if (fgets(line, sizeof(line), fp)) {
+    line[strcspn(line, "\n")] = '\0';
+    path_matches = strncmp(line, "PATH\t", 5) == 0 && current_path &&
+                   strcmp(line + 5, current_path) == 0;
+  }
+
+  while (path_matches && fgets(line, sizeof(line), fp)) {
+    line[strcspn(line, "\n")] = '\0';
+
+    char *fields[5];
+    char *cursor = line;
+    int count = 0;
+    while (count < 5) {
+      fields[count++] = cursor;
+      char *tab = strchr(cursor, '\t');
+      if (!tab) {
+        break;
+      }
+      *tab = '\0';
+      cursor = tab + 1;
+    }
+    if (count != 5) {
+      continue;
+    }
+
+    PackageManagerEntry *entry = find_pm_entry(fields[0]);
+    if (!entry) {
+      continue;
+    }
+    snprintf(entry->path, sizeof(entry->path), "%s", fields[1]);
+    entry->mtime.tv_sec = (time_t)strtoll(fields[2], NULL, 10);
+    entry->mtime.tv_nsec = strtol(fields[3], NULL, 10);
+    snprintf(entry->version, sizeof(entry->version), "%s", fields[4]);
+  }
+
+  fclose(fp);
+}
+
+static void save_pm_cache(void) {
+  pm_cache_dirty = 0;
+
+  char cache_path[COMMAND_BUFFER_SIZE];
+  char temp_path[COMMAND_BUFFER_SIZE];
+  const char *current_path = getenv("PATH");
+  if (!current_path || !build_pm_cache_path(cache_path, sizeof(cache_path)) ||
+      snprintf(temp_path, sizeof(temp_path), "%s.tmp", cache_path) >=
+          (int)sizeof(temp_path)) {
+    return;
+  }
+
+  FILE *fp = fopen(temp_path, "w");
+  if (!fp) {
+    return;
+  }
+
+  fprintf(fp, "PATH\t%s\n", current_path);
+  for (size_t i = 0; i < sizeof(pm_entries) / sizeof(pm_entries[0]); i++) {
+    const PackageManagerEntry *entry = &pm_entries[i];
+    if (!entry->found) {
+      continue;
+    }
+    fprintf(fp, "%s\t%s\t%lld\t%ld\t%s\n", entry->name, entry->path,
+            (long long)entry->mtime.tv_sec, (long)entry->mtime.tv_nsec,
+            entry->version);
+  }
 
-  if (preferred && strcmp(preferred, "paru") == 0 && check_command("paru")) {
-    return 2;  // paru
+  if (fclose(fp) != 0 || rename(temp_path, cache_path) != 0) {
+    unlink(temp_path);
   }
-  if (preferred && strcmp(preferred, "yay") == 0 && check_command("yay")) {
-    return 1;  // yay
+}
+
+static int resolve_package_manager(PackageManagerEntry *entry) {
+  if (entry->resolved) {
+    return entry->found;
+  }
+  if (!pm_cache_loaded) {
+    load_pm_cache();
+  }
+  entry->resolved = 1;
+
+  struct stat st;
+  if (entry->path[0] != '\0' && stat(entry->path, &st) == 0 &&
+      S_ISREG(st.st_mode) && access(entry->path, X_OK) == 0) {
+    if (st.st_mtim.tv_sec != entry->mtime.tv_sec ||
+        st.st_mtim.tv_nsec != entry->mtime.tv_nsec) {
+      entry->mtime = st.st_mtim;
+      entry->version[0] = '\0';
+      pm_cache_dirty = 1;
+    }
+    entry->found = 1;
+    return 1;
   }
-  if (check_command("yay")) {
-    return 1;  // yay
+
+  entry->version[0] = '\0';
+  entry->found = find_in_path(entry->name, entry->path, sizeof(entry->path),
+                              &st);
+  if (entry->found) {
+    entry->mtime = st.st_mtim;
+  } else {
+    entry->path[0] = '\0';
   }
-  if (check_command("paru")) {
-    return 2;  // paru
+  pm_cache_dirty = 1;
+  return entry->found;
+}
+
+int check_package_manager(void) {
+  const char *preferred = archium_config_get_preferred_package_manager();
+  int result = 0;
+
+  if (preferred && strcmp(preferred, "paru") == 0 &&
+      resolve_package_manager(find_pm_entry("paru"))) {
+    result = 2;  // paru
+  } else if (preferred && strcmp(preferred, "yay") == 0 &&
+             resolve_package_manager(find_pm_entry("yay"))) {
+    result = 1;  // yay
+  } else if (resolve_package_manager(find_pm_entry("yay"))) {
+    result = 1;  // yay
+  } else if (resolve_package_manager(find_pm_entry("paru"))) {
+    result = 2;  // paru
+  } else if (resolve_package_manager(find_pm_entry("pacman"))) {
+    result = 3;  // pacman
   }
-  if (check_command("pacman")) {
-    return 3;  // pacman
+
+  if (pm_cache_dirty) {
+    save_pm_cache();
   }
-  return 0;  // none
+  return result;
 }
 
 char *get_package_manager_version(const char *package_manager) {
@@ -45,26 +235,46 @@ char *get_package_manager_version(const char *package_manager) {
     return strdup("unknown");
   }
 
-  char command[COMMAND_BUFFER_SIZE];
-  snprintf(command, sizeof(command), "%s --version | head -n 1",
-           package_manager);
+  PackageManagerEntry *entry = find_pm_entry(package_manager);
+  if (entry && resolve_package_manager(entry) && entry->version[0] != '\0') {
+    return strdup(entry->version);
+  }
 
-  FILE *fp = popen(command, "r");
+  const char *const argv[] = {package_manager, "--version", NULL};
+  ArchiumProcess process;
+  FILE *fp = NULL;
+  if (spawn_process(&process, argv, PROCESS_CAPTURE_STDOUT)) {
+    fp = process_output(&process);
+  }
   if (!fp) {
+    wait_process(&process);
     fprintf(stderr,
             "\033[1;31mError: Failed to retrieve version for %s\033[0m\n",
             package_manager);
     return strdup("unknown");
   }
 
-  char version[COMMAND_BUFFER_SIZE];
-  if (!fgets(version, sizeof(version), fp)) {
-    pclose(fp);
+  char version[SMALL_BUFFER_SIZE];
+  char discard[COMMAND_BUFFER_SIZE];
+  int have_version = fgets(version, sizeof(version), fp) != NULL;
+  while (fgets(discard, sizeof(discard), fp)) {
+  }
+  int exit_code = wait_process(&process);
+  if (!have_version) {
     return strdup("unknown");
   }
-  pclose(fp);
 
   version[strcspn(version, "\n")] = '\0';
+  for (char *c = version; *c; c++) {
+    if (*c == '\t') {
+      *c = ' ';
+    }
+  }
+
+  if (entry && entry->found && exit_code == 0) {
+    snprintf(entry->version, sizeof(entry->version), "%s", version);
+    save_pm_cache();
+  }
 
   return strdup(version);
 }
@@ -72,15 +282,18 @@ char *get_package_manager_version(const char *package_manager) {
 int check_git(void) { return check_command("git"); }
 
 void install_git(void) {
-  char output_buffer[2048];
-  int result = execute_command_with_output_capture(
-      "sudo pacman -S --noconfirm git", "Installing git", output_buffer,
-      sizeof(output_buffer));
+  ArchiumOutput output;
+  const char *const argv[] = {"sudo", "pacman", "-S", "--noconfirm", "git",
+                              NULL};
+  output_init(&output);
+  int result =
+      execute_argv_with_output_capture(argv, "Installing git", &output);
   if (result != 0) {
     fprintf(stderr, "\033[1;31mError: Failed to install git.\033[0m\n");
     exit(EXIT_FAILURE);
   }
-  parse_and_show_install_result(output_buffer, result, "git");
+  parse_and_show_install_result(&output, result, "git");
+  output_free(&output);
 }
 
 void install_yay(void) {
@@ -104,31 +317,56 @@ void install_yay(void) {
     exit(EXIT_FAILURE);
   }
 
-  char command[COMMAND_BUFFER_SIZE];
-  char output_buffer[4096];
-  int ret =
-      snprintf(command, sizeof(command),
-               "mkdir -p %s/setup && "
-               "cd %s/setup && "
-               "git clone https://aur.archlinux.org/yay-bin.git && "
-               "cd yay-bin && "
-               "makepkg -scCi && "
-               "cd && "
-               "rm -rf %s/setup",
-               sanitized_cache_dir, sanitized_cache_dir, sanitized_cache_dir);
-
-  if (ret >= (int)sizeof(command)) {
+  char setup_dir[COMMAND_BUFFER_SIZE];
+  char build_dir[COMMAND_BUFFER_SIZE];
+  if (snprintf(setup_dir, sizeof(setup_dir), "%s/setup", sanitized_cache_dir) >=
+          (int)sizeof(setup_dir) ||
+      snprintf(build_dir, sizeof(build_dir), "%s/yay-bin", setup_dir) >=
+          (int)sizeof(build_dir)) {
     fprintf(stderr, "\033[1;31mError: Command string too long.\033[0m\n");
     exit(EXIT_FAILURE);
   }
 
-  int result = execute_command_with_output_capture(
-      command, "Installing yay", output_buffer, sizeof(output_buffer));
+  char original_dir[COMMAND_BUFFER_SIZE];
+  if (!getcwd(original_dir, sizeof(original_dir))) {
+    original_dir[0] = '\0';
+  }
+
+  ArchiumOutput output;
+  const char *const mkdir_argv[] = {"mkdir", "-p", setup_dir, NULL};
+  const char *const clone_argv[] = {
+      "git", "clone", "https://aur.archlinux.org/yay-bin.git", build_dir, NULL};
+  const char *const makepkg_argv[] = {"makepkg", "-scCi", NULL};
+  const char *const cleanup_argv[] = {"rm", "-rf", setup_dir, NULL};
+
+  output_init(&output);
+  int result = run_process(mkdir_argv, 0);
+  if (result == 0) {
+    result =
+        execute_argv_with_output_capture(clone_argv, "Installing yay", NULL);
+  }
+  if (result == 0) {
+    result = chdir(build_dir) == 0
+                 ? execute_argv_with_output_capture(makepkg_argv,
+                                                    "Installing yay", &output)
+                 : -1;
+  }
+  if (original_dir[0] == '\0' || chdir(original_dir) != 0) {
+    const char *home = getenv("HOME");
+    if (home && chdir(home) != 0) {
+      log_debug("Failed to return to the original directory");
+    }
+  }
+  if (result == 0) {
+    run_process(cleanup_argv, 0);
+  }
+
   if (result != 0) {
     fprintf(stderr, "\033[1;31mError: Failed to install yay.\033[0m\n");
     exit(EXIT_FAILURE);
   }
-  parse_and_show_install_result(output_buffer, result, "yay");
+  parse_and_show_install_result(&output, result, "yay");
+  output_free(&output);
   printf(
       "\033[1;32mInstallation of yay is complete. Please restart your shell "
       "and relaunch Archium.\033[0m\n");
@@ -11,6 +11,10 @@
 #define MAX_PLUGINS 32
 #define MAX_PLUGIN_NAME_LENGTH 64
 #define MAX_PLUGIN_COMMAND_LENGTH 32
+#define PLUGIN_COMMAND_SLOTS ARCHIUM_COMMAND_HASH_SIZE
+
+_Static_assert(MAX_PLUGINS * 2 <= PLUGIN_COMMAND_SLOTS,
+               "plugin command table must stay at most half full");
 
 typedef struct {
   char name[MAX_PLUGIN_NAME_LENGTH];
@@ -28,6 +32,7 @@ typedef struct {
 
 static ArchiumPlugin loaded_plugins[MAX_PLUGINS];
 static int plugin_count = 0;
+static int plugin_command_slots[PLUGIN_COMMAND_SLOTS];
 static ArchiumPluginContext base_context = {0};
 
 static int archium_plugin_run_command(const char *command, char *output_buffer,
@@ -64,6 +69,18 @@ static void archium_plugin_fill_context(ArchiumPluginContext *ctx,
   ctx->package_manager = package_manager;
 }
 
+static size_t plugin_command_slot(const char *command) {
+  return archium_command_hash(command, strlen(command), 0);
+}
+
+static void plugin_command_insert(int index) {
+  size_t slot = plugin_command_slot(loaded_plugins[index].command);
+  while (plugin_command_slots[slot] != 0) {
+    slot = (slot + 1) & (PLUGIN_COMMAND_SLOTS - 1);
+  }
+  plugin_command_slots[slot] = index + 1;
+}
+
 static int is_valid_plugin_file(const char *filename) {
   size_t len = strlen(filename);
   if (len < 3) return 0;
@@ -147,6 +164,12 @@ int archium_plugin_init(void) {
       continue;
     }
 
+    if (builtin_command_index(command) >= 0) {
+      log_debug("Plugin command shadows a built-in command, skipping");
+      dlclose(handle);
+      continue;
+    }
+
     snprintf(loaded_plugins[plugin_count].name,
              sizeof(loaded_plugins[plugin_count].name), "%s", name);
     snprintf(loaded_plugins[plugin_count].command,
@@ -163,6 +186,7 @@ int archium_plugin_init(void) {
     loaded_plugins[plugin_count].on_exit = on_exit;
     loaded_plugins[plugin_count].cleanup = cleanup;
 
+    plugin_command_insert(plugin_count);
     plugin_count++;
     log_info("Loaded plugin");
 
@@ -192,16 +216,20 @@ void archium_plugin_cleanup(void) {
     }
   }
   plugin_count = 0;
+  memset(plugin_command_slots, 0, sizeof(plugin_command_slots));
 }
 
 int archium_plugin_find_by_command(const char *command) {
   if (!command) {
     return -1;
   }
-  for (int i = 0; i < plugin_count; i++) {
-    if (strcmp(loaded_plugins[i].command, command) == 0) {
-      return i;
+  size_t slot = plugin_command_slot(command);
+  while (plugin_command_slots[slot] != 0) {
+    int index = plugin_command_slots[slot] - 1;
+    if (strcmp(loaded_plugins[index].command, command) == 0) {
+      return index;
     }
+    slot = (slot + 1) & (PLUGIN_COMMAND_SLOTS - 1);
   }
   return -1;
 }
@@ -263,6 +291,13 @@ void archium_plugin_notify_exit(const char *command, const char *args,
   }
 }
 
+const char *archium_plugin_command_at(int index) {
+  if (index < 0 || index >= plugin_count) {
+    return NULL;
+  }
+  return loaded_plugins[index].command;
+}
+
 int archium_plugin_is_plugin_command(const char *command) {
   if (!command) {
     return 0;
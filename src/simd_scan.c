@@ -0,0 +1,48 @@
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "include/archium.h"
+
+const char *archium_scan_byte2(const char *data, size_t length,
+                               unsigned char first, unsigned char second) {
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  const __m256i wide_first = _mm256_set1_epi8((char)first);
+  const __m256i wide_second = _mm256_set1_epi8((char)second);
+  for (; i + 32 <= length; i += 32) {
+    __m256i chunk = _mm256_loadu_si256((const __m256i *)(data + i));
+    __m256i hits = _mm256_or_si256(_mm256_cmpeq_epi8(chunk, wide_first),
+                                   _mm256_cmpeq_epi8(chunk, wide_second));
+    unsigned int mask = (unsigned int)_mm256_movemask_epi8(hits);
+    if (mask) {
+      return data + i + (size_t)__builtin_ctz(mask);
+    }
+  }
+#endif
+
+#if defined(__SSE2__)
+  const __m128i narrow_first = _mm_set1_epi8((char)first);
+  const __m128i narrow_second = _mm_set1_epi8((char)second);
+  for (; i + 16 <= length; i += 16) {
+    __m128i chunk = _mm_loadu_si128((const __m128i *)(data + i));
+    __m128i hits = _mm_or_si128(_mm_cmpeq_epi8(chunk, narrow_first),
+                                _mm_cmpeq_epi8(chunk, narrow_second));
+    unsigned int mask = (unsigned int)_mm_movemask_epi8(hits);
+    if (mask) {
+      return data + i + (size_t)__builtin_ctz(mask);
+    }
+  }
+#endif
+
+  for (; i < length; i++) {
+    unsigned char c = (unsigned char)data[i];
+    if (c == first || c == second) {
+      return data + i;
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,371 @@
+#include <dirent.h>
+#include <sys/wait.h>
+#include <zlib.h>
+
+#include "include/archium.h"
+
+#define TAR_BLOCK_SIZE 512
+#define DESC_MAX_SIZE (256 * 1024)
+#define TAR_NAME_MAX 1024
+
+typedef struct {
+  gzFile gz;
+  FILE *pipe;
+} DbStream;
+
+typedef struct {
+  ArchiumNameFn fn;
+  void *user_data;
+} NameVisitor;
+
+static const char *decompressor_for_magic(const unsigned char *magic,
+                                          size_t length) {
+  if (length >= 4 && magic[0] == 0x28 && magic[1] == 0xb5 &&
+      magic[2] == 0x2f && magic[3] == 0xfd) {
+    return "zstd -dcq";
+  }
+  if (length >= 6 && memcmp(magic, "\xfd" "7zXZ\0", 6) == 0) {
+    return "xz -dcq";
+  }
+  if (length >= 3 && memcmp(magic, "BZh", 3) == 0) {
+    return "bzip2 -dcq";
+  }
+  return NULL;
+}
+
+static int db_stream_open(DbStream *stream, const char *path) {
+  memset(stream, 0, sizeof(*stream));
+
+  FILE *fp = fopen(path, "rb");
+  if (!fp) {
+    return 0;
+  }
+  unsigned char magic[6];
+  size_t magic_length = fread(magic, 1, sizeof(magic), fp);
+  fclose(fp);
+
+  const char *decompressor = decompressor_for_magic(magic, magic_length);
+  if (!decompressor) {
+    stream->gz = gzopen(path, "rb");
+    if (stream->gz) {
+      gzbuffer(stream->gz, 128 * 1024);
+    }
+    return stream->gz != NULL;
+  }
+
+  if (strchr(path, '\'')) {
+    return 0;
+  }
+
+  char command[COMMAND_BUFFER_SIZE];
+  if (snprintf(command, sizeof(command), "%s -- '%s' 2>/dev/null",
+               decompressor, path) >= (int)sizeof(command)) {
+    return 0;
+  }
+
+  stream->pipe = popen(command, "r");
+  return stream->pipe != NULL;
+}
+
+static size_t db_stream_read(DbStream *stream, void *buffer, size_t length) {
+  size_t total = 0;
+  while (total < length) {
+    size_t chunk = 0;
+    if (stream->gz) {
+      int n = gzread(stream->gz, (char *)buffer + total,
+                     (unsigned int)(length - total));
+      if (n <= 0) {
+        break;
+      }
+      chunk = (size_t)n;
+    } else {
+      chunk = fread((char *)buffer + total, 1, length - total, stream->pipe);
+      if (chunk == 0) {
+        break;
+      }
+    }
+    total += chunk;
+  }
+  return total;
+}
+
+static int db_stream_skip(DbStream *stream, size_t length) {
+  char scratch[8192];
+  while (length > 0) {
+    size_t chunk = length < sizeof(scratch) ? length : sizeof(scratch);
+    if (db_stream_read(stream, scratch, chunk) != chunk) {
+      return 0;
+    }
+    length -= chunk;
+  }
+  return 1;
+}
+
+static int db_stream_close(DbStream *stream, int complete) {
+  int ok = complete;
+  if (stream->gz && gzclose(stream->gz) != Z_OK) {
+    ok = 0;
+  }
+  if (stream->pipe) {
+    if (complete) {
+      char scratch[8192];
+      while (fread(scratch, 1, sizeof(scratch), stream->pipe) > 0) {
+      }
+    }
+    int status = pclose(stream->pipe);
+    if (status == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      ok = 0;
+    }
+  }
+  memset(stream, 0, sizeof(*stream));
+  return ok;
+}
+
+static size_t parse_octal(const char *field, size_t length) {
+  size_t value = 0;
+  size_t i = 0;
+  while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+    i++;
+  }
+  for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+    value = (value << 3) + (size_t)(field[i] - '0');
+  }
+  return value;
+}
+
+static int is_zero_block(const char *block) {
+  for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+    if (block[i] != '\0') {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+static void parse_pax_path(const char *data, size_t length, char *name,
+                           size_t name_size) {
+  size_t pos = 0;
+  while (pos < length) {
+    size_t record_length = 0;
+    size_t cursor = pos;
+    while (cursor < length && isdigit((unsigned char)data[cursor])) {
+      record_length = record_length * 10 + (size_t)(data[cursor] - '0');
+      cursor++;
+    }
+    if (record_length == 0 || pos + record_length > length ||
+        cursor >= length || data[cursor] != ' ') {
+      return;
+    }
+
+    const char *key = data + cursor + 1;
+    size_t key_space = pos + record_length - (cursor + 1);
+    if (key_space > 5 && strncmp(key, "path=", 5) == 0) {
+      size_t value_length = key_space - 5;
+      if (value_length > 0 && key[5 + value_length - 1] == '\n') {
+        value_length--;
+      }
+      if (value_length < name_size) {
+        memcpy(name, key + 5, value_length);
+        name[value_length] = '\0';
+      }
+      return;
+    }
+    pos += record_length;
+  }
+}
+
+static int ends_with_desc(const char *name) {
+  size_t length = strlen(name);
+  return (length == 4 && strcmp(name, "desc") == 0) ||
+         (length > 4 && strcmp(name + length - 5, "/desc") == 0);
+}
+
+const char *archium_desc_field(const char *desc, size_t length,
+                               const char *field, size_t *value_length) {
+  if (!desc || !field) {
+    return NULL;
+  }
+
+  size_t field_length = strlen(field);
+  size_t pos = 0;
+  while (pos < length) {
+    const char *line = desc + pos;
+    const char *newline = memchr(line, '\n', length - pos);
+    size_t line_length = newline ? (size_t)(newline - line) : length - pos;
+
+    if (line_length == field_length + 2 && line[0] == '%' &&
+        line[field_length + 1] == '%' &&
+        memcmp(line + 1, field, field_length) == 0) {
+      if (!newline) {
+        return NULL;
+      }
+      const char *value = newline + 1;
+      const char *end = desc + length;
+      const char *cursor = value;
+      while (cursor < end) {
+        const char *next = memchr(cursor, '\n', (size_t)(end - cursor));
+        if (!next || next == cursor) {
+          break;
+        }
+        cursor = next + 1;
+      }
+      size_t block_length = (size_t)(cursor - value);
+      while (block_length > 0 && value[block_length - 1] == '\n') {
+        block_length--;
+      }
+      if (value_length) {
+        *value_length = block_length;
+      }
+      return value;
+    }
+
+    pos += line_length + 1;
+  }
+
+  return NULL;
+}
+
+int archium_syncdb_foreach_desc(const char *db_path, ArchiumDescFn fn,
+                                void *user_data) {
+  if (!db_path || !fn) {
+    return 0;
+  }
+
+  DbStream stream;
+  if (!db_stream_open(&stream, db_path)) {
+    return 0;
+  }
+
+  char block[TAR_BLOCK_SIZE];
+  char name[TAR_NAME_MAX];
+  char long_name[TAR_NAME_MAX] = "";
+  char *desc = NULL;
+  int ok = 1;
+  int complete = 0;
+
+  while (ok) {
+    size_t length = db_stream_read(&stream, block, sizeof(block));
+    if (length == 0 || (length == sizeof(block) && is_zero_block(block))) {
+      complete = 1;
+      break;
+    }
+    if (length != sizeof(block)) {
+      break;
+    }
+
+    size_t size = parse_octal(block + 124, 12);
+    size_t padded = (size + TAR_BLOCK_SIZE - 1) & ~(size_t)(TAR_BLOCK_SIZE - 1);
+    char type = block[156];
+
+    if (long_name[0] != '\0') {
+      snprintf(name, sizeof(name), "%s", long_name);
+      long_name[0] = '\0';
+    } else if (memcmp(block + 257, "ustar", 5) == 0 && block[345] != '\0') {
+      snprintf(name, sizeof(name), "%.155s/%.100s", block + 345, block);
+    } else {
+      snprintf(name, sizeof(name), "%.100s", block);
+    }
+
+    if (type == 'L' || type == 'x') {
+      if (size >= DESC_MAX_SIZE) {
+        ok = db_stream_skip(&stream, padded);
+        continue;
+      }
+      char *data = malloc(padded ? padded : 1);
+      if (!data || db_stream_read(&stream, data, padded) != padded) {
+        free(data);
+        break;
+      }
+      if (type == 'L') {
+        size_t length = strnlen(data, size);
+        if (length < sizeof(long_name)) {
+          memcpy(long_name, data, length);
+          long_name[length] = '\0';
+        }
+      } else {
+        parse_pax_path(data, size, long_name, sizeof(long_name));
+      }
+      free(data);
+      continue;
+    }
+
+    if ((type == '0' || type == '\0') && ends_with_desc(name) &&
+        size < DESC_MAX_SIZE) {
+      if (!desc) {
+        desc = malloc(DESC_MAX_SIZE);
+        if (!desc) {
+          break;
+        }
+      }
+      if (db_stream_read(&stream, desc, padded) != padded) {
+        break;
+      }
+      if (!fn(desc, size, user_data)) {
+        break;
+      }
+      continue;
+    }
+
+    ok = db_stream_skip(&stream, padded);
+  }
+
+  free(desc);
+  return db_stream_close(&stream, complete);
+}
+
+static int visit_desc_name(const char *desc, size_t length, void *user_data) {
+  NameVisitor *visitor = user_data;
+  size_t value_length = 0;
+  const char *value = archium_desc_field(desc, length, "NAME", &value_length);
+  if (!value || value_length == 0) {
+    return 1;
+  }
+
+  const char *newline = memchr(value, '\n', value_length);
+  if (newline) {
+    value_length = (size_t)(newline - value);
+  }
+  return visitor->fn(value, value_length, visitor->user_data);
+}
+
+int archium_syncdb_read_names(const char *db_path, ArchiumNameFn fn,
+                              void *user_data) {
+  NameVisitor visitor = {fn, user_data};
+  return archium_syncdb_foreach_desc(db_path, visit_desc_name, &visitor);
+}
+
+int archium_syncdb_is_db_file(const char *filename) {
+  size_t length = strlen(filename);
+  return length > 3 && filename[0] != '.' &&
+         strcmp(filename + length - 3, ".db") == 0;
+}
+
+int archium_syncdb_read_all_names(const char *sync_dir, ArchiumNameFn fn,
+                                  void *user_data) {
+  DIR *dir = opendir(sync_dir ? sync_dir : ARCHIUM_SYNC_DB_DIR);
+  if (!dir) {
+    return 0;
+  }
+
+  int databases = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL) {
+    if (!archium_syncdb_is_db_file(entry->d_name)) {
+      continue;
+    }
+
+    char db_path[COMMAND_BUFFER_SIZE];
+    if (snprintf(db_path, sizeof(db_path), "%s/%s",
+                 sync_dir ? sync_dir : ARCHIUM_SYNC_DB_DIR,
+                 entry->d_name) >= (int)sizeof(db_path)) {
+      continue;
+    }
+
+    if (archium_syncdb_read_names(db_path, fn, user_data)) {
+      databases++;
+    }
+  }
+
+  closedir(dir);
+  return databases;
+}
@@ -0,0 +1,239 @@
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+
+#include "include/archium.h"
+
+#define POOL_RANGE(begin, end) (((uint64_t)(begin) << 32) | (uint32_t)(end))
+#define POOL_RANGE_BEGIN(range) ((uint32_t)((range) >> 32))
+#define POOL_RANGE_END(range) ((uint32_t)(range))
+
+/*
+ * Each worker owns a [begin, end) range of task indexes packed into one
+ * atomic word. The owner takes tasks from the front; an idle worker steals
+ * the back half of someone else's range. Both sides move with a CAS on the
+ * same word, so no task is handed out twice.
+ */
+typedef struct {
+  _Alignas(64) _Atomic uint64_t range;
+} PoolWorker;
+
+struct ArchiumThreadPool {
+  size_t thread_count;
+  PoolWorker *workers;
+  pthread_t *threads;
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t done;
+  unsigned long generation;
+  size_t active;
+  int stopping;
+  ArchiumPoolTaskFn fn;
+  void *user_data;
+};
+
+typedef struct {
+  ArchiumThreadPool *pool;
+  size_t id;
+} PoolThreadArg;
+
+size_t archium_pool_default_threads(void) {
+  long online = sysconf(_SC_NPROCESSORS_ONLN);
+  if (online < 1) {
+    return 1;
+  }
+  return online > ARCHIUM_POOL_AUTO_THREADS ? ARCHIUM_POOL_AUTO_THREADS
+                                            : (size_t)online;
+}
+
+static int64_t take_own(PoolWorker *worker) {
+  uint64_t range = atomic_load_explicit(&worker->range, memory_order_acquire);
+  for (;;) {
+    uint32_t begin = POOL_RANGE_BEGIN(range);
+    uint32_t end = POOL_RANGE_END(range);
+    if (begin >= end) {
+      return -1;
+    }
+    if (atomic_compare_exchange_weak_explicit(
+            &worker->range, &range, POOL_RANGE(begin + 1, end),
+            memory_order_acq_rel, memory_order_acquire)) {
+      return begin;
+    }
+  }
+}
+
+static int64_t steal_from(PoolWorker *victim, PoolWorker *thief) {
+  uint64_t range = atomic_load_explicit(&victim->range, memory_order_acquire);
+  for (;;) {
+    uint32_t begin = POOL_RANGE_BEGIN(range);
+    uint32_t end = POOL_RANGE_END(range);
+    if (begin >= end) {
+      return -1;
+    }
+    uint32_t split = end - (end - begin + 1) / 2;
+    if (atomic_compare_exchange_weak_explicit(
+            &victim->range, &range, POOL_RANGE(begin, split),
+            memory_order_acq_rel, memory_order_acquire)) {
+      atomic_store_explicit(&thief->range, POOL_RANGE(split + 1, end),
+                            memory_order_release);
+      return split;
+    }
+  }
+}
+
+static void pool_work(ArchiumThreadPool *pool, size_t id) {
+  PoolWorker *self = &pool->workers[id];
+  for (;;) {
+    int64_t index = take_own(self);
+    for (size_t i = 1; index < 0 && i < pool->thread_count; i++) {
+      index = steal_from(&pool->workers[(id + i) % pool->thread_count], self);
+    }
+    if (index < 0) {
+      return;
+    }
+    pool->fn(id, (size_t)index, pool->user_data);
+  }
+}
+
+static void *pool_thread(void *arg) {
+  PoolThreadArg *thread_arg = arg;
+  ArchiumThreadPool *pool = thread_arg->pool;
+  size_t id = thread_arg->id;
+  free(thread_arg);
+
+  sigset_t signals;
+  sigfillset(&signals);
+  pthread_sigmask(SIG_BLOCK, &signals, NULL);
+
+  unsigned long seen = 0;
+  pthread_mutex_lock(&pool->mutex);
+  for (;;) {
+    while (pool->generation == seen && !pool->stopping) {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+    if (pool->stopping) {
+      break;
+    }
+    seen = pool->generation;
+    pthread_mutex_unlock(&pool->mutex);
+
+    pool_work(pool, id);
+
+    pthread_mutex_lock(&pool->mutex);
+    if (--pool->active == 0) {
+      pthread_cond_signal(&pool->done);
+    }
+  }
+  pthread_mutex_unlock(&pool->mutex);
+  return NULL;
+}
+
+ArchiumThreadPool *archium_pool_create(size_t threads) {
+  if (threads == 0) {
+    threads = archium_pool_default_threads();
+  }
+  if (threads > ARCHIUM_POOL_MAX_THREADS) {
+    threads = ARCHIUM_POOL_MAX_THREADS;
+  }
+
+  ArchiumThreadPool *pool = calloc(1, sizeof(*pool));
+  if (!pool) {
+    return NULL;
+  }
+  pool->workers = aligned_alloc(_Alignof(PoolWorker),
+                                threads * sizeof(*pool->workers));
+  pool->threads = calloc(threads, sizeof(*pool->threads));
+  if (!pool->workers || !pool->threads) {
+    free(pool->workers);
+    free(pool->threads);
+    free(pool);
+    return NULL;
+  }
+  for (size_t i = 0; i < threads; i++) {
+    atomic_init(&pool->workers[i].range, 0);
+  }
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  pool->thread_count = 1;
+  for (size_t i = 1; i < threads; i++) {
+    PoolThreadArg *arg = malloc(sizeof(*arg));
+    if (!arg) {
+      break;
+    }
+    arg->pool = pool;
+    arg->id = i;
+    if (pthread_create(&pool->threads[i], NULL, pool_thread, arg) != 0) {
+      free(arg);
+      break;
+    }
+    pool->thread_count++;
+  }
+  return pool;
+}
+
+size_t archium_pool_thread_count(const ArchiumThreadPool *pool) {
+  return pool ? pool->thread_count : 1;
+}
+
+void archium_pool_run(ArchiumThreadPool *pool, size_t count,
+                      ArchiumPoolTaskFn fn, void *user_data) {
+  if (count == 0) {
+    return;
+  }
+  if (!pool || pool->thread_count == 1 || count > UINT32_MAX) {
+    for (size_t i = 0; i < count; i++) {
+      fn(0, i, user_data);
+    }
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->fn = fn;
+  pool->user_data = user_data;
+  size_t share = count / pool->thread_count;
+  size_t extra = count % pool->thread_count;
+  size_t begin = 0;
+  for (size_t i = 0; i < pool->thread_count; i++) {
+    size_t end = begin + share + (i < extra ? 1 : 0);
+    atomic_store_explicit(&pool->workers[i].range, POOL_RANGE(begin, end),
+                          memory_order_relaxed);
+    begin = end;
+  }
+  pool->active = pool->thread_count - 1;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  pool_work(pool, 0);
+
+  pthread_mutex_lock(&pool->mutex);
+  while (pool->active > 0) {
+    pthread_cond_wait(&pool->done, &pool->mutex);
+  }
+  pthread_mutex_unlock(&pool->mutex);
+}
+
+void archium_pool_destroy(ArchiumThreadPool *pool) {
+  if (!pool) {
+    return;
+  }
+
+  pthread_mutex_lock(&pool->mutex);
+  pool->stopping = 1;
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (size_t i = 1; i < pool->thread_count; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  pthread_mutex_destroy(&pool->mutex);
+  pthread_cond_destroy(&pool->start);
+  pthread_cond_destroy(&pool->done);
+  free(pool->workers);
+  free(pool->threads);
+  free(pool);
+}
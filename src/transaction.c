@@ -0,0 +1,271 @@
+#include "include/archium.h"
+
+#define TRANSACTION_NAME_MAX 65
+#define TRANSACTION_INITIAL_CAPACITY 16
+
+typedef struct {
+  char name[TRANSACTION_NAME_MAX];
+  ArchiumTransactionAction action;
+} TransactionEntry;
+
+static struct {
+  int open;
+  TransactionEntry *entries;
+  size_t count;
+  size_t capacity;
+} transaction;
+
+static const char *const action_names[] = {"install", "remove", "purge"};
+
+static void transaction_reset(void) {
+  free(transaction.entries);
+  memset(&transaction, 0, sizeof(transaction));
+}
+
+static TransactionEntry *find_entry(const char *name) {
+  for (size_t i = 0; i < transaction.count; i++) {
+    if (strcmp(transaction.entries[i].name, name) == 0) {
+      return &transaction.entries[i];
+    }
+  }
+  return NULL;
+}
+
+static int actions_conflict(ArchiumTransactionAction queued,
+                            ArchiumTransactionAction requested) {
+  return (queued == ARCHIUM_TX_INSTALL) != (requested == ARCHIUM_TX_INSTALL);
+}
+
+static int append_entry(const char *name, ArchiumTransactionAction action) {
+  if (transaction.count == transaction.capacity) {
+    size_t capacity = transaction.capacity ? transaction.capacity * 2
+                                           : TRANSACTION_INITIAL_CAPACITY;
+    TransactionEntry *entries =
+        realloc(transaction.entries, capacity * sizeof(*entries));
+    if (!entries) {
+      return 0;
+    }
+    transaction.entries = entries;
+    transaction.capacity = capacity;
+  }
+
+  TransactionEntry *entry = &transaction.entries[transaction.count++];
+  snprintf(entry->name, sizeof(entry->name), "%s", name);
+  entry->action = action;
+  return 1;
+}
+
+int archium_transaction_is_open(void) { return transaction.open; }
+
+size_t archium_transaction_pending(void) { return transaction.count; }
+
+void archium_transaction_begin(void) {
+  if (transaction.open) {
+    printf("\033[1;33mA transaction is already open (%zu queued).\033[0m\n",
+           transaction.count);
+    return;
+  }
+
+  transaction.open = 1;
+  printf(
+      "\033[1;32mTransaction started.\033[0m Queue \033[1;32mi\033[0m, "
+      "\033[1;32mr\033[0m and \033[1;32mp\033[0m commands, then run "
+      "\033[1;32mcommit\033[0m or \033[1;32mabort\033[0m.\n");
+  log_action("Transaction started");
+}
+
+void archium_transaction_abort(void) {
+  if (!transaction.open) {
+    printf("\033[1;33mNo transaction is open.\033[0m\n");
+    return;
+  }
+
+  printf(
+      "\033[1;33mTransaction aborted, %zu queued packages "
+      "discarded.\033[0m\n",
+      transaction.count);
+  transaction_reset();
+  log_action("Transaction aborted");
+}
+
+int archium_transaction_queue(ArchiumTransactionAction action,
+                              const char *packages) {
+  char names[MEDIUM_BUFFER_SIZE];
+  if (snprintf(names, sizeof(names), "%s", packages) >= (int)sizeof(names)) {
+    fprintf(stderr, "\033[1;31mError: Package list is too long\033[0m\n");
+    record_command_exit_code(1);
+    return 0;
+  }
+
+  char *save = NULL;
+  for (char *token = strtok_r(names, " ", &save); token;
+       token = strtok_r(NULL, " ", &save)) {
+    if (!validate_package_name(token)) {
+      fprintf(stderr, "\033[1;31mError: Invalid package name: %s\033[0m\n",
+              token);
+      record_command_exit_code(1);
+      return 0;
+    }
+    const TransactionEntry *entry = find_entry(token);
+    if (entry && actions_conflict(entry->action, action)) {
+      fprintf(stderr,
+              "\033[1;31mError: '%s' is already queued for %s\033[0m\n",
+              token, action_names[entry->action]);
+      record_command_exit_code(1);
+      return 0;
+    }
+  }
+
+  snprintf(names, sizeof(names), "%s", packages);
+  size_t queued = 0;
+  for (char *token = strtok_r(names, " ", &save); token;
+       token = strtok_r(NULL, " ", &save)) {
+    TransactionEntry *entry = find_entry(token);
+    if (entry) {
+      if (entry->action == ARCHIUM_TX_REMOVE && action == ARCHIUM_TX_PURGE) {
+        entry->action = ARCHIUM_TX_PURGE;
+        queued++;
+      }
+      continue;
+    }
+    if (!append_entry(token, action)) {
+      fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+      record_command_exit_code(1);
+      return 0;
+    }
+    queued++;
+  }
+
+  printf("\033[1;34mQueued %zu package(s) for %s (%zu pending).\033[0m\n",
+         queued, action_names[action], transaction.count);
+  return 1;
+}
+
+static char *join_names(ArchiumTransactionAction action) {
+  size_t length = 1;
+  for (size_t i = 0; i < transaction.count; i++) {
+    if (transaction.entries[i].action == action) {
+      length += strlen(transaction.entries[i].name) + 1;
+    }
+  }
+
+  char *joined = malloc(length);
+  if (!joined) {
+    return NULL;
+  }
+
+  size_t used = 0;
+  for (size_t i = 0; i < transaction.count; i++) {
+    if (transaction.entries[i].action != action) {
+      continue;
+    }
+    size_t name_length = strlen(transaction.entries[i].name);
+    if (used > 0) {
+      joined[used++] = ' ';
+    }
+    memcpy(joined + used, transaction.entries[i].name, name_length);
+    used += name_length;
+  }
+  joined[used] = '\0';
+  return joined;
+}
+
+static int run_step(const char *package_manager,
+                    ArchiumTransactionAction action, const char *flags,
+                    const char *message) {
+  char *names = join_names(action);
+  if (!names) {
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    record_command_exit_code(1);
+    return -1;
+  }
+
+  ArchiumArgv args;
+  argv_init(&args);
+  if (!argv_push(&args, package_manager) || !argv_push_words(&args, flags) ||
+      !argv_push_words(&args, names)) {
+    argv_free(&args);
+    free(names);
+    fprintf(stderr, "\033[1;31mError: Memory allocation failed\033[0m\n");
+    record_command_exit_code(1);
+    return -1;
+  }
+
+  int result;
+  if (config.use_native_output) {
+    result = execute_argv_native(args.items);
+  } else {
+    ArchiumOutput output;
+    output_init(&output);
+    result = execute_argv_with_output_capture(args.items, message, &output);
+    if (action == ARCHIUM_TX_INSTALL) {
+      parse_and_show_install_result(&output, result, names);
+    } else {
+      parse_and_show_remove_result(&output, result, names);
+    }
+    output_free(&output);
+  }
+
+  argv_free(&args);
+  free(names);
+  return result;
+}
+
+void archium_transaction_commit(const char *package_manager) {
+  if (!transaction.open) {
+    fprintf(stderr,
+            "\033[1;31mError: No transaction is open. Use begin "
+            "first.\033[0m\n");
+    record_command_exit_code(1);
+    return;
+  }
+
+  size_t counts[3] = {0, 0, 0};
+  for (size_t i = 0; i < transaction.count; i++) {
+    counts[transaction.entries[i].action]++;
+  }
+
+  if (transaction.count == 0) {
+    printf("\033[1;33mTransaction is empty, nothing to do.\033[0m\n");
+    transaction_reset();
+    return;
+  }
+
+  printf(
+      "\033[1;34mCommitting transaction: %zu to install, %zu to remove, %zu "
+      "to purge\033[0m\n",
+      counts[ARCHIUM_TX_INSTALL], counts[ARCHIUM_TX_REMOVE],
+      counts[ARCHIUM_TX_PURGE]);
+  log_action("Transaction committed");
+
+  static const struct {
+    ArchiumTransactionAction action;
+    const char *flags;
+    const char *message;
+  } steps[] = {
+      {ARCHIUM_TX_PURGE, "-Rns --noconfirm", "Purging packages"},
+      {ARCHIUM_TX_REMOVE, "-R --noconfirm", "Removing packages"},
+      {ARCHIUM_TX_INSTALL, "-S --noconfirm", "Installing packages"},
+  };
+
+  int changed = 0;
+  for (size_t i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+    if (counts[steps[i].action] == 0) {
+      continue;
+    }
+    int result = run_step(package_manager, steps[i].action, steps[i].flags,
+                          steps[i].message);
+    if (result != 0) {
+      fprintf(stderr,
+              "\033[1;31mError: Transaction step failed, remaining steps "
+              "skipped\033[0m\n");
+      break;
+    }
+    changed = 1;
+  }
+
+  if (changed) {
+    invalidate_package_cache();
+  }
+  transaction_reset();
+}
@@ -1,53 +1,110 @@
 #include <errno.h>
 #include <fcntl.h>
-#include <pthread.h>
+#include <poll.h>
+#include <spawn.h>
 #include <sys/ioctl.h>
-#include <sys/select.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
 #include <sys/wait.h>
 
 #include "include/archium.h"
 
-typedef struct {
-  int *running;
-  const char *message;
-} spinner_data_t;
+extern char **environ;
 
 void handle_signal(int signal) {
   if (signal == SIGINT || signal == SIGTERM || signal == SIGABRT) {
-    printf("\nSignal %d received. Exiting gracefully.\n", signal);
-    cleanup_cached_commands();
-    archium_plugin_cleanup();
-    exit(EXIT_SUCCESS);
+    static const char suffix[] = " received. Exiting gracefully.\n";
+    char message[64] = "\nSignal ";
+    size_t length = strlen(message);
+    if (signal >= 10) {
+      message[length++] = (char)('0' + signal / 10 % 10);
+    }
+    message[length++] = (char)('0' + signal % 10);
+    memcpy(message + length, suffix, sizeof(suffix) - 1);
+    length += sizeof(suffix) - 1;
+
+    ssize_t written = write(STDOUT_FILENO, message, length);
+    (void)written;
+    archium_logger_flush_from_signal();
+    _exit(EXIT_SUCCESS);
   }
 }
 
+static volatile sig_atomic_t terminal_width_stale = 1;
+static int terminal_width_handler_installed = 0;
+static int cached_terminal_width = 80;
+
+static void mark_terminal_width_stale(int signal) {
+  (void)signal;
+  terminal_width_stale = 1;
+}
+
 static int get_terminal_width(void) {
-  struct winsize w;
-  if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0) {
-    return w.ws_col;
+  if (!terminal_width_handler_installed) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = mark_terminal_width_stale;
+    sigemptyset(&action.sa_mask);
+    action.sa_flags = SA_RESTART;
+    sigaction(SIGWINCH, &action, NULL);
+    terminal_width_handler_installed = 1;
   }
-  return 80;
+
+  if (terminal_width_stale) {
+    terminal_width_stale = 0;
+    struct winsize w;
+    cached_terminal_width =
+        ioctl(STDOUT_FILENO, TIOCGWINSZ, &w) == 0 && w.ws_col > 0 ? w.ws_col
+                                                                  : 80;
+  }
+  return cached_terminal_width;
 }
 
-static int command_uses_pacman_like_output(const char *command) {
-  if (!command) {
+static void write_frame(const char *frame, size_t length) {
+  fflush(stdout);
+  while (length > 0) {
+    ssize_t written = write(STDOUT_FILENO, frame, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return;
+    }
+    frame += written;
+    length -= (size_t)written;
+  }
+}
+
+static int command_uses_pacman_like_output(const char *const argv[]) {
+  if (!argv) {
     return 0;
   }
 
-  return strstr(command, "pacman") != NULL || strstr(command, "yay") != NULL ||
-         strstr(command, "paru") != NULL;
+  for (size_t i = 0; argv[i] && i < 2; i++) {
+    if (strstr(argv[i], "pacman") != NULL || strstr(argv[i], "yay") != NULL ||
+        strstr(argv[i], "paru") != NULL) {
+      return 1;
+    }
+  }
+  return 0;
 }
 
-static int command_likely_requires_sudo(const char *command) {
-  if (!command) {
+static int command_likely_requires_sudo(const char *const argv[]) {
+  if (!argv) {
     return 0;
   }
 
-  return strstr(command, " -S") != NULL || strstr(command, " -R") != NULL ||
-         strstr(command, " -U") != NULL;
+  for (size_t i = 1; argv[i]; i++) {
+    if (strncmp(argv[i], "-S", 2) == 0 || strncmp(argv[i], "-R", 2) == 0 ||
+        strncmp(argv[i], "-U", 2) == 0) {
+      return 1;
+    }
+  }
+  return 0;
 }
 
-static void ensure_sudo_credentials_for_custom_output(const char *command) {
+static void ensure_sudo_credentials_for_custom_output(
+    const char *const argv[]) {
   if (config.use_native_output || config.batch_mode || config.json_output) {
     return;
   }
@@ -56,17 +113,20 @@ static void ensure_sudo_credentials_for_custom_output(const char *command) {
     return;
   }
 
-  if (!command_uses_pacman_like_output(command) ||
-      !command_likely_requires_sudo(command)) {
+  if (!command_uses_pacman_like_output(argv) ||
+      !command_likely_requires_sudo(argv)) {
     return;
   }
 
-  if (system("sudo -n -v >/dev/null 2>&1") == 0) {
+  const char *const check_argv[] = {"sudo", "-n", "-v", NULL};
+  if (run_process(check_argv, PROCESS_DISCARD_STDOUT |
+                                  PROCESS_DISCARD_STDERR) == 0) {
     return;
   }
 
   fflush(stdout);
-  (void)system("sudo -v");
+  const char *const validate_argv[] = {"sudo", "-v", NULL};
+  (void)run_process(validate_argv, 0);
 }
 
 static int parse_fraction_progress(const char *line, int *current, int *total) {
@@ -169,254 +229,968 @@ static void render_enhanced_indicator(const char *message, int spinner_position,
   show_spinner(spinner_position, message);
 }
 
+#define PROGRESS_FRAME_SIZE 4096
+#define PROGRESS_CELL_BYTES 3
+
+static char last_progress_frame[PROGRESS_FRAME_SIZE];
+static size_t last_progress_length = 0;
+
 void show_progress_bar(int current, int total, const char *prefix) {
   if (total <= 0) return;
 
-  int terminal_width = get_terminal_width();
-  int prefix_len = prefix ? strlen(prefix) : 0;
-  int available_width = terminal_width - prefix_len - 20;
+  char frame[PROGRESS_FRAME_SIZE];
+  size_t prefix_len = prefix ? strlen(prefix) : 0;
+  if (prefix_len > PROGRESS_FRAME_SIZE / 4) {
+    prefix_len = PROGRESS_FRAME_SIZE / 4;
+  }
+
+  int available_width = get_terminal_width() - (int)prefix_len - 20;
+  int max_width =
+      (int)((PROGRESS_FRAME_SIZE - prefix_len - 64) / PROGRESS_CELL_BYTES);
+  if (available_width > max_width) available_width = max_width;
   if (available_width < 10) available_width = 10;
 
   float percentage = (float)current / total;
   int filled_width = (int)(percentage * available_width);
 
-  printf("\r");
+  size_t length = 0;
+  frame[length++] = '\r';
   if (prefix) {
-    printf("%s ", prefix);
+    memcpy(frame + length, prefix, prefix_len);
+    length += prefix_len;
+    frame[length++] = ' ';
   }
 
-  printf("[");
+  frame[length++] = '[';
   for (int i = 0; i < available_width; i++) {
-    if (i < filled_width) {
-      printf("█");
-    } else {
-      printf("░");
-    }
+    memcpy(frame + length, i < filled_width ? "█" : "░", PROGRESS_CELL_BYTES);
+    length += PROGRESS_CELL_BYTES;
+  }
+  int tail = snprintf(frame + length, sizeof(frame) - length,
+                      "] %3.0f%% (%d/%d)%s", percentage * 100, current, total,
+                      current == total ? "\n" : "");
+  if (tail < 0) {
+    return;
+  }
+  length += (size_t)tail;
+  if (length >= sizeof(frame)) {
+    length = sizeof(frame) - 1;
+  }
+
+  if (length == last_progress_length &&
+      memcmp(frame, last_progress_frame, length) == 0) {
+    return;
   }
-  printf("] %3.0f%% (%d/%d)", percentage * 100, current, total);
 
+  write_frame(frame, length);
   if (current == total) {
-    printf("\n");
+    last_progress_length = 0;
+  } else {
+    memcpy(last_progress_frame, frame, length);
+    last_progress_length = length;
   }
-  fflush(stdout);
 }
 
-static void *spinner_thread(void *arg) {
-  spinner_data_t *data = (spinner_data_t *)arg;
+void show_spinner(int position, const char *message) {
   const char *spinner_chars = "|/-\\";
-  int position = 0;
+  char frame[SMALL_BUFFER_SIZE];
+  int length = snprintf(frame, sizeof(frame), "\r%s %c",
+                        message ? message : "Processing",
+                        spinner_chars[position % 4]);
+  if (length > 0) {
+    write_frame(frame, (size_t)length < sizeof(frame) ? (size_t)length
+                                                       : sizeof(frame) - 1);
+  }
+  last_progress_length = 0;
+}
 
-  while (*data->running) {
-    printf("\r\033[34m%s\033[0m %c", data->message,
-           spinner_chars[position % 4]);
-    fflush(stdout);
-    position++;
-    usleep(100000);
+void argv_init(ArchiumArgv *args) {
+  memset(args, 0, sizeof(*args));
+  archium_arena_init(&args->arena, SMALL_BUFFER_SIZE * 4);
+}
+
+int argv_push(ArchiumArgv *args, const char *arg) {
+  if (!arg) {
+    return 0;
   }
+  return argv_push_length(args, arg, strlen(arg));
+}
 
-  printf("\r\033[K");
-  fflush(stdout);
-  return NULL;
+int argv_push_length(ArchiumArgv *args, const char *arg, size_t length) {
+  if (args->count + 2 > args->capacity) {
+    size_t capacity = args->capacity ? args->capacity * 2 : 16;
+    const char **items = archium_arena_grow(
+        &args->arena, args->items, args->capacity * sizeof(char *),
+        capacity * sizeof(char *));
+    if (!items) {
+      return 0;
+    }
+    args->items = items;
+    args->capacity = capacity;
+  }
+
+  char *copy = archium_arena_strndup(&args->arena, arg, length);
+  if (!copy) {
+    return 0;
+  }
+  args->items[args->count++] = copy;
+  args->items[args->count] = NULL;
+  return 1;
 }
 
-void show_spinner(int position, const char *message) {
-  const char *spinner_chars = "|/-\\";
-  printf("\r%s %c", message ? message : "Processing",
-         spinner_chars[position % 4]);
-  fflush(stdout);
+int argv_push_words(ArchiumArgv *args, const char *words) {
+  if (!words) {
+    return 0;
+  }
+
+  const char *cursor = words;
+  while (*cursor) {
+    while (isspace((unsigned char)*cursor)) {
+      cursor++;
+    }
+    const char *start = cursor;
+    while (*cursor && !isspace((unsigned char)*cursor)) {
+      cursor++;
+    }
+    if (cursor > start &&
+        !argv_push_length(args, start, (size_t)(cursor - start))) {
+      return 0;
+    }
+  }
+  return 1;
 }
 
-int execute_command_with_spinner(const char *command, const char *message) {
-  int running = 1;
-  pthread_t spinner_tid;
-  spinner_data_t spinner_data = {&running, message ? message : "Processing"};
+void argv_free(ArchiumArgv *args) {
+  archium_arena_free(&args->arena);
+  memset(args, 0, sizeof(*args));
+}
 
-  if (config.batch_mode || config.json_output) {
-    char silent_command[COMMAND_BUFFER_SIZE];
-    snprintf(silent_command, sizeof(silent_command),
-             "%s 2>/dev/null >/dev/null", command);
-    return system(silent_command);
+static int exit_code_from_status(int status) {
+  if (WIFEXITED(status)) {
+    return WEXITSTATUS(status);
+  }
+  if (WIFSIGNALED(status)) {
+    return 128 + WTERMSIG(status);
   }
+  return -1;
+}
 
-  if (pthread_create(&spinner_tid, NULL, spinner_thread, &spinner_data) != 0) {
-    return system(command);
+/*
+ * Children run in their own process group so a timeout or cancel can kill
+ * the whole tree. When we own the controlling terminal, that group becomes
+ * the foreground so sudo, pacman and makepkg can still prompt; /dev/tty is
+ * used rather than stdin so this also works with redirected input.
+ */
+static void hand_over_terminal(ArchiumProcess *process) {
+  int fd = open("/dev/tty", O_RDWR | O_NOCTTY | O_CLOEXEC);
+  if (fd < 0) {
+    return;
   }
 
-  char silent_command[COMMAND_BUFFER_SIZE];
-  snprintf(silent_command, sizeof(silent_command), "%s 2>/dev/null >/dev/null",
-           command);
-  int result = system(silent_command);
+  if (tcgetpgrp(fd) == getpgrp() && tcsetpgrp(fd, process->group) == 0) {
+    process->terminal_fd = fd;
+    kill(-process->group, SIGCONT);
+  } else {
+    close(fd);
+  }
+}
 
-  running = 0;
-  pthread_join(spinner_tid, NULL);
+int spawn_process(ArchiumProcess *process, const char *const argv[],
+                  int flags) {
+  process->pid = -1;
+  process->group = 0;
+  process->exit_code = -1;
+  process->output_fd = -1;
+  process->terminal_fd = -1;
+  process->output = NULL;
 
-  return result;
+  if (!argv || !argv[0]) {
+    return 0;
+  }
+
+  int capture = (flags & PROCESS_CAPTURE_STDOUT) != 0;
+  int pipe_fds[2] = {-1, -1};
+  if (capture) {
+    if (pipe(pipe_fds) != 0) {
+      return 0;
+    }
+    (void)fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+    (void)fcntl(pipe_fds[1], F_SETFD, FD_CLOEXEC);
+  }
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (capture) {
+    posix_spawn_file_actions_adddup2(&actions, pipe_fds[1], STDOUT_FILENO);
+  } else if (flags & PROCESS_DISCARD_STDOUT) {
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+  }
+  if (flags & PROCESS_DISCARD_STDERR) {
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null",
+                                     O_WRONLY, 0);
+  } else if (flags & PROCESS_MERGE_STDERR) {
+    posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  }
+
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t defaults;
+  sigemptyset(&defaults);
+  sigaddset(&defaults, SIGINT);
+  sigaddset(&defaults, SIGQUIT);
+  sigaddset(&defaults, SIGPIPE);
+  sigset_t mask;
+  sigemptyset(&mask);
+  posix_spawnattr_setsigdefault(&attr, &defaults);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  short spawn_flags = POSIX_SPAWN_SETSIGDEF | POSIX_SPAWN_SETSIGMASK;
+  if (flags & PROCESS_NEW_GROUP) {
+    posix_spawnattr_setpgroup(&attr, 0);
+    spawn_flags |= POSIX_SPAWN_SETPGROUP;
+  }
+  posix_spawnattr_setflags(&attr, spawn_flags);
+
+  pid_t pid;
+  int rc = posix_spawnp(&pid, argv[0], &actions, &attr, (char *const *)argv,
+                        environ);
+  posix_spawn_file_actions_destroy(&actions);
+  posix_spawnattr_destroy(&attr);
+
+  if (capture) {
+    close(pipe_fds[1]);
+  }
+  if (rc != 0) {
+    if (capture) {
+      close(pipe_fds[0]);
+    }
+    if (config.verbose) {
+      char message[SMALL_BUFFER_SIZE];
+      snprintf(message, sizeof(message), "Failed to start %s: %s", argv[0],
+               strerror(rc));
+      log_debug(message);
+    }
+    return 0;
+  }
+
+  process->pid = pid;
+  process->group = (flags & PROCESS_NEW_GROUP) ? pid : 0;
+  process->output_fd = capture ? pipe_fds[0] : -1;
+
+  if (process->group > 0) {
+    hand_over_terminal(process);
+  }
+  return 1;
 }
 
-int execute_command_with_output_capture(const char *command,
-                                        const char *message,
-                                        char *output_buffer,
-                                        size_t buffer_size) {
-  const char *display_message = message ? message : "Processing";
-  int use_interactive_indicator = isatty(STDOUT_FILENO);
-  int prefer_fraction_progress = command_uses_pacman_like_output(command);
-  int spinner_position = 0;
-  int has_progress = 0;
-  int current_progress = 0;
-  int total_progress = 100;
+static void reclaim_terminal(ArchiumProcess *process) {
+  if (process->terminal_fd < 0) {
+    return;
+  }
 
-  if (config.batch_mode || config.json_output) {
-    FILE *fp = popen(command, "r");
-    if (fp == NULL) return -1;
-    if (output_buffer && buffer_size > 0) {
-      size_t bytes_read = fread(output_buffer, 1, buffer_size - 1, fp);
-      output_buffer[bytes_read] = '\0';
+  sigset_t block;
+  sigset_t saved;
+  sigemptyset(&block);
+  sigaddset(&block, SIGTTOU);
+  pthread_sigmask(SIG_BLOCK, &block, &saved);
+  tcsetpgrp(process->terminal_fd, getpgrp());
+  pthread_sigmask(SIG_SETMASK, &saved, NULL);
+  close(process->terminal_fd);
+  process->terminal_fd = -1;
+}
+
+FILE *process_output(ArchiumProcess *process) {
+  if (!process->output && process->output_fd >= 0) {
+    process->output = fdopen(process->output_fd, "r");
+  }
+  return process->output;
+}
+
+int wait_process(ArchiumProcess *process) {
+  if (process->output) {
+    fclose(process->output);
+  } else if (process->output_fd >= 0) {
+    close(process->output_fd);
+  }
+  process->output = NULL;
+  process->output_fd = -1;
+
+  if (process->pid <= 0) {
+    return process->exit_code;
+  }
+
+  int status = 0;
+  pid_t waited;
+  do {
+    waited = waitpid(process->pid, &status, 0);
+  } while (waited < 0 && errno == EINTR);
+  process->pid = -1;
+  process->exit_code = waited < 0 ? -1 : exit_code_from_status(status);
+  reclaim_terminal(process);
+
+  return process->exit_code;
+}
+
+static int reap_process(ArchiumProcess *process) {
+  if (process->pid <= 0) {
+    return 1;
+  }
+
+  int status = 0;
+  pid_t waited = waitpid(process->pid, &status, WNOHANG);
+  if (waited == 0 || (waited < 0 && errno == EINTR)) {
+    return 0;
+  }
+
+  process->pid = -1;
+  process->exit_code = waited < 0 ? -1 : exit_code_from_status(status);
+  reclaim_terminal(process);
+  return 1;
+}
+
+static int command_exit_code = 0;
+
+void reset_command_exit_code(void) { command_exit_code = 0; }
+
+void record_command_exit_code(int exit_code) {
+  if (command_exit_code == 0) {
+    command_exit_code = exit_code;
+  }
+}
+
+int get_command_exit_code(void) { return command_exit_code; }
+
+#define OUTPUT_INITIAL_CAPACITY 4096
+
+void output_init(ArchiumOutput *output) {
+  memset(output, 0, sizeof(*output));
+  output->limit = (size_t)config.capture_limit_kb * 1024;
+}
+
+static void output_trim_head(ArchiumOutput *output) {
+  size_t excess = output->length - output->limit;
+  size_t drop = excess + output->limit / 4;
+  if (drop > output->length) {
+    drop = output->length;
+  }
+
+  const char *newline =
+      memchr(output->data + drop, '\n', output->length - drop);
+  if (newline && (size_t)(newline - output->data) < output->length - 1) {
+    drop = (size_t)(newline - output->data) + 1;
+  }
+
+  memmove(output->data, output->data + drop, output->length - drop);
+  output->length -= drop;
+  output->data[output->length] = '\0';
+  output->truncated = 1;
+}
+
+int output_append(ArchiumOutput *output, const char *data, size_t length) {
+  if (!output || length == 0) {
+    return 1;
+  }
+
+  if (output->limit > 0 && length > output->limit) {
+    data += length - output->limit;
+    length = output->limit;
+    const char *newline = memchr(data, '\n', length);
+    if (newline && (size_t)(newline - data) < length - 1) {
+      length -= (size_t)(newline - data) + 1;
+      data = newline + 1;
     }
-    return pclose(fp);
+    output->length = 0;
+    output->truncated = 1;
   }
 
-  if (output_buffer && buffer_size > 0) {
-    output_buffer[0] = '\0';
+  size_t needed = output->length + length + 1;
+  if (needed > output->capacity) {
+    size_t capacity =
+        output->capacity ? output->capacity : OUTPUT_INITIAL_CAPACITY;
+    while (capacity < needed) {
+      capacity *= 2;
+    }
+    if (output->limit > 0 && capacity > output->limit + length + 1) {
+      capacity = output->limit + length + 1;
+    }
+
+    char *grown = realloc(output->data, capacity);
+    if (!grown) {
+      output->truncated = 1;
+      return 0;
+    }
+    output->data = grown;
+    output->capacity = capacity;
   }
 
-  ensure_sudo_credentials_for_custom_output(command);
+  memcpy(output->data + output->length, data, length);
+  output->length += length;
+  output->data[output->length] = '\0';
 
-  char merged_command[COMMAND_BUFFER_SIZE + 32];
-  if (snprintf(merged_command, sizeof(merged_command), "%s 2>&1", command) >=
-      (int)sizeof(merged_command)) {
-    return system(command);
+  if (output->limit > 0 && output->length > output->limit) {
+    output_trim_head(output);
   }
+  return 1;
+}
 
-  FILE *fp = popen(merged_command, "r");
-  if (fp == NULL) {
-    return -1;
+static int is_package_operation_line(const char *line) {
+  static const char *const markers[] = {"installing ", "upgrading ",
+                                        "downgrading ", "reinstalling ",
+                                        "removing "};
+
+  if (line[0] == '(') {
+    const char *close = strchr(line, ')');
+    if (close && close[1] == ' ') {
+      line = close + 2;
+    }
+  }
+  for (size_t i = 0; i < sizeof(markers) / sizeof(markers[0]); i++) {
+    if (strncmp(line, markers[i], strlen(markers[i])) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+void output_scan_line(ArchiumOutput *output, const char *line) {
+  ArchiumOutputSummary *summary = &output->summary;
+
+  if (strstr(line, "there is nothing to do") ||
+      strstr(line, "nothing to upgrade")) {
+    summary->nothing_to_do = 1;
+  }
+  if (strstr(line, "up to date")) {
+    summary->up_to_date = 1;
+  }
+  if (strstr(line, "already installed")) {
+    summary->already_installed = 1;
+  }
+  if (strstr(line, "not found") || strstr(line, "not installed")) {
+    summary->not_installed = 1;
   }
+  if (is_package_operation_line(line)) {
+    summary->changed_lines++;
+  }
+}
+
+const char *output_text(const ArchiumOutput *output) {
+  return output && output->data ? output->data : "";
+}
 
-  int fd = fileno(fp);
-  int original_flags = fcntl(fd, F_GETFL, 0);
-  if (original_flags != -1) {
-    (void)fcntl(fd, F_SETFL, original_flags | O_NONBLOCK);
+void output_free(ArchiumOutput *output) {
+  if (!output) {
+    return;
   }
+  free(output->data);
+  memset(output, 0, sizeof(*output));
+}
 
-  char line_buffer[1024];
-  size_t line_length = 0;
-  size_t captured = 0;
+#define CAPTURE_CHUNK_SIZE 65536
 
-  while (1) {
-    fd_set read_fds;
-    FD_ZERO(&read_fds);
-    FD_SET(fd, &read_fds);
+typedef struct {
+  ArchiumOutput *output;
+  int prefer_fraction;
+  int has_progress;
+  int current;
+  int total;
+  const char *message;
+  int interactive;
+  int spinner_position;
+  int drawn_current;
+  int drawn_total;
+  long long last_frame_ms;
+  size_t line_length;
+  char line[COMMAND_BUFFER_SIZE];
+} CaptureState;
+
+static void capture_init(CaptureState *state, ArchiumOutput *output,
+                         const char *const argv[], const char *message) {
+  state->output = output;
+  state->prefer_fraction = command_uses_pacman_like_output(argv);
+  state->has_progress = 0;
+  state->current = 0;
+  state->total = 100;
+  state->message = message ? message : "Processing";
+  state->interactive = !config.batch_mode && !config.json_output &&
+                       isatty(STDOUT_FILENO);
+  state->spinner_position = 0;
+  state->drawn_current = -1;
+  state->drawn_total = -1;
+  state->last_frame_ms = 0;
+  state->line_length = 0;
+}
 
-    struct timeval timeout;
-    timeout.tv_sec = 0;
-    timeout.tv_usec = 100000;
+static void capture_handle_line(CaptureState *state, const char *line) {
+  if (line[0] == '\0') {
+    return;
+  }
 
-    int ready = select(fd + 1, &read_fds, NULL, NULL, &timeout);
-    if (ready < 0) {
-      if (errno == EINTR) {
-        continue;
-      }
-      break;
+  update_progress_from_line(line, state->prefer_fraction, &state->current,
+                            &state->total, &state->has_progress);
+  if (state->output) {
+    output_scan_line(state->output, line);
+  }
+}
+
+static void capture_hold_partial(CaptureState *state, const char *data,
+                                 size_t length) {
+  size_t room = sizeof(state->line) - 1 - state->line_length;
+  if (length > room) {
+    length = room;
+  }
+  memcpy(state->line + state->line_length, data, length);
+  state->line_length += length;
+}
+
+static void capture_finish_line(CaptureState *state) {
+  if (state->line_length == 0) {
+    return;
+  }
+
+  state->line[state->line_length] = '\0';
+  state->line_length = 0;
+  capture_handle_line(state, state->line);
+}
+
+static void capture_consume(CaptureState *state, char *chunk, size_t length) {
+  output_append(state->output, chunk, length);
+
+  char *end = chunk + length;
+  while (chunk < end) {
+    char *eol =
+        (char *)archium_scan_byte2(chunk, (size_t)(end - chunk), '\n', '\r');
+    if (!eol) {
+      capture_hold_partial(state, chunk, (size_t)(end - chunk));
+      return;
+    }
+
+    if (state->line_length > 0) {
+      capture_hold_partial(state, chunk, (size_t)(eol - chunk));
+      capture_finish_line(state);
+    } else {
+      *eol = '\0';
+      capture_handle_line(state, chunk);
+    }
+    chunk = eol + 1;
+  }
+}
+
+#define PROGRESS_FRAME_INTERVAL_MS 50
+
+static long long monotonic_ms(void) {
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (long long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void capture_redraw(CaptureState *state, int tick) {
+  if (!state->interactive) {
+    return;
+  }
+
+  if (state->has_progress) {
+    if (state->current == state->drawn_current &&
+        state->total == state->drawn_total) {
+      return;
+    }
+    long long now = monotonic_ms();
+    if (now - state->last_frame_ms < PROGRESS_FRAME_INTERVAL_MS) {
+      return;
+    }
+    state->last_frame_ms = now;
+    state->drawn_current = state->current;
+    state->drawn_total = state->total;
+  } else if (!tick) {
+    return;
+  }
+
+  render_enhanced_indicator(state->message, state->spinner_position,
+                            state->has_progress, state->current,
+                            state->total);
+  state->spinner_position++;
+}
+
+static void capture_clear_indicator(CaptureState *state) {
+  if (!state->interactive) {
+    return;
+  }
+
+  if (state->has_progress && state->total > 0) {
+    if (state->current < state->total) {
+      show_progress_bar(state->total, state->total, state->message);
+    }
+  } else {
+    printf("\r\033[K");
+    fflush(stdout);
+  }
+}
+
+#define INDICATOR_TICK_NS 100000000L
+#define TERMINATE_GRACE_MS 5000
+
+typedef struct {
+  int signal_fd;
+  int timer_fd;
+  int pending_signal;
+  int terminating;
+  int timed_out;
+  long long deadline_ms;
+  long long kill_at_ms;
+  sigset_t saved_mask;
+} EventLoop;
+
+static int event_loop_open(EventLoop *loop, int with_timer) {
+  sigset_t mask;
+  sigemptyset(&mask);
+  sigaddset(&mask, SIGCHLD);
+  sigaddset(&mask, SIGINT);
+  sigaddset(&mask, SIGTERM);
+
+  loop->timer_fd = -1;
+  loop->pending_signal = 0;
+  loop->terminating = 0;
+  loop->timed_out = 0;
+  loop->deadline_ms = config.command_timeout_seconds > 0
+                          ? monotonic_ms() +
+                                (long long)config.command_timeout_seconds * 1000
+                          : 0;
+  loop->kill_at_ms = 0;
+  if (pthread_sigmask(SIG_BLOCK, &mask, &loop->saved_mask) != 0) {
+    return 0;
+  }
+
+  loop->signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+  if (loop->signal_fd < 0) {
+    pthread_sigmask(SIG_SETMASK, &loop->saved_mask, NULL);
+    return 0;
+  }
+
+  if (with_timer) {
+    loop->timer_fd =
+        timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    struct itimerspec tick = {{0, INDICATOR_TICK_NS}, {0, INDICATOR_TICK_NS}};
+    if (loop->timer_fd >= 0 &&
+        timerfd_settime(loop->timer_fd, 0, &tick, NULL) != 0) {
+      close(loop->timer_fd);
+      loop->timer_fd = -1;
     }
+  }
+  return 1;
+}
 
-    if (ready == 0) {
-      if (use_interactive_indicator) {
-        render_enhanced_indicator(display_message, spinner_position,
-                                  has_progress, current_progress,
-                                  total_progress);
-        spinner_position++;
+static int event_loop_read_signals(EventLoop *loop) {
+  struct signalfd_siginfo info[8];
+  int child_changed = 0;
+  ssize_t bytes_read;
+
+  while ((bytes_read = read(loop->signal_fd, info, sizeof(info))) > 0) {
+    size_t count = (size_t)bytes_read / sizeof(info[0]);
+    for (size_t i = 0; i < count; i++) {
+      if (info[i].ssi_signo == SIGINT || info[i].ssi_signo == SIGTERM) {
+        loop->pending_signal = (int)info[i].ssi_signo;
+      } else if (info[i].ssi_signo == SIGCHLD) {
+        child_changed = 1;
       }
-      continue;
     }
+  }
+  return child_changed;
+}
+
+static void event_loop_close(EventLoop *loop) {
+  event_loop_read_signals(loop);
+  close(loop->signal_fd);
+  if (loop->timer_fd >= 0) {
+    close(loop->timer_fd);
+  }
+  pthread_sigmask(SIG_SETMASK, &loop->saved_mask, NULL);
+
+  if (loop->pending_signal) {
+    raise(loop->pending_signal);
+  }
+}
+
+static void signal_process(const ArchiumProcess *process, int signal) {
+  if (process->group > 0) {
+    kill(-process->group, signal);
+  } else if (process->pid > 0) {
+    kill(process->pid, signal);
+  }
+}
+
+static void event_loop_check_deadlines(EventLoop *loop,
+                                       const ArchiumProcess *process) {
+  long long now = monotonic_ms();
+
+  if (!loop->terminating &&
+      (loop->pending_signal ||
+       (loop->deadline_ms > 0 && now >= loop->deadline_ms))) {
+    loop->timed_out = !loop->pending_signal;
+    loop->terminating = 1;
+    loop->kill_at_ms = now + TERMINATE_GRACE_MS;
+    signal_process(process, SIGTERM);
+  } else if (loop->terminating == 1 && now >= loop->kill_at_ms) {
+    loop->terminating = 2;
+    signal_process(process, SIGKILL);
+  }
+}
+
+static int event_loop_poll_timeout(const EventLoop *loop) {
+  long long wake_at = loop->terminating == 1 ? loop->kill_at_ms
+                      : loop->terminating    ? 0
+                                             : loop->deadline_ms;
+  if (wake_at == 0) {
+    return -1;
+  }
+
+  long long remaining = wake_at - monotonic_ms();
+  return remaining > 0 ? (int)remaining : 0;
+}
+
+static void drain_output(ArchiumProcess *process, CaptureState *state) {
+  char chunk[CAPTURE_CHUNK_SIZE];
+  ssize_t bytes_read;
+  while ((bytes_read = read(process->output_fd, chunk, sizeof(chunk))) > 0) {
+    capture_consume(state, chunk, (size_t)bytes_read);
+  }
+}
+
+static void event_loop_run(EventLoop *loop, ArchiumProcess *process,
+                           CaptureState *state) {
+  int fd = process->output_fd;
+  if (fd >= 0) {
+    int original_flags = fcntl(fd, F_GETFL, 0);
+    if (original_flags != -1) {
+      (void)fcntl(fd, F_SETFL, original_flags | O_NONBLOCK);
+    }
+  }
 
-    char chunk[256];
-    ssize_t bytes_read = read(fd, chunk, sizeof(chunk));
-    if (bytes_read < 0) {
-      if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+  while (process->pid > 0 || fd >= 0) {
+    struct pollfd fds[3];
+    nfds_t count = 0;
+    nfds_t output_index = 0;
+    nfds_t timer_index = 0;
+
+    fds[count].fd = loop->signal_fd;
+    fds[count++].events = POLLIN;
+    if (loop->timer_fd >= 0) {
+      timer_index = count;
+      fds[count].fd = loop->timer_fd;
+      fds[count++].events = POLLIN;
+    }
+    if (fd >= 0) {
+      output_index = count;
+      fds[count].fd = fd;
+      fds[count++].events = POLLIN;
+    }
+
+    if (poll(fds, count, event_loop_poll_timeout(loop)) < 0) {
+      if (errno == EINTR) {
         continue;
       }
       break;
     }
 
-    if (bytes_read == 0) {
-      break;
+    if (fds[0].revents & POLLIN) {
+      if (event_loop_read_signals(loop) && reap_process(process) && fd >= 0) {
+        drain_output(process, state);
+        break;
+      }
     }
+    event_loop_check_deadlines(loop, process);
 
-    for (ssize_t i = 0; i < bytes_read; i++) {
-      unsigned char c = (unsigned char)chunk[i];
-
-      if (output_buffer && buffer_size > 0 && captured < buffer_size - 1) {
-        output_buffer[captured++] = (char)c;
-        output_buffer[captured] = '\0';
+    if (timer_index && (fds[timer_index].revents & POLLIN)) {
+      uint64_t expirations;
+      if (read(loop->timer_fd, &expirations, sizeof(expirations)) > 0) {
+        capture_redraw(state, 1);
       }
+    }
 
-      if (c == '\n' || c == '\r') {
-        line_buffer[line_length] = '\0';
-        if (line_length > 0) {
-          update_progress_from_line(line_buffer, prefer_fraction_progress,
-                                    &current_progress, &total_progress,
-                                    &has_progress);
-        }
-        line_length = 0;
-        continue;
+    if (output_index && fds[output_index].revents) {
+      char chunk[CAPTURE_CHUNK_SIZE];
+      ssize_t bytes_read = read(fd, chunk, sizeof(chunk));
+      if (bytes_read > 0) {
+        capture_consume(state, chunk, (size_t)bytes_read);
+        capture_redraw(state, 0);
+      } else if (bytes_read == 0 ||
+                 (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+        fd = -1;
       }
+    }
+  }
+
+  capture_finish_line(state);
+}
+
+static int run_with_indicator(const char *const argv[], int flags,
+                              CaptureState *state) {
+  EventLoop loop;
+  ArchiumProcess process;
 
-      if ((isprint(c) || c == '\t') && line_length < sizeof(line_buffer) - 1) {
-        line_buffer[line_length++] = (char)c;
+  if (!event_loop_open(&loop, state->interactive)) {
+    if (!spawn_process(&process, argv, flags)) {
+      return -1;
+    }
+    if (flags & PROCESS_CAPTURE_STDOUT) {
+      int original_flags = fcntl(process.output_fd, F_GETFL, 0);
+      if (original_flags != -1) {
+        (void)fcntl(process.output_fd, F_SETFL, original_flags & ~O_NONBLOCK);
       }
+      drain_output(&process, state);
+      capture_finish_line(state);
     }
+    return wait_process(&process);
   }
 
-  if (line_length > 0) {
-    line_buffer[line_length] = '\0';
-    update_progress_from_line(line_buffer, prefer_fraction_progress,
-                              &current_progress, &total_progress,
-                              &has_progress);
+  if (!spawn_process(&process, argv, flags)) {
+    event_loop_close(&loop);
+    return -1;
   }
 
-  if (use_interactive_indicator) {
-    if (has_progress && total_progress > 0) {
-      if (current_progress < total_progress) {
-        show_progress_bar(total_progress, total_progress, display_message);
-      }
-    } else {
-      printf("\r\033[K");
-      fflush(stdout);
-    }
+  event_loop_run(&loop, &process, state);
+  capture_clear_indicator(state);
+  if (loop.terminating) {
+    signal_process(&process, SIGKILL);
+  }
+  int result = wait_process(&process);
+  event_loop_close(&loop);
+
+  if (loop.timed_out) {
+    archium_report_error(ARCHIUM_ERROR_TIMEOUT,
+                         "Command exceeded command_timeout_seconds", argv[0]);
+    return ARCHIUM_ERROR_TIMEOUT;
+  }
+  return result;
+}
+
+/*
+ * Native commands keep the terminal (see hand_over_terminal) but still go
+ * through the event loop, so command_timeout_seconds and SIGINT/SIGTERM
+ * take down the whole process group rather than just the direct child.
+ */
+int run_process(const char *const argv[], int flags) {
+  CaptureState state;
+  capture_init(&state, NULL, argv, NULL);
+  state.interactive = 0;
+  return run_with_indicator(
+      argv, (flags & ~PROCESS_CAPTURE_STDOUT) | PROCESS_NEW_GROUP, &state);
+}
+
+int execute_argv_with_spinner(const char *const argv[], const char *message) {
+  CaptureState state;
+  capture_init(&state, NULL, argv, message);
+  state.prefer_fraction = 0;
+  return run_with_indicator(argv,
+                            PROCESS_DISCARD_STDOUT | PROCESS_DISCARD_STDERR |
+                                PROCESS_NEW_GROUP,
+                            &state);
+}
+
+int execute_argv_with_output_capture(const char *const argv[],
+                                     const char *message,
+                                     ArchiumOutput *output) {
+  CaptureState state;
+  capture_init(&state, output, argv, message);
+
+  if (config.batch_mode || config.json_output) {
+    return run_with_indicator(
+        argv, PROCESS_CAPTURE_STDOUT | PROCESS_NEW_GROUP, &state);
   }
 
-  int result = pclose(fp);
+  ensure_sudo_credentials_for_custom_output(argv);
+  return run_with_indicator(argv,
+                            PROCESS_CAPTURE_STDOUT | PROCESS_MERGE_STDERR |
+                                PROCESS_NEW_GROUP,
+                            &state);
+}
 
+int execute_argv_native(const char *const argv[]) {
+  int result = run_process(argv, 0);
+  record_command_exit_code(result);
   return result;
 }
 
-int execute_command_native(const char *command) { return system(command); }
+int execute_command_with_output_capture(const char *command,
+                                        const char *message,
+                                        char *output_buffer,
+                                        size_t buffer_size) {
+  const char *const argv[] = {"/bin/sh", "-c", command, NULL};
+  ArchiumOutput output;
+  output_init(&output);
+  if (buffer_size > 0) {
+    output.limit = buffer_size - 1;
+  }
+
+  int result = execute_argv_with_output_capture(argv, message, &output);
+  if (output_buffer && buffer_size > 0) {
+    snprintf(output_buffer, buffer_size, "%s", output_text(&output));
+  }
+  output_free(&output);
+  return result;
+}
+
+static void print_json_string(const char *text) {
+  putchar('"');
+  for (const unsigned char *p = (const unsigned char *)text; *p; p++) {
+    switch (*p) {
+      case '"':
+        fputs("\\\"", stdout);
+        break;
+      case '\\':
+        fputs("\\\\", stdout);
+        break;
+      case '\n':
+        fputs("\\n", stdout);
+        break;
+      case '\r':
+        fputs("\\r", stdout);
+        break;
+      case '\t':
+        fputs("\\t", stdout);
+        break;
+      default:
+        if (*p < 0x20) {
+          printf("\\u%04x", *p);
+        } else {
+          putchar(*p);
+        }
+    }
+  }
+  putchar('"');
+}
+
+void print_command_status(const char *command, ArchiumError status,
+                          int exit_code, int executed) {
+  if (!config.json_output) {
+    return;
+  }
+  printf("{\"command\": ");
+  print_json_string(command);
+  if (executed) {
+    printf(", \"status\": %d, \"exit_code\": %d}\n", status, exit_code);
+  } else {
+    printf(", \"skipped\": true}\n");
+  }
+  fflush(stdout);
+}
 
-void parse_and_show_upgrade_result(const char *output, int exit_code) {
+void parse_and_show_upgrade_result(const ArchiumOutput *output,
+                                   int exit_code) {
+  record_command_exit_code(exit_code);
   if (config.json_output) {
-    printf(
-        "{\"operation\": \"upgrade\", \"exit_code\": %d, \"output\": \"%s\"}\n",
-        exit_code, output ? output : "");
+    printf("{\"operation\": \"upgrade\", \"exit_code\": %d, \"output\": ",
+           exit_code);
+    print_json_string(output_text(output));
+    printf("}\n");
     return;
   }
   if (exit_code == 0) {
-    if (strstr(output, "there is nothing to do") ||
-        strstr(output, "nothing to upgrade") || strstr(output, "up to date")) {
+    const ArchiumOutputSummary *summary = &output->summary;
+    if (summary->changed_lines > 0) {
+      printf("\r\033[32m✓\033[0m %s - %d packages updated\n",
+             "Upgrading system", summary->changed_lines);
+    } else if (summary->nothing_to_do || summary->up_to_date) {
       printf("\r\033[32m✓\033[0m %s - System is already up to date\n",
              "Upgrading system");
-    } else if (strstr(output, "upgraded") || strstr(output, "installed") ||
-               strstr(output, "removed")) {
-      int packages = 0;
-      char *line = strtok((char *)output, "\n");
-      while (line != NULL) {
-        if (strstr(line, "upgraded") || strstr(line, "installed") ||
-            strstr(line, "removed")) {
-          packages++;
-        }
-        line = strtok(NULL, "\n");
-      }
-      printf("\r\033[32m✓\033[0m %s - %d packages updated\n",
-             "Upgrading system", packages);
     } else {
       printf("\r\033[32m✓\033[0m %s completed successfully\n",
              "Upgrading system");
@@ -426,17 +1200,19 @@ void parse_and_show_upgrade_result(const char *output, int exit_code) {
   }
 }
 
-void parse_and_show_install_result(const char *output, int exit_code,
+void parse_and_show_install_result(const ArchiumOutput *output, int exit_code,
                                    const char *package) {
+  record_command_exit_code(exit_code);
   if (config.json_output) {
-    printf(
-        "{\"operation\": \"install\", \"package\": \"%s\", \"exit_code\": %d, "
-        "\"output\": \"%s\"}\n",
-        package ? package : "", exit_code, output ? output : "");
+    printf("{\"operation\": \"install\", \"package\": ");
+    print_json_string(package ? package : "");
+    printf(", \"exit_code\": %d, \"output\": ", exit_code);
+    print_json_string(output_text(output));
+    printf("}\n");
     return;
   }
   if (exit_code == 0) {
-    if (strstr(output, "already installed") || strstr(output, "up to date")) {
+    if (output->summary.already_installed || output->summary.up_to_date) {
       printf("\r\033[33m◦\033[0m Package '%s' is already installed\n", package);
     } else {
       printf("\r\033[32m✓\033[0m Package '%s' installed successfully\n",
@@ -447,17 +1223,19 @@ void parse_and_show_install_result(const char *output, int exit_code,
   }
 }
 
-void parse_and_show_remove_result(const char *output, int exit_code,
+void parse_and_show_remove_result(const ArchiumOutput *output, int exit_code,
                                   const char *package) {
+  record_command_exit_code(exit_code);
   if (config.json_output) {
-    printf(
-        "{\"operation\": \"remove\", \"package\": \"%s\", \"exit_code\": %d, "
-        "\"output\": \"%s\"}\n",
-        package ? package : "", exit_code, output ? output : "");
+    printf("{\"operation\": \"remove\", \"package\": ");
+    print_json_string(package ? package : "");
+    printf(", \"exit_code\": %d, \"output\": ", exit_code);
+    print_json_string(output_text(output));
+    printf("}\n");
     return;
   }
   if (exit_code == 0) {
-    if (strstr(output, "not found") || strstr(output, "not installed")) {
+    if (output->summary.not_installed) {
       printf("\r\033[33m◦\033[0m Package '%s' was not installed\n", package);
     } else {
       printf("\r\033[32m✓\033[0m Package '%s' removed successfully\n", package);
@@ -467,8 +1245,8 @@ void parse_and_show_remove_result(const char *output, int exit_code,
   }
 }
 
-void parse_and_show_generic_result(const char *output __attribute__((unused)),
-                                   int exit_code, const char *operation) {
+void parse_and_show_generic_result(int exit_code, const char *operation) {
+  record_command_exit_code(exit_code);
   if (config.json_output) {
     printf("{\"operation\": \"%s\", \"exit_code\": %d}\n", operation,
            exit_code);
@@ -510,12 +1288,6 @@ void get_input(char *input, size_t input_size, const char *prompt) {
 }
 
 int is_valid_command(const char *command) {
-  const char *valid_commands[] = {
-      "u",  "i",  "r",  "d",      "p",      "c",    "o",  "s",  "h",
-      "q",  "l",  "?",  "cu",     "dt",     "cc",   "lo", "si", "re",
-      "ex", "ow", "ba", "health", "config", "help", "pl", "pd", "pe"};
-  int num_commands = sizeof(valid_commands) / sizeof(valid_commands[0]);
-
   if (!command) {
     return 0;
   }
@@ -533,25 +1305,8 @@ int is_valid_command(const char *command) {
   memcpy(token, command, token_len);
   token[token_len] = '\0';
 
-  for (int i = 0; i < num_commands; i++) {
-    if (strcmp(token, valid_commands[i]) == 0) {
-      return 1;
-    }
-  }
-
-  if (strncmp(command, "u ", 2) == 0 || strncmp(command, "h ", 2) == 0 ||
-      strncmp(command, "i ", 2) == 0 || strncmp(command, "r ", 2) == 0 ||
-      strncmp(command, "d ", 2) == 0 || strncmp(command, "p ", 2) == 0 ||
-      strncmp(command, "s ", 2) == 0 || strncmp(command, "? ", 2) == 0 ||
-      strncmp(command, "dt ", 3) == 0 || strncmp(command, "ow ", 3) == 0) {
-    return 1;
-  }
-
-  if (archium_plugin_is_plugin_command(token)) {
-    return 1;
-  }
-
-  return 0;
+  return builtin_command_index(token) >= 0 ||
+         archium_plugin_is_plugin_command(token);
 }
 
 int sanitize_shell_input(const char *input, char *output, size_t output_size) {
@@ -0,0 +1,300 @@
+#include "test.h"
+
+/*
+ * Microbenchmarks for the hot paths: completion lookups, output capture,
+ * the local DB scan and dependency graph construction. Fixtures are
+ * synthetic and generated in a temporary directory; timings are the best of
+ * a few runs so a noisy neighbour does not skew them.
+ */
+
+#define BENCH_NAMES 100000
+#define BENCH_LOG_MB 32
+#define BENCH_LOCAL_PACKAGES 20000
+#define BENCH_GRAPH_NODES 50000
+#define BENCH_ROUNDS 3
+
+typedef struct {
+  const char *name;
+  void (*run)(const char *dir);
+} Benchmark;
+
+static const char *const name_prefixes[] = {
+    "", "lib", "python-", "perl-", "lib32-", "ruby-", "haskell-", "xorg-",
+    "kde-", "gst-plugins-", "rust-", "nodejs-", "texlive-", "ttf-",
+};
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec * 1000.0 + (double)ts.tv_nsec / 1e6;
+}
+
+static size_t synthetic_name(size_t i, char *buffer, size_t size) {
+  static const char letters[] = "abcdefghijklmnopqrstuvwxyz";
+  uint64_t x = (uint64_t)i * 0x9e3779b97f4a7c15ULL + 0x632be59bd9b4e019ULL;
+  const char *prefix =
+      name_prefixes[x % (sizeof(name_prefixes) / sizeof(name_prefixes[0]))];
+  char stem[12];
+  size_t stem_length = 3 + (size_t)((x >> 8) % 8);
+  for (size_t j = 0; j < stem_length; j++) {
+    stem[j] = letters[(x >> (12 + j * 5)) % 26];
+  }
+  stem[stem_length] = '\0';
+  return (size_t)snprintf(buffer, size, "%s%s%zu", prefix, stem, i);
+}
+
+static void bench_prefix_index(const char *dir) {
+  char *path = fixture_path(dir, "index.bin");
+  ArchiumIndexBuilder builder;
+  archium_index_builder_init(&builder);
+  struct stat st;
+  stat(dir, &st);
+  archium_index_builder_set_source(&builder, &st);
+  archium_index_builder_begin_repo(&builder, "core", &st);
+  for (size_t i = 0; i < BENCH_NAMES; i++) {
+    char name[64];
+    size_t length = synthetic_name(i, name, sizeof(name));
+    archium_index_builder_add(&builder, name, length);
+  }
+  int written = archium_index_builder_write(&builder, path);
+  archium_index_builder_free(&builder);
+
+  ArchiumPackageIndex index;
+  if (!written || !archium_index_open(&index, path)) {
+    fprintf(stderr, "prefix: could not build the index\n");
+    free(path);
+    return;
+  }
+
+  static const char *const prefixes[] = {"p", "py", "python-", "lib32-ab",
+                                         "xorg-q", "zz"};
+  printf("prefix lookup over %u names (us per query):\n", index.count);
+  for (size_t p = 0; p < sizeof(prefixes) / sizeof(prefixes[0]); p++) {
+    size_t length = strlen(prefixes[p]);
+    uint32_t first = 0;
+    uint32_t matches = 0;
+
+    double best_index = 0;
+    double best_scan = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      double start = now_ms();
+      for (int i = 0; i < 1000; i++) {
+        matches = archium_index_prefix_range(&index, prefixes[p], length,
+                                             &first);
+      }
+      double elapsed = (now_ms() - start) / 1000;
+      best_index = round == 0 || elapsed < best_index ? elapsed : best_index;
+
+      start = now_ms();
+      uint32_t scanned = 0;
+      for (uint32_t i = 0; i < index.count; i++) {
+        if (strncmp(archium_index_name(&index, i), prefixes[p], length) == 0) {
+          scanned++;
+        }
+      }
+      elapsed = now_ms() - start;
+      best_scan = round == 0 || elapsed < best_scan ? elapsed : best_scan;
+      if (scanned != matches) {
+        fprintf(stderr, "prefix: '%s' index %u != scan %u\n", prefixes[p],
+                matches, scanned);
+      }
+    }
+    printf("  %-10s %6u matches  index %8.2f  linear scan %8.2f\n",
+           prefixes[p], matches, best_index * 1000, best_scan * 1000);
+  }
+
+  archium_index_close(&index);
+  free(path);
+}
+
+static void bench_fuzzy(const char *dir) {
+  (void)dir;
+  size_t capacity = (size_t)BENCH_NAMES * 32;
+  char *blob = malloc(capacity);
+  if (!blob) {
+    return;
+  }
+  size_t size = 0;
+  for (size_t i = 0; i < BENCH_NAMES; i++) {
+    size += synthetic_name(i, blob + size, capacity - size) + 1;
+  }
+
+  static const char *const patterns[] = {"pyqt", "lbxcb", "xorgsrv", "fnt",
+                                         "gstplg", "q"};
+  printf("fuzzy search over %d names (ms per query):\n", BENCH_NAMES);
+  for (size_t p = 0; p < sizeof(patterns) / sizeof(patterns[0]); p++) {
+    ArchiumFuzzyResults results;
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      memset(&results, 0, sizeof(results));
+      double start = now_ms();
+      archium_fuzzy_search_blob(&results, blob, size, patterns[p],
+                                strlen(patterns[p]));
+      double elapsed = now_ms() - start;
+      best = round == 0 || elapsed < best ? elapsed : best;
+    }
+    printf("  %-10s %6.3f  (%zu kept, best '%.*s')\n", patterns[p], best,
+           results.count, results.count ? (int)results.matches[0].length : 0,
+           results.count ? results.matches[0].name : "");
+  }
+  free(blob);
+}
+
+static void bench_capture(const char *dir) {
+  char *path = fixture_path(dir, "pacman.log");
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    free(path);
+    return;
+  }
+  size_t bytes = 0;
+  for (size_t i = 0; bytes < (size_t)BENCH_LOG_MB * 1024 * 1024; i++) {
+    char name[64];
+    synthetic_name(i, name, sizeof(name));
+    int written;
+    if (i % 3 == 0) {
+      written = fprintf(fp, " %s-1.0-1-x86_64 downloading...\n", name);
+    } else {
+      written = fprintf(fp, "(%zu/%d) installing %s  [######--] %zu%%\n",
+                        i % 4000 + 1, 4000, name, i % 100);
+    }
+    bytes += written > 0 ? (size_t)written : 0;
+  }
+  fclose(fp);
+
+  int saved_batch = config.batch_mode;
+  config.batch_mode = 1;
+  const char *const argv[] = {"cat", path, NULL};
+  double best = 0;
+  size_t captured = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    ArchiumOutput output;
+    output_init(&output);
+    output.limit = 0;
+    double start = now_ms();
+    execute_argv_with_output_capture(argv, "Benchmark", &output);
+    double elapsed = now_ms() - start;
+    best = round == 0 || elapsed < best ? elapsed : best;
+    captured = output.length;
+    output_free(&output);
+  }
+  config.batch_mode = saved_batch;
+
+  printf("output capture: %.1f MB in %.1f ms (%.0f MB/s)\n",
+         (double)captured / (1024 * 1024), best,
+         (double)captured / (1024 * 1024) / (best / 1000));
+  unlink(path);
+  free(path);
+}
+
+static void bench_local_scan(const char *dir) {
+  char *local = fixture_path(dir, "local");
+  if (mkdir(local, 0755) != 0 ||
+      !fixture_generate_packages(local, BENCH_LOCAL_PACKAGES)) {
+    fprintf(stderr, "local scan: could not create the fixture\n");
+    free(local);
+    return;
+  }
+
+  size_t max_threads = archium_pool_default_threads();
+  if (max_threads < 8) {
+    max_threads = 8;
+  }
+  printf("local DB scan of %d packages (warm page cache, %ld cores):\n",
+         BENCH_LOCAL_PACKAGES, sysconf(_SC_NPROCESSORS_ONLN));
+  double serial = 0;
+  for (size_t threads = 1; threads <= max_threads;
+       threads = threads < max_threads && threads * 2 > max_threads
+                     ? max_threads
+                     : threads * 2) {
+    double best = 0;
+    for (int round = 0; round < BENCH_ROUNDS; round++) {
+      ArchiumLocalDb db;
+      double start = now_ms();
+      int ok = archium_localdb_load(&db, local, threads);
+      double elapsed = now_ms() - start;
+      best = round == 0 || elapsed < best ? elapsed : best;
+      if (ok) {
+        archium_localdb_free(&db);
+      }
+    }
+    if (threads == 1) {
+      serial = best;
+    }
+    printf("  %2zu threads %8.1f ms  %.2fx\n", threads, best, serial / best);
+  }
+  free(local);
+}
+
+static void bench_depgraph(const char *dir) {
+  (void)dir;
+  ArchiumLocalDb db;
+  archium_localdb_init(&db);
+  for (size_t i = 0; i < BENCH_GRAPH_NODES; i++) {
+    char desc[512];
+    int length = snprintf(desc, sizeof(desc),
+                          "%%NAME%%\nnode%zu\n\n%%VERSION%%\n1.%zu-1\n\n"
+                          "%%REASON%%\n%d\n\n%%DEPENDS%%\nnode%zu>=1.0\n"
+                          "node%zu\nvirt%zu\n\n%%PROVIDES%%\nvirt%zu=1\n\n"
+                          "%%OPTDEPENDS%%\nnode%zu: optional\n\n",
+                          i, i % 97, i % 50 == 0 ? 0 : 1,
+                          (i * 7 + 1) % BENCH_GRAPH_NODES,
+                          (i * 13 + 5) % BENCH_GRAPH_NODES,
+                          (i + 3) % (BENCH_GRAPH_NODES / 2), i / 2,
+                          (i * 31 + 2) % BENCH_GRAPH_NODES);
+    if (!archium_localdb_parse_desc(&db, desc, (size_t)length)) {
+      fprintf(stderr, "depgraph: could not create the fixture\n");
+      archium_localdb_free(&db);
+      return;
+    }
+  }
+
+  double best = 0;
+  uint32_t edges = 0;
+  for (int round = 0; round < BENCH_ROUNDS; round++) {
+    ArchiumDepGraph graph;
+    double start = now_ms();
+    int ok = archium_depgraph_build(&graph, &db, NULL);
+    double elapsed = now_ms() - start;
+    best = round == 0 || elapsed < best ? elapsed : best;
+    if (ok) {
+      edges = graph.edge_count;
+      archium_depgraph_free(&graph);
+    }
+  }
+  printf("dependency graph: %d nodes, %u edges built in %.1f ms\n",
+         BENCH_GRAPH_NODES, edges, best);
+  archium_localdb_free(&db);
+}
+
+static const Benchmark benchmarks[] = {
+    {"prefix", bench_prefix_index},
+    {"fuzzy", bench_fuzzy},
+    {"capture", bench_capture},
+    {"localdb", bench_local_scan},
+    {"depgraph", bench_depgraph},
+};
+
+int main(int argc, char *argv[]) {
+  char *dir = fixture_dir();
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  for (size_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++) {
+    int selected = argc < 2;
+    for (int arg = 1; arg < argc; arg++) {
+      if (strcmp(argv[arg], benchmarks[i].name) == 0) {
+        selected = 1;
+      }
+    }
+    if (selected) {
+      benchmarks[i].run(dir);
+    }
+  }
+
+  fixture_remove(dir);
+  free(dir);
+  return 0;
+}
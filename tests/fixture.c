@@ -0,0 +1,259 @@
+#include <dirent.h>
+#include <zlib.h>
+
+#include "test.h"
+
+#define TAR_BLOCK_SIZE 512
+
+int test_checks = 0;
+int test_failures = 0;
+
+char *fixture_dir(void) {
+  const char *tmp = getenv("TMPDIR");
+  char template[COMMAND_BUFFER_SIZE];
+  snprintf(template, sizeof(template), "%s/archium-test-XXXXXX",
+           tmp && *tmp ? tmp : "/tmp");
+  char *dir = mkdtemp(template);
+  return dir ? strdup(dir) : NULL;
+}
+
+void fixture_remove(const char *dir) {
+  DIR *handle = dir ? opendir(dir) : NULL;
+  if (!handle) {
+    if (dir) {
+      remove(dir);
+    }
+    return;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(handle)) != NULL) {
+    if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0) {
+      continue;
+    }
+    char *path = fixture_path(dir, entry->d_name);
+    struct stat st;
+    if (path && lstat(path, &st) == 0) {
+      if (S_ISDIR(st.st_mode)) {
+        fixture_remove(path);
+      } else {
+        unlink(path);
+      }
+    }
+    free(path);
+  }
+  closedir(handle);
+  rmdir(dir);
+}
+
+char *fixture_path(const char *dir, const char *name) {
+  size_t length = strlen(dir) + strlen(name) + 2;
+  char *path = malloc(length);
+  if (path) {
+    snprintf(path, length, "%s/%s", dir, name);
+  }
+  return path;
+}
+
+int fixture_write(const char *path, const char *content) {
+  FILE *fp = fopen(path, "w");
+  if (!fp) {
+    return 0;
+  }
+  int ok = fputs(content, fp) >= 0;
+  return fclose(fp) == 0 && ok;
+}
+
+int fixture_package(const char *dir, const char *name, const char *version,
+                    int reason, const char *fields) {
+  char path[COMMAND_BUFFER_SIZE];
+  snprintf(path, sizeof(path), "%s/%s-%s", dir, name, version);
+  if (mkdir(path, 0755) != 0) {
+    return 0;
+  }
+
+  char desc[MEDIUM_BUFFER_SIZE];
+  snprintf(desc, sizeof(desc),
+           "%%NAME%%\n%s\n\n%%VERSION%%\n%s\n\n%%REASON%%\n%d\n\n%s", name,
+           version, reason, fields ? fields : "");
+  strncat(path, "/desc", sizeof(path) - strlen(path) - 1);
+  return fixture_write(path, desc);
+}
+
+static void tar_header(char *block, const char *name, size_t size,
+                       char type) {
+  memset(block, 0, TAR_BLOCK_SIZE);
+  snprintf(block, 100, "%s", name);
+  snprintf(block + 100, 8, "%07o", type == '5' ? 0755 : 0644);
+  snprintf(block + 108, 8, "%07o", 0);
+  snprintf(block + 116, 8, "%07o", 0);
+  snprintf(block + 124, 12, "%011zo", size);
+  snprintf(block + 136, 12, "%011o", 0);
+  block[156] = type;
+  memcpy(block + 257, "ustar", 6);
+  memcpy(block + 263, "00", 2);
+
+  memset(block + 148, ' ', 8);
+  unsigned int sum = 0;
+  for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+    sum += (unsigned char)block[i];
+  }
+  snprintf(block + 148, 8, "%06o", sum);
+  block[155] = ' ';
+}
+
+static int tar_member(gzFile gz, const char *name, const char *data,
+                      size_t size, char type) {
+  char block[TAR_BLOCK_SIZE];
+  tar_header(block, name, size, type);
+  if (gzwrite(gz, block, TAR_BLOCK_SIZE) != TAR_BLOCK_SIZE) {
+    return 0;
+  }
+
+  for (size_t offset = 0; offset < size; offset += TAR_BLOCK_SIZE) {
+    size_t chunk = size - offset < TAR_BLOCK_SIZE ? size - offset
+                                                  : TAR_BLOCK_SIZE;
+    memset(block, 0, TAR_BLOCK_SIZE);
+    memcpy(block, data + offset, chunk);
+    if (gzwrite(gz, block, TAR_BLOCK_SIZE) != TAR_BLOCK_SIZE) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Writes a gzip-compressed ustar archive shaped like a pacman sync
+ * database. Member paths of 100 bytes or more get a GNU long-name record,
+ * as bsdtar does for very long package names.
+ */
+int fixture_sync_db(const char *path, const FixtureEntry *entries,
+                    size_t count) {
+  gzFile gz = gzopen(path, "wb");
+  if (!gz) {
+    return 0;
+  }
+
+  int ok = 1;
+  for (size_t i = 0; ok && i < count; i++) {
+    size_t name_length = strlen(entries[i].path);
+    if (name_length >= 100) {
+      ok = tar_member(gz, "././@LongLink", entries[i].path, name_length + 1,
+                      'L');
+    }
+    ok = ok && tar_member(gz, entries[i].path, entries[i].content,
+                          strlen(entries[i].content), '0');
+  }
+
+  char zero[TAR_BLOCK_SIZE * 2];
+  memset(zero, 0, sizeof(zero));
+  ok = ok && gzwrite(gz, zero, sizeof(zero)) == (int)sizeof(zero);
+  return gzclose(gz) == Z_OK && ok;
+}
+
+/*
+ * Fills dir with count synthetic packages. Every package depends on its
+ * predecessor and every tenth one provides a virtual name, so the lists are
+ * not all empty.
+ */
+int fixture_generate_packages(const char *dir, size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    char name[64];
+    char fields[256];
+    snprintf(name, sizeof(name), "pkg%06zu", i);
+    int used = snprintf(fields, sizeof(fields), "%%SIZE%%\n%zu\n\n",
+                        i * 1024);
+    if (i > 0) {
+      used += snprintf(fields + used, sizeof(fields) - (size_t)used,
+                       "%%DEPENDS%%\npkg%06zu>=1.0\nglibc\n\n", i - 1);
+    }
+    if (i % 10 == 0) {
+      snprintf(fields + used, sizeof(fields) - (size_t)used,
+               "%%PROVIDES%%\nvirtual%zu=1.0\n\n", i / 10);
+    }
+    if (!fixture_package(dir, name, "1.0-1", (int)(i % 2), fields)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+/*
+ * Waits long enough for the filesystem's coarse timestamp clock to advance,
+ * so a rewrite right after a snapshot still gets a different ctime.
+ */
+void fixture_tick(void) {
+  struct timespec delay = {0, 20 * 1000 * 1000};
+  nanosleep(&delay, NULL);
+}
+
+static int lists_equal(const ArchiumLocalDb *a, const ArchiumLocalDb *b,
+                       uint32_t index) {
+  for (int list = 0; list < ARCHIUM_LOCALDB_LIST_COUNT; list++) {
+    uint32_t a_length = 0;
+    uint32_t b_length = 0;
+    const uint32_t *a_items = archium_localdb_list(a, index, list, &a_length);
+    const uint32_t *b_items = archium_localdb_list(b, index, list, &b_length);
+    if (a_length != b_length) {
+      return 0;
+    }
+    for (uint32_t i = 0; i < a_length; i++) {
+      if (strcmp(archium_localdb_string(a, a_items[i]),
+                 archium_localdb_string(b, b_items[i])) != 0) {
+        return 0;
+      }
+    }
+  }
+  return 1;
+}
+
+int localdb_equal(const ArchiumLocalDb *a, const ArchiumLocalDb *b) {
+  if (a->count != b->count) {
+    return 0;
+  }
+  for (uint32_t i = 0; i < a->count; i++) {
+    if (strcmp(archium_localdb_name(a, i), archium_localdb_name(b, i)) != 0 ||
+        strcmp(archium_localdb_version(a, i),
+               archium_localdb_version(b, i)) != 0 ||
+        a->reason[i] != b->reason[i] || a->size[i] != b->size[i] ||
+        a->install_date[i] != b->install_date[i] || !lists_equal(a, b, i)) {
+      return 0;
+    }
+  }
+  return 1;
+}
+
+int capture_stdout_begin(void) {
+  fflush(stdout);
+  int saved = dup(STDOUT_FILENO);
+  FILE *sink = tmpfile();
+  if (saved < 0 || !sink) {
+    return -1;
+  }
+  dup2(fileno(sink), STDOUT_FILENO);
+  fclose(sink);
+  return saved;
+}
+
+char *capture_stdout_end(int saved) {
+  fflush(stdout);
+  off_t size = lseek(STDOUT_FILENO, 0, SEEK_END);
+  char *text = malloc(size > 0 ? (size_t)size + 1 : 1);
+  if (text) {
+    ssize_t got = size > 0 ? pread(STDOUT_FILENO, text, (size_t)size, 0) : 0;
+    text[got > 0 ? got : 0] = '\0';
+  }
+  dup2(saved, STDOUT_FILENO);
+  close(saved);
+  return text;
+}
+
+int test_finish(const char *suite) {
+  if (test_failures > 0) {
+    fprintf(stderr, "%s: %d of %d checks failed\n", suite, test_failures,
+            test_checks);
+    return 1;
+  }
+  printf("%s: %d checks passed\n", suite, test_checks);
+  return 0;
+}
@@ -0,0 +1,74 @@
+#ifndef ARCHIUM_TEST_H
+#define ARCHIUM_TEST_H
+
+#include "archium.h"
+
+/*
+ * Minimal assertion helpers for the suites under tests/. Every suite is a
+ * standalone program linked against the archium objects (minus main.o); it
+ * builds its fixtures in a temporary directory and exits non-zero when any
+ * CHECK fails.
+ */
+
+extern int test_checks;
+extern int test_failures;
+
+#define CHECK(condition)                                                 \
+  do {                                                                   \
+    test_checks++;                                                       \
+    if (!(condition)) {                                                  \
+      test_failures++;                                                   \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,   \
+              #condition);                                               \
+    }                                                                    \
+  } while (0)
+
+#define CHECK_INT(actual, expected)                                        \
+  do {                                                                     \
+    long long check_actual = (long long)(actual);                          \
+    long long check_expected = (long long)(expected);                      \
+    test_checks++;                                                         \
+    if (check_actual != check_expected) {                                  \
+      test_failures++;                                                     \
+      fprintf(stderr, "%s:%d: %s == %lld, expected %lld\n", __FILE__,      \
+              __LINE__, #actual, check_actual, check_expected);            \
+    }                                                                      \
+  } while (0)
+
+#define CHECK_STR(actual, expected)                                        \
+  do {                                                                     \
+    const char *check_actual = (actual);                                   \
+    const char *check_expected = (expected);                               \
+    test_checks++;                                                         \
+    if (!check_actual || strcmp(check_actual, check_expected) != 0) {      \
+      test_failures++;                                                     \
+      fprintf(stderr, "%s:%d: %s == \"%s\", expected \"%s\"\n", __FILE__,  \
+              __LINE__, #actual, check_actual ? check_actual : "(null)",   \
+              check_expected);                                             \
+    }                                                                      \
+  } while (0)
+
+typedef struct {
+  const char *path;
+  const char *content;
+} FixtureEntry;
+
+char *fixture_dir(void);
+void fixture_remove(const char *dir);
+char *fixture_path(const char *dir, const char *name);
+int fixture_write(const char *path, const char *content);
+int fixture_package(const char *dir, const char *name, const char *version,
+                    int reason, const char *fields);
+int fixture_sync_db(const char *path, const FixtureEntry *entries,
+                    size_t count);
+int fixture_generate_packages(const char *dir, size_t count);
+void fixture_tick(void);
+
+int localdb_equal(const ArchiumLocalDb *a, const ArchiumLocalDb *b);
+
+int capture_stdout_begin(void);
+char *capture_stdout_end(int saved);
+
+int test_finish(const char *suite);
+
+#endif
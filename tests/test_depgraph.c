@@ -0,0 +1,193 @@
+#include "test.h"
+
+#define CYCLE " \033[1;33m(cycle)\033[0m"
+#define NOT_FOUND " \033[1;31m(not found)\033[0m"
+
+static void test_vercmp(void) {
+  static const struct {
+    const char *a;
+    const char *b;
+    int expected;
+  } cases[] = {
+      {"1.0", "1.0", 0},
+      {"1.0", "1.1", -1},
+      {"1.1", "1.0", 1},
+      {"1.0", "1.0.1", -1},
+      {"1.0a", "1.0", -1},
+      {"1.0alpha", "1.0beta", -1},
+      {"1.10", "1.9", 1},
+      {"1.0-1", "1.0-2", -1},
+      {"1.0-1", "1.0", 0},
+      {"1:1.0", "2.0", 1},
+      {"0:1.0", "1.0", 0},
+      {"1.0.0", "1.0", 1},
+      {"2.0_1", "2.0.1", 0},
+      {"1.0+r12", "1.0+r9", 1},
+  };
+
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+    int result = archium_vercmp(cases[i].a, cases[i].b);
+    int sign = (result > 0) - (result < 0);
+    if (sign != cases[i].expected) {
+      fprintf(stderr, "vercmp(%s, %s) == %d, expected %d\n", cases[i].a,
+              cases[i].b, result, cases[i].expected);
+    }
+    CHECK_INT(sign, cases[i].expected);
+
+    result = archium_vercmp(cases[i].b, cases[i].a);
+    CHECK_INT((result > 0) - (result < 0), -cases[i].expected);
+  }
+}
+
+static void add_package(ArchiumLocalDb *db, const char *desc) {
+  CHECK_INT(archium_localdb_parse_desc(db, desc, strlen(desc)), 1);
+}
+
+/*
+ * app needs libfoo (which needs app back), sh (provided by bash), a package
+ * that does not exist and a versioned libv that two packages provide.
+ */
+static void build_local(ArchiumLocalDb *db) {
+  archium_localdb_init(db);
+  add_package(db, "%NAME%\napp\n\n%VERSION%\n1.0-1\n\n%REASON%\n0\n\n"
+                  "%DEPENDS%\nlibfoo\nsh\nghost>=1\nlibv>=3\n\n"
+                  "%OPTDEPENDS%\noptlib: extra features\n\n"
+                  "%MAKEDEPENDS%\nbuildtool\n\n");
+  add_package(db, "%NAME%\nlibfoo\n\n%VERSION%\n2.0-1\n\n%REASON%\n1\n\n"
+                  "%DEPENDS%\napp\n\n");
+  add_package(db, "%NAME%\nbash\n\n%VERSION%\n5.2-1\n\n%REASON%\n1\n\n"
+                  "%PROVIDES%\nsh\n\n");
+  add_package(db, "%NAME%\nlibv-two\n\n%VERSION%\n2.0-1\n\n%REASON%\n1\n\n"
+                  "%PROVIDES%\nlibv=2.0\n\n");
+  add_package(db, "%NAME%\nlibv-three\n\n%VERSION%\n3.0-1\n\n%REASON%\n1\n\n"
+                  "%PROVIDES%\nlibv=3.1\n\n");
+  add_package(db, "%NAME%\noptlib\n\n%VERSION%\n1-1\n\n%REASON%\n1\n\n");
+  add_package(db, "%NAME%\nbuildtool\n\n%VERSION%\n1-1\n\n%REASON%\n1\n\n");
+}
+
+static char *tree_text(const ArchiumDepGraph *graph, const char *root,
+                       int reverse, int max_depth) {
+  int saved = capture_stdout_begin();
+  CHECK(saved >= 0);
+  archium_depgraph_print_tree(graph, archium_depgraph_find(graph, root),
+                              reverse, max_depth);
+  return capture_stdout_end(saved);
+}
+
+static int is_orphan(const ArchiumDepGraph *graph, const uint32_t *orphans,
+                     uint32_t count, const char *name) {
+  uint32_t node = archium_depgraph_find(graph, name);
+  for (uint32_t i = 0; i < count; i++) {
+    if (orphans[i] == node) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void test_graph(void) {
+  ArchiumLocalDb local;
+  ArchiumDepGraph graph;
+  build_local(&local);
+  CHECK_INT(archium_depgraph_build(&graph, &local, NULL), 1);
+  CHECK_INT(graph.node_count, 7);
+  CHECK(archium_depgraph_find(&graph, "ghost") == ARCHIUM_DEPGRAPH_NONE);
+
+  uint32_t bash = archium_depgraph_find(&graph, "bash");
+  CHECK(bash != ARCHIUM_DEPGRAPH_NONE);
+  CHECK_STR(archium_depgraph_string(&graph, graph.node_name[bash]), "bash");
+
+  char *text = tree_text(&graph, "app", 0, -1);
+  CHECK_STR(text, "app\n"
+                  "├─libfoo\n"
+                  "│ └─app" CYCLE "\n"
+                  "├─bash provides sh\n"
+                  "├─ghost" NOT_FOUND "\n"
+                  "└─libv-three provides libv\n");
+  free(text);
+
+  text = tree_text(&graph, "app", 0, 1);
+  CHECK_STR(text, "app\n"
+                  "├─libfoo\n"
+                  "├─bash provides sh\n"
+                  "├─ghost" NOT_FOUND "\n"
+                  "└─libv-three provides libv\n");
+  free(text);
+
+  text = tree_text(&graph, "bash", 1, -1);
+  CHECK_STR(text, "bash\n"
+                  "└─app\n"
+                  "  └─libfoo\n"
+                  "    └─app" CYCLE "\n");
+  free(text);
+
+  text = tree_text(&graph, "libv-two", 1, -1);
+  CHECK_STR(text, "libv-two\n");
+  free(text);
+
+  uint32_t *orphans = NULL;
+  uint32_t count = 0;
+  CHECK_INT(archium_depgraph_find_orphans(&graph, 0, &orphans, &count), 1);
+  CHECK_INT(count, 3);
+  CHECK(is_orphan(&graph, orphans, count, "libv-two"));
+  CHECK(is_orphan(&graph, orphans, count, "optlib"));
+  CHECK(is_orphan(&graph, orphans, count, "buildtool"));
+  free(orphans);
+
+  CHECK_INT(archium_depgraph_find_orphans(
+                &graph, ARCHIUM_ORPHAN_KEEP_OPTIONAL | ARCHIUM_ORPHAN_KEEP_MAKE,
+                &orphans, &count),
+            1);
+  CHECK_INT(count, 1);
+  CHECK(is_orphan(&graph, orphans, count, "libv-two"));
+  free(orphans);
+
+  archium_depgraph_free(&graph);
+  archium_localdb_free(&local);
+}
+
+/*
+ * ufw needs "iptables"; the installed iptables-nft provides it while the repo
+ * also carries a package literally named iptables. The installed provider
+ * must win, or iptables-nft is reported as an orphan.
+ */
+static void test_installed_provider_preferred(void) {
+  ArchiumLocalDb local;
+  ArchiumLocalDb sync;
+  archium_localdb_init(&local);
+  archium_localdb_init(&sync);
+  add_package(&local, "%NAME%\nufw\n\n%VERSION%\n0.36-1\n\n%REASON%\n0\n\n"
+                      "%DEPENDS%\niptables>=1.8\n\n");
+  add_package(&local, "%NAME%\niptables-nft\n\n%VERSION%\n1:1.8.10-1\n\n"
+                      "%REASON%\n1\n\n%PROVIDES%\niptables=1:1.8.10\n\n");
+  add_package(&sync, "%NAME%\niptables\n\n%VERSION%\n1:1.8.10-1\n\n");
+  add_package(&sync, "%NAME%\niptables-nft\n\n%VERSION%\n1:1.8.10-1\n\n"
+                     "%PROVIDES%\niptables=1:1.8.10\n\n");
+  add_package(&sync, "%NAME%\nufw\n\n%VERSION%\n0.36-1\n\n"
+                     "%DEPENDS%\niptables>=1.8\n\n");
+
+  ArchiumDepGraph graph;
+  CHECK_INT(archium_depgraph_build(&graph, &local, &sync), 1);
+  CHECK_INT(graph.node_count, 3);
+
+  char *text = tree_text(&graph, "ufw", 0, -1);
+  CHECK_STR(text, "ufw\n└─iptables-nft provides iptables\n");
+  free(text);
+
+  uint32_t *orphans = NULL;
+  uint32_t count = 0;
+  CHECK_INT(archium_depgraph_find_orphans(&graph, 0, &orphans, &count), 1);
+  CHECK_INT(count, 0);
+  free(orphans);
+
+  archium_depgraph_free(&graph);
+  archium_localdb_free(&sync);
+  archium_localdb_free(&local);
+}
+
+int main(void) {
+  test_vercmp();
+  test_graph();
+  test_installed_provider_preferred();
+  return test_finish("depgraph");
+}
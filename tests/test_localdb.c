@@ -0,0 +1,193 @@
+#include "test.h"
+
+static void test_parse_desc(void) {
+  const char desc[] = "%NAME%\nvim\n\n"
+                      "%VERSION%\n9.1.0-1\n\n"
+                      "%REASON%\n1\n\n"
+                      "%SIZE%\n4096\n\n"
+                      "%INSTALLDATE%\n1700000000\n\n"
+                      "%DEPENDS%\nglibc\nacl\nlibgcrypt>=1.10\n\n"
+                      "%OPTDEPENDS%\npython: Python scripting\n\n"
+                      "%PROVIDES%\nxxd=9.1\n\n"
+                      "%UNKNOWN%\nignored\n\n";
+
+  ArchiumLocalDb db;
+  archium_localdb_init(&db);
+  CHECK_INT(archium_localdb_parse_desc(&db, desc, sizeof(desc) - 1), 1);
+  CHECK_INT(db.count, 1);
+  CHECK_STR(archium_localdb_name(&db, 0), "vim");
+  CHECK_STR(archium_localdb_version(&db, 0), "9.1.0-1");
+  CHECK_INT(db.reason[0], ARCHIUM_LOCALDB_REASON_DEPEND);
+  CHECK_INT(db.size[0], 4096);
+  CHECK_INT(db.install_date[0], 1700000000);
+
+  uint32_t length = 0;
+  const uint32_t *items =
+      archium_localdb_list(&db, 0, ARCHIUM_LOCALDB_DEPENDS, &length);
+  CHECK_INT(length, 3);
+  CHECK(items && strcmp(archium_localdb_string(&db, items[2]),
+                        "libgcrypt>=1.10") == 0);
+  items = archium_localdb_list(&db, 0, ARCHIUM_LOCALDB_OPTDEPENDS, &length);
+  CHECK(items && length == 1 &&
+        strcmp(archium_localdb_string(&db, items[0]),
+               "python: Python scripting") == 0);
+  items = archium_localdb_list(&db, 0, ARCHIUM_LOCALDB_MAKEDEPENDS, &length);
+  CHECK(items == NULL && length == 0);
+
+  const char nameless[] = "%VERSION%\n1.0\n\n%DEPENDS%\nglibc\n";
+  uint32_t strings = db.strings_size;
+  CHECK_INT(archium_localdb_parse_desc(&db, nameless, sizeof(nameless) - 1),
+            1);
+  CHECK_INT(db.count, 1);
+  CHECK_INT(db.strings_size, strings);
+
+  archium_localdb_free(&db);
+}
+
+static void write_packages(const char *dir) {
+  CHECK(mkdir(dir, 0755) == 0);
+  CHECK(fixture_package(dir, "zlib", "1:1.3-1", 1, NULL));
+  CHECK(fixture_package(dir, "bash", "5.2-1", 0,
+                        "%DEPENDS%\nreadline\nglibc\n\n"));
+  CHECK(fixture_package(dir, "readline", "8.2-1", 1,
+                        "%PROVIDES%\nlibreadline.so=8-64\n\n"));
+
+  char *version = fixture_path(dir, "ALPM_DB_VERSION");
+  CHECK(fixture_write(version, "9\n"));
+  free(version);
+}
+
+static void test_load(const char *local) {
+  ArchiumLocalDb db;
+  CHECK_INT(archium_localdb_load(&db, local, 1), 1);
+  CHECK_INT(db.count, 3);
+  CHECK_STR(archium_localdb_name(&db, 0), "bash");
+  CHECK_STR(archium_localdb_name(&db, 2), "zlib");
+
+  int64_t index = archium_localdb_find(&db, "readline", 8);
+  CHECK_INT(index, 1);
+  CHECK_INT(archium_localdb_find(&db, "readlin", 7), -1);
+  CHECK_INT(archium_localdb_find(&db, "missing", 7), -1);
+  CHECK_STR(archium_localdb_version(&db, 2), "1:1.3-1");
+  archium_localdb_free(&db);
+
+  ArchiumLocalDb missing;
+  CHECK_INT(archium_localdb_load(&missing, "/nonexistent/archium", 1), 0);
+}
+
+static void test_snapshot_round_trip(const char *local, const char *snapshot) {
+  ArchiumLocalDb loaded;
+  ArchiumLocalDb mapped;
+  ArchiumLocalDbSource source;
+  CHECK_INT(archium_localdb_load(&loaded, local, 1), 1);
+  CHECK_INT(archium_localdb_stat_source(local, &source), 1);
+  CHECK_INT(source.alpm_db_version, 9);
+
+  CHECK_INT(archium_localdb_snapshot_write(&loaded, snapshot, &source), 1);
+  CHECK_INT(archium_localdb_snapshot_open(&mapped, snapshot, &source), 1);
+  CHECK(mapped.map != NULL);
+  CHECK(localdb_equal(&loaded, &mapped));
+  CHECK_INT(archium_localdb_find(&mapped, "zlib", 4), 2);
+
+  archium_localdb_free(&mapped);
+  archium_localdb_free(&loaded);
+}
+
+static int snapshot_is_current(const char *local, const char *snapshot) {
+  ArchiumLocalDbSource source;
+  ArchiumLocalDb db;
+  if (!archium_localdb_stat_source(local, &source) ||
+      !archium_localdb_snapshot_open(&db, snapshot, &source)) {
+    return 0;
+  }
+  archium_localdb_free(&db);
+  return 1;
+}
+
+static void refresh_snapshot(const char *local, const char *snapshot) {
+  ArchiumLocalDb db;
+  ArchiumLocalDbSource source;
+  CHECK_INT(archium_localdb_load(&db, local, 1), 1);
+  CHECK_INT(archium_localdb_stat_source(local, &source), 1);
+  CHECK_INT(archium_localdb_snapshot_write(&db, snapshot, &source), 1);
+  archium_localdb_free(&db);
+  CHECK(snapshot_is_current(local, snapshot));
+}
+
+static void test_snapshot_invalidation(const char *local,
+                                       const char *snapshot) {
+  refresh_snapshot(local, snapshot);
+
+  fixture_tick();
+  char *desc = fixture_path(local, "zlib-1:1.3-1/desc");
+  CHECK(fixture_write(desc, "%NAME%\nzlib\n\n%VERSION%\n1:1.3-1\n\n"
+                            "%REASON%\n0\n\n"));
+  CHECK(!snapshot_is_current(local, snapshot));
+  free(desc);
+
+  refresh_snapshot(local, snapshot);
+  char *version = fixture_path(local, "ALPM_DB_VERSION");
+  CHECK(fixture_write(version, "10\n"));
+  CHECK(!snapshot_is_current(local, snapshot));
+  free(version);
+
+  refresh_snapshot(local, snapshot);
+  fixture_tick();
+  CHECK(fixture_package(local, "acl", "2.3-1", 1, NULL));
+  CHECK(!snapshot_is_current(local, snapshot));
+
+  refresh_snapshot(local, snapshot);
+  CHECK(fixture_write(snapshot, "ARCHLDB"));
+  CHECK(!snapshot_is_current(local, snapshot));
+}
+
+static void test_open_cached(const char *local, const char *snapshot) {
+  unlink(snapshot);
+
+  ArchiumLocalDb db;
+  CHECK_INT(archium_localdb_open_cached(&db, local, snapshot, 1), 1);
+  CHECK(db.map == NULL);
+  CHECK(access(snapshot, R_OK) == 0);
+  archium_localdb_free(&db);
+
+  CHECK_INT(archium_localdb_open_cached(&db, local, snapshot, 1), 1);
+  CHECK(db.map != NULL);
+  int64_t zlib = archium_localdb_find(&db, "zlib", 4);
+  CHECK(zlib >= 0 && db.reason[zlib] == ARCHIUM_LOCALDB_REASON_EXPLICIT);
+  archium_localdb_free(&db);
+
+  fixture_tick();
+  char *desc = fixture_path(local, "zlib-1:1.3-1/desc");
+  CHECK(fixture_write(desc, "%NAME%\nzlib\n\n%VERSION%\n1:1.3-1\n\n"
+                            "%REASON%\n1\n\n"));
+  free(desc);
+
+  CHECK_INT(archium_localdb_open_cached(&db, local, snapshot, 1), 1);
+  CHECK(db.map == NULL);
+  zlib = archium_localdb_find(&db, "zlib", 4);
+  CHECK(zlib >= 0 && db.reason[zlib] == ARCHIUM_LOCALDB_REASON_DEPEND);
+  archium_localdb_free(&db);
+}
+
+int main(void) {
+  char *dir = fixture_dir();
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+  char *local = fixture_path(dir, "local");
+  char *snapshot = fixture_path(dir, ARCHIUM_LOCALDB_SNAPSHOT_FILE);
+
+  test_parse_desc();
+  write_packages(local);
+  test_load(local);
+  test_snapshot_round_trip(local, snapshot);
+  test_snapshot_invalidation(local, snapshot);
+  test_open_cached(local, snapshot);
+
+  fixture_remove(dir);
+  free(snapshot);
+  free(local);
+  free(dir);
+  return test_finish("localdb");
+}
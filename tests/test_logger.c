@@ -0,0 +1,123 @@
+#include <fcntl.h>
+#include <sys/wait.h>
+
+#include "test.h"
+
+#define LOGGED_LINES 200
+
+static char *read_file(const char *path) {
+  FILE *fp = fopen(path, "r");
+  if (!fp) {
+    return NULL;
+  }
+  fseek(fp, 0, SEEK_END);
+  long size = ftell(fp);
+  rewind(fp);
+  char *text = malloc(size > 0 ? (size_t)size + 1 : 1);
+  size_t got = text && size > 0 ? fread(text, 1, (size_t)size, fp) : 0;
+  if (text) {
+    text[got] = '\0';
+  }
+  fclose(fp);
+  return text;
+}
+
+/*
+ * Logs through the normal log_action path and then dies on SIGTERM, as the
+ * REPL does when interrupted. Nothing calls exit(), so only the signal
+ * handler can get the queued lines to disk.
+ */
+static void log_then_terminate(const char *home, int lines) {
+  int null_fd = open("/dev/null", O_WRONLY);
+  if (null_fd >= 0) {
+    dup2(null_fd, STDOUT_FILENO);
+    close(null_fd);
+  }
+
+  setenv("HOME", home, 1);
+  config.verbose = 1;
+  signal(SIGTERM, handle_signal);
+
+  for (int i = 0; i < lines; i++) {
+    char message[64];
+    snprintf(message, sizeof(message), "install pkg%03d", i);
+    log_action(message);
+  }
+  kill(getpid(), SIGTERM);
+  _exit(3);
+}
+
+static int line_has_timestamp(const char *line, time_t before, time_t after) {
+  for (time_t t = before; t <= after; t++) {
+    struct tm local;
+    char expected[64];
+    localtime_r(&t, &local);
+    strftime(expected, sizeof(expected), "[%a %b %e %H:%M:%S %Y] [ACTION] ",
+             &local);
+    if (strncmp(line, expected, strlen(expected)) == 0) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void test_signal_flush(const char *dir, int lines) {
+  char name[32];
+  snprintf(name, sizeof(name), "home%d", lines);
+  char *home = fixture_path(dir, name);
+  CHECK(mkdir(home, 0755) == 0);
+
+  time_t before = time(NULL);
+  fflush(NULL);
+  pid_t pid = fork();
+  if (pid == 0) {
+    log_then_terminate(home, lines);
+  }
+
+  int status = 0;
+  CHECK(pid > 0 && waitpid(pid, &status, 0) == pid);
+  CHECK(WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS);
+  time_t after = time(NULL);
+
+  char *log_path = fixture_path(home, ".config/archium/archium.log");
+  char *text = read_file(log_path);
+  CHECK(text != NULL);
+
+  int missing = 0;
+  int bad_timestamps = 0;
+  for (int i = 0; text && i < lines; i++) {
+    char message[64];
+    snprintf(message, sizeof(message), "] [ACTION] install pkg%03d\n", i);
+    if (!strstr(text, message)) {
+      missing++;
+    }
+  }
+  for (const char *line = text; line && *line;) {
+    if (!line_has_timestamp(line, before, after)) {
+      bad_timestamps++;
+    }
+    const char *newline = strchr(line, '\n');
+    line = newline ? newline + 1 : line + strlen(line);
+  }
+  CHECK_INT(missing, 0);
+  CHECK_INT(bad_timestamps, 0);
+
+  free(text);
+  free(log_path);
+  free(home);
+}
+
+int main(void) {
+  char *dir = fixture_dir();
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  test_signal_flush(dir, 1);
+  test_signal_flush(dir, LOGGED_LINES);
+
+  fixture_remove(dir);
+  free(dir);
+  return test_finish("logger");
+}
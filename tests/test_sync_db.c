@@ -0,0 +1,139 @@
+#include "test.h"
+
+typedef struct {
+  char text[MEDIUM_BUFFER_SIZE];
+  int count;
+} NameList;
+
+static int collect_name(const char *name, size_t length, void *user_data) {
+  NameList *list = user_data;
+  size_t used = strlen(list->text);
+  snprintf(list->text + used, sizeof(list->text) - used, "%s%.*s",
+           used ? " " : "", (int)length, name);
+  list->count++;
+  return 1;
+}
+
+static void test_desc_field(void) {
+  const char desc[] =
+      "%NAME%\nvim\n\n%VERSION%\n9.1-1\n\n%DEPENDS%\nglibc\nacl\n\n";
+  size_t length = 0;
+
+  const char *value =
+      archium_desc_field(desc, sizeof(desc) - 1, "VERSION", &length);
+  CHECK(value != NULL);
+  CHECK_INT(length, 5);
+  CHECK(value && strncmp(value, "9.1-1", length) == 0);
+
+  value = archium_desc_field(desc, sizeof(desc) - 1, "DEPENDS", &length);
+  CHECK(value && length == 9 && strncmp(value, "glibc\nacl", length) == 0);
+
+  CHECK(archium_desc_field(desc, sizeof(desc) - 1, "PROVIDES", &length) ==
+        NULL);
+  CHECK(archium_desc_field(desc, sizeof(desc) - 1, "NAM", &length) == NULL);
+}
+
+static void test_gzip_database(const char *dir) {
+  char long_name[160];
+  snprintf(long_name, sizeof(long_name), "%0120d-1.0-1/desc", 0);
+  const FixtureEntry entries[] = {
+      {"bash-5.2-1/desc", "%NAME%\nbash\n\n%VERSION%\n5.2-1\n"},
+      {"bash-5.2-1/files", "%FILES%\nusr/bin/bash\n"},
+      {"glibc-2.39-1/desc", "%FILENAME%\nglibc.pkg\n\n%NAME%\nglibc\n"},
+      {long_name, "%NAME%\nlong-package-name\n"},
+      {"nameless-1/desc", "%VERSION%\n1\n"},
+  };
+
+  char *path = fixture_path(dir, "core.db");
+  CHECK(fixture_sync_db(path, entries, sizeof(entries) / sizeof(entries[0])));
+
+  NameList names = {"", 0};
+  CHECK_INT(archium_syncdb_read_names(path, collect_name, &names), 1);
+  CHECK_STR(names.text, "bash glibc long-package-name");
+  CHECK_INT(names.count, 3);
+  free(path);
+}
+
+static void test_truncated_database(const char *dir) {
+  char *good = fixture_path(dir, "core.db");
+  char *bad = fixture_path(dir, "truncated.db");
+
+  FILE *in = fopen(good, "rb");
+  FILE *out = fopen(bad, "wb");
+  CHECK(in && out);
+  char buffer[64];
+  size_t got = in ? fread(buffer, 1, sizeof(buffer), in) : 0;
+  if (out) {
+    fwrite(buffer, 1, got, out);
+    fclose(out);
+  }
+  if (in) {
+    fclose(in);
+  }
+
+  NameList names = {"", 0};
+  CHECK_INT(archium_syncdb_read_names(bad, collect_name, &names), 0);
+  free(good);
+  free(bad);
+}
+
+static void test_missing_decompressor(const char *dir) {
+  char *path = fixture_path(dir, "extra.db.zst");
+  CHECK(fixture_write(path, "\x28\xb5\x2f\xfd not really zstd"));
+
+  const char *saved = getenv("PATH");
+  char *saved_path = saved ? strdup(saved) : NULL;
+  setenv("PATH", dir, 1);
+
+  NameList names = {"", 0};
+  CHECK_INT(archium_syncdb_read_names(path, collect_name, &names), 0);
+  CHECK_INT(names.count, 0);
+
+  if (saved_path) {
+    setenv("PATH", saved_path, 1);
+    free(saved_path);
+  }
+  free(path);
+}
+
+static void test_read_all(const char *dir) {
+  char *sync = fixture_path(dir, "sync");
+  CHECK(mkdir(sync, 0755) == 0);
+
+  const FixtureEntry core[] = {{"a-1-1/desc", "%NAME%\na\n"}};
+  const FixtureEntry extra[] = {{"b-1-1/desc", "%NAME%\nb\n"},
+                                {"c-1-1/desc", "%NAME%\nc\n"}};
+  char *core_path = fixture_path(sync, "core.db");
+  char *extra_path = fixture_path(sync, "extra.db");
+  char *other_path = fixture_path(sync, "core.files");
+  CHECK(fixture_sync_db(core_path, core, 1));
+  CHECK(fixture_sync_db(extra_path, extra, 2));
+  CHECK(fixture_sync_db(other_path, core, 1));
+
+  NameList names = {"", 0};
+  CHECK_INT(archium_syncdb_read_all_names(sync, collect_name, &names), 2);
+  CHECK_INT(names.count, 3);
+
+  free(core_path);
+  free(extra_path);
+  free(other_path);
+  free(sync);
+}
+
+int main(void) {
+  char *dir = fixture_dir();
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  test_desc_field();
+  test_gzip_database(dir);
+  test_truncated_database(dir);
+  test_missing_decompressor(dir);
+  test_read_all(dir);
+
+  fixture_remove(dir);
+  free(dir);
+  return test_finish("sync_db");
+}
@@ -0,0 +1,81 @@
+#include <stdatomic.h>
+
+#include "test.h"
+
+#define TASK_COUNT 10000
+#define PACKAGE_COUNT 600
+
+typedef struct {
+  atomic_uint runs[TASK_COUNT];
+  atomic_uint bad_worker;
+  size_t threads;
+} PoolJob;
+
+static void count_run(size_t worker, size_t index, void *user_data) {
+  PoolJob *job = user_data;
+  if (worker >= job->threads) {
+    atomic_fetch_add(&job->bad_worker, 1);
+  }
+  atomic_fetch_add(&job->runs[index], 1);
+}
+
+static void check_pool(size_t threads) {
+  ArchiumThreadPool *pool = threads > 1 ? archium_pool_create(threads) : NULL;
+  static PoolJob job;
+  memset(&job, 0, sizeof(job));
+  job.threads = archium_pool_thread_count(pool);
+  CHECK_INT(job.threads, threads > 1 ? threads : 1);
+
+  for (int round = 0; round < 3; round++) {
+    archium_pool_run(pool, TASK_COUNT, count_run, &job);
+  }
+
+  size_t wrong = 0;
+  for (size_t i = 0; i < TASK_COUNT; i++) {
+    if (atomic_load(&job.runs[i]) != 3) {
+      wrong++;
+    }
+  }
+  CHECK_INT(wrong, 0);
+  CHECK_INT(atomic_load(&job.bad_worker), 0);
+
+  archium_pool_run(pool, 0, count_run, &job);
+  archium_pool_destroy(pool);
+}
+
+static void test_parallel_scan(const char *dir) {
+  char *local = fixture_path(dir, "local");
+  CHECK(mkdir(local, 0755) == 0);
+  CHECK(fixture_generate_packages(local, PACKAGE_COUNT));
+
+  ArchiumLocalDb serial;
+  ArchiumLocalDb parallel;
+  CHECK_INT(archium_localdb_load(&serial, local, 1), 1);
+  CHECK_INT(serial.count, PACKAGE_COUNT);
+
+  for (size_t threads = 2; threads <= 8; threads *= 2) {
+    CHECK_INT(archium_localdb_load(&parallel, local, threads), 1);
+    CHECK(localdb_equal(&serial, &parallel));
+    archium_localdb_free(&parallel);
+  }
+
+  archium_localdb_free(&serial);
+  free(local);
+}
+
+int main(void) {
+  char *dir = fixture_dir();
+  if (!dir) {
+    perror("mkdtemp");
+    return 1;
+  }
+
+  check_pool(1);
+  check_pool(2);
+  check_pool(7);
+  test_parallel_scan(dir);
+
+  fixture_remove(dir);
+  free(dir);
+  return test_finish("thread_pool");
+}